@@ -0,0 +1,91 @@
+#pragma once
+#include <graph_stream.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "futex_word.h"
+
+class UringReader;
+
+/**
+ * Reads a stream in the BinaryFileStream format with asynchronous I/O. A background thread keeps
+ * a large read in flight for each of several buffers, so stream threads copy updates out of
+ * buffers that are already filled while the next blocks of the file are read. Reads are issued
+ * with io_uring when the kernel allows it, and otherwise with pread from the background thread.
+ *
+ * The file is divided into blocks of buffer_updates updates. Block k is read into buffer
+ * k % num_buffers once block k - num_buffers has been completely consumed.
+ */
+class AsyncBinaryStream : public GraphStream {
+ private:
+  static constexpr edge_id_t no_block = (edge_id_t)-1;
+  struct Buffer {
+    char *data = nullptr;
+    std::atomic<edge_id_t> block{no_block};  // the block held by this buffer once it is read
+    std::atomic<edge_id_t> consumed{0};      // number of updates of the block copied out
+    std::atomic<bool> free{true};            // may the I/O thread read a new block into this
+    size_t filled = 0;                       // bytes read so far. Only used by the I/O thread
+    edge_id_t reading_block = 0;             // the block being read. Only used by the I/O thread
+  };
+
+  std::string file_name;
+  int stream_fd;
+  size_t num_buffers;
+  edge_id_t buffer_updates;  // number of updates in a block
+  edge_id_t num_blocks;
+  std::unique_ptr<Buffer[]> buffers;
+  std::unique_ptr<UringReader> uring;
+  std::atomic<bool> uring_enabled{false};  // false if we fall back to pread
+
+  std::atomic<edge_id_t> stream_off{0};  // index of the next unclaimed update
+  std::atomic<edge_id_t> break_index{0};
+
+  std::thread io_thread;
+  std::atomic<bool> stop_io{false};
+  std::atomic<bool> io_error{false};
+  FutexWord ready_word;  // notified when a buffer has been filled
+  FutexWord free_word;   // notified when a buffer has been consumed, or the I/O thread must stop
+
+  static constexpr size_t edge_size = sizeof(GraphStreamUpdate);
+  static constexpr size_t header_size = sizeof(node_id_t) + sizeof(edge_id_t);
+
+  edge_id_t block_length(edge_id_t block) {
+    return std::min(buffer_updates, num_edges - block * buffer_updates);
+  }
+  void start_io(edge_id_t first_update);
+  void end_io();
+  void io_loop(edge_id_t first_block);
+  // read the unfilled part of a buffer. Returns false if the read could not be started.
+  bool read_buffer(size_t buf_idx);
+
+ public:
+  /**
+   * @param file_name      the binary stream to read.
+   * @param num_buffers    [Optional] the maximum number of reads in flight (default = 8).
+   * @param buffer_bytes   [Optional] the size of each read (default = 8 MiB).
+   * @param use_io_uring   [Optional] if false, always use pread (default = true).
+   * @throws StreamException if the file cannot be opened.
+   */
+  AsyncBinaryStream(const std::string &file_name, size_t num_buffers = 8,
+                    size_t buffer_bytes = 8 * 1024 * 1024, bool use_io_uring = true);
+  ~AsyncBinaryStream();
+
+  /**
+   * Copy the next updates of the stream, waiting for them to be read if necessary.
+   * @throws StreamException if a read fails.
+   */
+  size_t get_update_buffer(GraphStreamUpdate *upd_buf, size_t num_updates) override;
+
+  bool get_update_is_thread_safe() override { return true; }
+  // Must not be called while other threads are reading the stream
+  void seek(edge_id_t edge_idx) override;
+  bool set_break_point(edge_id_t break_idx) override;
+  void serialize_metadata(std::ostream &out) override;
+
+  // Are reads issued with io_uring
+  bool using_io_uring() { return uring_enabled; }
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+// Parameters for the Autotuner's calibration runs and the candidates it measures
+class AutotuneConfiguration {
+private:
+  // The threads to split between graph workers and stream threads. 0 uses every hardware thread.
+  size_t _total_threads = 0;
+
+  // The number of stream updates ingested by each calibration run
+  size_t _calibration_updates = 1 << 22;
+
+  // How often each candidate is run. The fastest run is kept, to reduce noise.
+  size_t _repetitions = 1;
+
+  // Candidate batch factors (see CCAlgConfiguration)
+  std::vector<double> _batch_factors = {0.5, 1, 2, 4};
+
+  // Candidate leaf gutter sizes, relative to the batch size the algorithm requests
+  std::vector<double> _gutter_scales = {0.5, 1, 2};
+
+  // Seed of the sketches and of synthetic calibration streams
+  size_t _seed = 0;
+
+  // Only measure candidates whose estimated memory fits in this many bytes. 0 for no limit.
+  size_t _memory_budget = 0;
+
+  friend class Autotuner;
+
+public:
+  AutotuneConfiguration() {};
+
+  // setters
+  AutotuneConfiguration& total_threads(size_t num_threads);
+  AutotuneConfiguration& calibration_updates(size_t num_updates);
+  AutotuneConfiguration& repetitions(size_t repetitions);
+  AutotuneConfiguration& batch_factors(std::vector<double> factors);
+  AutotuneConfiguration& gutter_scales(std::vector<double> scales);
+  AutotuneConfiguration& seed(size_t seed);
+  AutotuneConfiguration& memory_budget(size_t budget_bytes);
+
+  // getters
+  size_t get_total_threads();
+  size_t get_calibration_updates() { return _calibration_updates; }
+  size_t get_repetitions() { return _repetitions; }
+  std::vector<double> get_batch_factors() { return _batch_factors; }
+  std::vector<double> get_gutter_scales() { return _gutter_scales; }
+  size_t get_seed() { return _seed; }
+  size_t get_memory_budget() { return _memory_budget; }
+
+  friend std::ostream& operator<< (std::ostream &out, const AutotuneConfiguration &conf);
+
+  // no use of equal operator
+  AutotuneConfiguration& operator=(const AutotuneConfiguration &) = delete;
+
+  // moving and copying allowed
+  AutotuneConfiguration(const AutotuneConfiguration &oth) = default;
+  AutotuneConfiguration (AutotuneConfiguration &&) = default;
+};
@@ -0,0 +1,87 @@
+#pragma once
+#include <graph_stream.h>
+
+#include <iostream>
+#include <vector>
+
+#include "autotune_configuration.h"
+#include "cc_alg_configuration.h"
+#include "driver_configuration.h"
+
+// One calibration run of the Autotuner
+struct AutotuneTrial {
+  size_t worker_threads;
+  size_t stream_threads;
+  double batch_factor;
+  double gutter_scale;        // leaf gutter size relative to the batch size
+  size_t gutter_bytes;
+  double updates_per_second;  // the fastest of the repetitions
+};
+
+// The configuration the Autotuner found fastest, and every run it measured
+struct AutotuneResult {
+  DriverConfiguration driver_config;
+  CCAlgConfiguration alg_config;
+  size_t stream_threads;
+  AutotuneTrial best;
+  std::vector<AutotuneTrial> trials;
+
+  friend std::ostream& operator<< (std::ostream &out, const AutotuneResult &result);
+};
+
+/**
+ * Picks the batch factor, leaf gutter size and split of threads between graph workers and stream
+ * threads that ingest fastest on this machine, for the connected components algorithm.
+ *
+ * Neither the batch factor nor the gutters can change once a driver is constructed, so each
+ * candidate is measured by a calibration run that constructs its own algorithm and driver and
+ * ingests a calibration stream held in memory, up to and including the flush of prep_query().
+ * The calibration stream is either the beginning of the stream to be processed or a synthetic
+ * Erdos-Renyi stream over the same vertices, since the sketch size depends only on the number of
+ * vertices. The parameters are tuned one at a time: first the thread split, then the batch
+ * factor, then the gutter size, each keeping the best of those tuned before. With a memory budget,
+ * the guttering system is chosen by MemoryBudget::plan() and candidates whose estimated memory
+ * exceeds the budget are not measured.
+ *
+ * Every calibration run allocates the sketches of every vertex, so for large graphs each run
+ * takes as long as allocating the sketches and the calibration stream should be large enough to
+ * amortize this.
+ */
+class Autotuner {
+ private:
+  AutotuneConfiguration config;
+
+  // Measure the throughput of the trial's parameters and set its gutter_bytes
+  void run_trial(node_id_t num_vertices, const std::vector<GraphStreamUpdate> &updates,
+                 const DriverConfiguration &base_driver_config,
+                 const CCAlgConfiguration &base_alg_config, AutotuneTrial &trial);
+
+  AutotuneResult tune_updates(node_id_t num_vertices,
+                              const std::vector<GraphStreamUpdate> &updates,
+                              const DriverConfiguration &base_driver_config,
+                              const CCAlgConfiguration &base_alg_config);
+
+ public:
+  Autotuner(AutotuneConfiguration config = AutotuneConfiguration());
+
+  /**
+   * Calibrate on the first updates of the stream, then seek the stream back to its beginning.
+   * Streams that cannot seek backwards, like a RingBufferStream, lose the calibration updates
+   * and throw StreamException, so tune those with tune_synthetic().
+   * @param base_driver_config  the configuration to tune, for example the guttering system. Its
+   *                            worker threads and gutter bytes are replaced.
+   * @param base_alg_config     the configuration to tune, for example the merge mode. Its batch
+   *                            factor is replaced.
+   */
+  AutotuneResult tune(GraphStream &stream,
+                      const DriverConfiguration &base_driver_config = DriverConfiguration(),
+                      const CCAlgConfiguration &base_alg_config = CCAlgConfiguration());
+
+  // Calibrate on a synthetic stream over num_vertices vertices
+  AutotuneResult tune_synthetic(
+      node_id_t num_vertices, const DriverConfiguration &base_driver_config = DriverConfiguration(),
+      const CCAlgConfiguration &base_alg_config = CCAlgConfiguration());
+
+  // The splits of the threads into (graph workers, stream threads) the Autotuner measures
+  static std::vector<std::pair<size_t, size_t>> thread_splits(size_t total_threads);
+};
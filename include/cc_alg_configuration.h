@@ -1,5 +1,11 @@
 #pragma once
 
+// How Boruvka's algorithm builds the sketch of each supernode
+enum BoruvkaMergeMode {
+  REMERGE_CHILDREN, // every round, rebuild each supernode by merging all of its vertices
+  IN_PLACE_MERGE,   // merge vertices into the root sketch once, when they join the supernode
+};
+
 // Graph parameters
 class CCAlgConfiguration {
 private:
@@ -14,6 +20,12 @@ private:
   // Size of update batches as relative to the size of a Supernode
   double _batch_factor = 1;
 
+  // How supernode sketches are constructed during Boruvka
+  BoruvkaMergeMode _merge_mode = REMERGE_CHILDREN;
+
+  // If true, each supernode adds every edge its sample recovers to the DSU, not just one
+  bool _exhaustive_sampling = false;
+
   friend class CCSketchAlg;
   friend class MCSketchAlg;
 
@@ -24,11 +36,15 @@ public:
   CCAlgConfiguration& disk_dir(std::string disk_dir);
   CCAlgConfiguration& sketches_factor(double factor);
   CCAlgConfiguration& batch_factor(double factor);
+  CCAlgConfiguration& merge_mode(BoruvkaMergeMode mode);
+  CCAlgConfiguration& exhaustive_sampling(bool exhaustive);
 
   // getters
   std::string get_disk_dir() { return _disk_dir; }
   double get_sketches_factor() { return _sketches_factor; }
   double get_batch_factor() { return _batch_factor; }
+  BoruvkaMergeMode get_merge_mode() { return _merge_mode; }
+  bool get_exhaustive_sampling() { return _exhaustive_sampling; }
 
   friend std::ostream& operator<< (std::ostream &out, const CCAlgConfiguration &conf);
 
@@ -14,8 +14,11 @@
 
 #include "cc_alg_configuration.h"
 #include "return_types.h"
+#include "runtime_stats.h"
 #include "sketch.h"
 #include "dsu.h"
+#include "numa_topology.h"
+#include "task_pool.h"
 
 #ifdef VERIFY_SAMPLES_F
 #include "test/graph_verifier.h"
@@ -74,6 +77,10 @@ class CCSketchAlg {
   // a set containing one "representative" from each supernode
   std::set<node_id_t> *representatives;
   Sketch **sketches;
+  // the buckets of the vertex sketches in one page aligned allocation so their placement across
+  // NUMA nodes can be controlled. nullptr if the buckets are provided by the caller (CUDA).
+  Bucket *sketch_arena = nullptr;
+  size_t sketch_arena_bytes = 0;
   // DSU representation of supernode relationship
   DisjointSetUnion_MT<node_id_t> dsu;
 
@@ -90,8 +97,29 @@ class CCSketchAlg {
   // threads use these sketches to apply delta updates to our sketches
   Sketch **delta_sketches = nullptr;
   size_t num_delta_sketches;
+  // buckets of the delta sketches. Each delta sketch begins on its own page.
+  Bucket *delta_arena = nullptr;
+  size_t delta_stride_bytes = 0;
+
+  // allocate the sketch arena and construct the vertex sketches within it
+  void allocate_sketch_arena(vec_t sketch_vec_len, size_t sketch_num_samples);
 
   CCAlgConfiguration config;
+
+  // threads that run the parallel portions of queries. The driver's workers, if given any.
+  OmpTaskPool omp_pool;
+  TaskPool *task_pool = &omp_pool;
+
+  // the results of sampling supernodes during the current Boruvka round, indexed by SampleResult
+  StripedCounters<3> sample_counts;
+  QueryStats query_stats;
+  std::mutex query_stats_mtx;  // protects query_stats
+
+  // The stats of a Boruvka round that just finished. Resets the sample counts for the next one.
+  QueryRoundStats take_round_stats(double seconds);
+
+  // Record the stats of a query that just finished
+  void publish_query_stats(std::vector<QueryRoundStats> &&round_stats);
 #ifdef VERIFY_SAMPLES_F
   std::unique_ptr<GraphVerifier> verifier;
 #endif
@@ -110,6 +138,22 @@ class CCSketchAlg {
    */
   bool sample_supernode(Sketch &skt);
 
+  /**
+   * Sample a single supernode and add every edge the sample recovers, not just the first.
+   * Used when the configuration enables exhaustive sampling.
+   * @param skt   sketch to sample
+   * @return      [bool] true if the query result indicates we should run an additional round.
+   */
+  bool exhaustive_sample_supernode(Sketch &skt);
+
+  /**
+   * Merge the endpoints of a sampled edge in the dsu. If this joins two supernodes the edge is
+   * added to the spanning forest.
+   * @param e   the sampled edge
+   * @return    [bool] true if the edge joined two supernodes.
+   */
+  bool merge_sampled_edge(Edge e);
+
   /**
    * Calculate the instructions for what vertices to merge to form each component
    */
@@ -128,6 +172,30 @@ class CCSketchAlg {
    */
   void boruvka_emulation();
 
+  /**
+   * Sample the sketch of every supernode root. Used by the in-place Boruvka variant where the
+   * sketch of each root already represents its entire supernode.
+   * @param roots  the current supernode roots
+   * @return       true if the query results indicate we should run an additional round.
+   */
+  bool sample_roots(const std::vector<node_id_t> &roots);
+
+  /**
+   * Merge the sketch of each child into the sketch of its root. Only the deterministic bucket
+   * and the samples in [first_sample, num_samples) are merged. Because merging is an XOR,
+   * applying the same merges a second time restores the root sketches.
+   * @param first_sample  the first sample that will be queried after this merge
+   * @param merges        the (root, child) pairs to merge, sorted by root
+   */
+  void apply_root_merges(size_t first_sample, const std::vector<MergeInstr> &merges);
+
+  /**
+   * Boruvka variant that merges supernodes into the sketch of their root when they join instead
+   * of rebuilding each supernode from its vertices every round. The merges are undone before
+   * returning so the vertex sketches are left unmodified.
+   */
+  void in_place_boruvka_emulation();
+
   // constructor for use when reading from a serialized file
   CCSketchAlg(node_id_t num_vertices, size_t seed, std::ifstream &binary_stream,
               CCAlgConfiguration config);
@@ -156,19 +224,47 @@ class CCSketchAlg {
    */
   void pre_insert(GraphUpdate upd, int thr_id = 0);
 
+  /**
+   * Equivalent to calling pre_insert() on each update. Once the eager dsu is invalidated, the
+   * rest of the updates are skipped.
+   */
+  void pre_insert_batch(const GraphUpdate *upds, size_t num_upds, int thr_id = 0) {
+    for (size_t i = 0; i < num_upds && dsu_valid; i++) pre_insert(upds[i], thr_id);
+  }
+
   /**
    * Allocate memory for the worker threads to use when updating this algorithm's sketches
    */
   void allocate_worker_memory(size_t num_workers) {
+    vec_t sketch_vec_len = Sketch::calc_vector_length(num_vertices);
+    size_t sketch_num_samples = Sketch::calc_cc_samples(num_vertices, config.get_sketches_factor());
+    size_t page = NumaTopology::page_size();
+    size_t delta_bytes = Sketch::calc_num_buckets(sketch_vec_len, sketch_num_samples) * sizeof(Bucket);
+    delta_stride_bytes = (delta_bytes + page - 1) / page * page;
+
     num_delta_sketches = num_workers;
+    delta_arena = (Bucket *)NumaTopology::allocate_pages(delta_stride_bytes * num_workers);
     delta_sketches = new Sketch *[num_delta_sketches];
     for (size_t i = 0; i < num_delta_sketches; i++) {
-      delta_sketches[i] =
-          new Sketch(Sketch::calc_vector_length(num_vertices), seed,
-                     Sketch::calc_cc_samples(num_vertices, config.get_sketches_factor()));
+      Bucket *buckets = (Bucket *)((char *)delta_arena + i * delta_stride_bytes);
+      delta_sketches[i] = new Sketch(sketch_vec_len, seed, 0, buckets, sketch_num_samples);
     }
   }
 
+  /**
+   * Place our sketches across the NUMA nodes of the machine as requested by the driver.
+   * With PARTITION placement, the vertices are divided into contiguous ranges, one per node.
+   */
+  void apply_numa_policy(const NumaPolicy &policy);
+
+  /**
+   * Set the threads used to run queries. If nullptr, queries run in OpenMP parallel regions.
+   * The driver gives us its worker threads so they perform both updates and queries. A query
+   * made without the driver's prep_query() finds the workers busy ingesting, so it runs in
+   * OpenMP parallel regions of as many threads as there are workers instead.
+   */
+  void set_task_pool(TaskPool *pool) { task_pool = pool == nullptr ? &omp_pool : pool; }
+
   /**
    * Update all the sketches for a node, given a batch of updates.
    * @param thr_id         The id of the thread performing the update [0, num_threads)
@@ -252,6 +348,20 @@ class CCSketchAlg {
   std::chrono::steady_clock::time_point cc_alg_start;
   std::chrono::steady_clock::time_point cc_alg_end;
   size_t last_query_rounds = 0;
+  std::vector<double> last_query_round_times; // seconds spent in each Boruvka round
+  // seconds of each Boruvka round spent in create_merge_instructions(). Empty for IN_PLACE_MERGE.
+  std::vector<double> last_query_merge_instr_times;
+  double last_cc_build_time = 0; // seconds spent constructing the last ConnectedComponents
+  double last_sf_build_time = 0; // seconds spent constructing the last SpanningForest
+
+  /**
+   * The queries answered by running Boruvka and the rounds and sample results of the last one.
+   * Safe to call at any time, including during a query, which reports the previous query.
+   */
+  QueryStats get_query_stats() {
+    std::lock_guard<std::mutex> lk(query_stats_mtx);
+    return query_stats;
+  }
 
   // getters
   inline node_id_t get_num_vertices() { return num_vertices; }
@@ -0,0 +1,107 @@
+#pragma once
+#include <graph_stream.h>
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * A compressed binary stream. Updates are grouped into fixed size blocks and each block is
+ * encoded independently, so threads decode different blocks of the stream in parallel.
+ *
+ * File format:
+ *    node_id_t num_vertices
+ *    edge_id_t num_edges       number of updates in the stream
+ *    uint32_t  block_updates   number of updates in each block, except the last
+ *    uint64_t  index_offset    byte offset of the block index
+ *    blocks
+ *    padding to a multiple of 8 bytes
+ *    uint64_t  block_offsets[num_blocks + 1]   the last entry is index_offset
+ *
+ * Each update of a block is encoded as two varints. With lo = min(src, dst), hi = max(src, dst):
+ *    (zigzag(lo - previous lo) << 2) | (src > dst) << 1 | type
+ *    hi - lo
+ * The previous lo is 0 at the start of every block.
+ */
+class CompressedBinaryStream : public GraphStream {
+ private:
+  std::string file_name;
+  int stream_fd;
+  const char *mapping = nullptr;
+  size_t file_bytes;
+  edge_id_t block_updates;
+  edge_id_t num_blocks;
+  const uint64_t *block_offsets;  // the block index, in the mapping
+
+  std::atomic<edge_id_t> stream_off{0};  // index of the next unclaimed update
+  std::atomic<edge_id_t> break_index{0};
+
+  // decode count updates of a block, after skipping the first skip updates
+  void decode_block(edge_id_t block, edge_id_t skip, edge_id_t count, GraphStreamUpdate *out);
+
+ public:
+  static constexpr size_t header_size =
+      sizeof(node_id_t) + sizeof(edge_id_t) + sizeof(uint32_t) + sizeof(uint64_t);
+
+  /**
+   * @param file_name  the compressed stream to read.
+   * @throws StreamException if the file cannot be opened or is malformed.
+   */
+  CompressedBinaryStream(const std::string &file_name);
+  ~CompressedBinaryStream();
+
+  /**
+   * Decode the next updates of the stream. This function is thread-safe, and threads decode
+   * different blocks in parallel. Claims end on a block boundary where possible, so num_updates
+   * should be at least block_size() to avoid decoding a block more than once.
+   * @throws StreamException if a block is malformed.
+   */
+  size_t get_update_buffer(GraphStreamUpdate *upd_buf, size_t num_updates) override;
+
+  bool get_update_is_thread_safe() override { return true; }
+  void seek(edge_id_t edge_idx) override { stream_off = std::min(edge_idx, num_edges); }
+  bool set_break_point(edge_id_t break_idx) override;
+  void serialize_metadata(std::ostream &out) override;
+
+  edge_id_t block_size() { return block_updates; }
+};
+
+/**
+ * Writes a compressed stream, see CompressedBinaryStream for the format. Full blocks are encoded
+ * in parallel.
+ */
+class CompressedStreamWriter {
+ private:
+  std::ofstream out;
+  node_id_t num_vertices;
+  edge_id_t num_updates = 0;
+  uint32_t block_updates;
+  std::vector<GraphStreamUpdate> pending;  // updates that have not been encoded
+  std::vector<uint64_t> block_offsets;
+  uint64_t write_offset;
+
+  // number of full blocks to collect before encoding them together
+  static constexpr size_t encode_batch_blocks = 256;
+
+  // encode and write the pending updates. If flush is false, only full blocks are written.
+  void write_blocks(bool flush);
+
+ public:
+  // the driver reads 4000 updates at a time, so by default every read decodes a whole block
+  static constexpr uint32_t default_block_updates = 4000;
+
+  /**
+   * @param block_updates  [Optional] the number of updates in each block.
+   * @throws StreamException if the file cannot be opened.
+   */
+  CompressedStreamWriter(const std::string &file_name, node_id_t num_vertices,
+                         uint32_t block_updates = default_block_updates);
+  ~CompressedStreamWriter();  // writes the last block, the index and the header
+
+  /**
+   * @throws StreamException if an update is not an INSERT or DELETE.
+   */
+  void write_updates(const GraphStreamUpdate *updates, size_t num);
+};
@@ -2,6 +2,8 @@
 
 #include <guttering_configuration.h>
 
+#include "numa_topology.h"
+
 enum GutterSystem {
   GUTTERTREE,
   STANDALONE,
@@ -23,6 +25,27 @@ private:
   // Configuration for the guttering system
   GutteringConfiguration _gutter_conf;
 
+  // Pin each worker and stream thread to its own CPU, spreading them across the NUMA nodes
+  bool _pin_threads = false;
+
+  // How to place the algorithm's sketches across the NUMA nodes
+  SketchPlacement _sketch_placement = FIRST_TOUCH;
+
+  // Place the scratch memory of each worker on the worker's NUMA node. Requires pinned threads.
+  bool _local_worker_memory = false;
+
+  // Divide the vertices among the NUMA nodes. Each node has its own guttering system and workers
+  // that only update the sketches of its vertices. Implies pinned threads, PARTITION sketch
+  // placement, and local worker memory.
+  bool _partition_ingestion = false;
+
+  // Size of the window each stream thread uses to cancel insertions and deletions of the same
+  // edge before they are guttered. 0 disables cancellation.
+  size_t _cancellation_window = 0;
+
+  // Do not print the driver and algorithm configurations when the driver is constructed
+  bool _quiet = false;
+
 public:
   DriverConfiguration() {};
 
@@ -31,11 +54,23 @@ public:
   DriverConfiguration& disk_dir(std::string disk_dir);
   DriverConfiguration& worker_threads(size_t num_groups);
   GutteringConfiguration& gutter_conf();
+  DriverConfiguration& pin_threads(bool pin_threads);
+  DriverConfiguration& sketch_placement(SketchPlacement sketch_placement);
+  DriverConfiguration& local_worker_memory(bool local_worker_memory);
+  DriverConfiguration& partition_ingestion(bool partition_ingestion);
+  DriverConfiguration& cancellation_window(size_t cancellation_window);
+  DriverConfiguration& quiet(bool quiet);
 
   // getters
   GutterSystem get_gutter_sys() { return _gutter_sys; }
   std::string get_disk_dir() { return _disk_dir; }
   size_t get_worker_threads() { return _num_worker_threads; }
+  bool get_pin_threads() { return _pin_threads; }
+  SketchPlacement get_sketch_placement() { return _sketch_placement; }
+  bool get_local_worker_memory() { return _local_worker_memory; }
+  bool get_partition_ingestion() { return _partition_ingestion; }
+  size_t get_cancellation_window() { return _cancellation_window; }
+  bool get_quiet() { return _quiet; }
 
   friend std::ostream& operator<< (std::ostream &out, const DriverConfiguration &conf);
 
@@ -0,0 +1,52 @@
+#pragma once
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <thread>
+
+/**
+ * A 32 bit word that threads may sleep on until another thread changes it. Sleeping and waking
+ * use the futex system call, so a sleeping thread is woken as soon as the word changes and
+ * notifying costs no system call when nobody is asleep.
+ */
+class FutexWord {
+ private:
+  std::atomic<uint32_t> word{0};
+  std::atomic<uint32_t> num_sleeping{0};
+  static constexpr size_t spin_yields = 128;
+  static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+                "futex requires a lock free 32 bit atomic");
+
+  long futex(int op, uint32_t val) {
+    return syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), op, val, nullptr, nullptr, 0);
+  }
+
+ public:
+  // The current value of the word. Read this before checking the condition you wait on.
+  uint32_t load() const { return word.load(); }
+
+  /**
+   * Sleep until the word no longer equals expected. May return spuriously, so callers should
+   * recheck their condition.
+   */
+  void wait(uint32_t expected) {
+    // the word usually changes soon, so yield to the thread that will change it before sleeping
+    for (size_t i = 0; i < spin_yields; i++) {
+      if (word.load() != expected) return;
+      std::this_thread::yield();
+    }
+    ++num_sleeping;
+    futex(FUTEX_WAIT_PRIVATE, expected);
+    --num_sleeping;
+  }
+
+  // Change the word and wake every thread sleeping on it
+  void notify_all() {
+    ++word;
+    if (num_sleeping > 0) futex(FUTEX_WAKE_PRIVATE, INT_MAX);
+  }
+};
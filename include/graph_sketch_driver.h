@@ -3,8 +3,18 @@
 #include <gutter_tree.h>
 #include <standalone_gutters.h>
 
+#include <exception>
+#include <memory>
+#include <type_traits>
+
 #include "driver_configuration.h"
 #include "graph_stream.h"
+#include "grouped_stream.h"
+#include "mmap_binary_stream.h"
+#include "perf_counters.h"
+#include "runtime_stats.h"
+#include "tracer.h"
+#include "update_cancellation_cache.h"
 #include "worker_thread_group.h"
 #ifdef VERIFY_SAMPLES_F
 #include "graph_verifier.h"
@@ -20,6 +30,39 @@ class DriverException : public std::exception {
   }
 };
 
+// Detects if an algorithm implements the optional set_task_pool() function
+template <class Alg, class = void>
+struct accepts_task_pool : std::false_type {};
+template <class Alg>
+struct accepts_task_pool<
+    Alg, std::void_t<decltype(std::declval<Alg &>().set_task_pool(std::declval<TaskPool *>()))>>
+    : std::true_type {};
+
+// Detects if an algorithm implements the optional apply_numa_policy() function
+template <class Alg, class = void>
+struct accepts_numa_policy : std::false_type {};
+template <class Alg>
+struct accepts_numa_policy<
+    Alg, std::void_t<decltype(std::declval<Alg &>().apply_numa_policy(std::declval<NumaPolicy>()))>>
+    : std::true_type {};
+
+// Detects if an algorithm implements the optional pre_insert_batch() function
+template <class Alg, class = void>
+struct accepts_pre_insert_batch : std::false_type {};
+template <class Alg>
+struct accepts_pre_insert_batch<
+    Alg, std::void_t<decltype(std::declval<Alg &>().pre_insert_batch(
+             std::declval<const GraphUpdate *>(), std::declval<size_t>(), std::declval<int>()))>>
+    : std::true_type {};
+
+// Detects if an algorithm implements the optional get_query_stats() function
+template <class Alg, class = void>
+struct reports_query_stats : std::false_type {};
+template <class Alg>
+struct reports_query_stats<Alg,
+                           std::void_t<decltype(std::declval<Alg &>().get_query_stats())>>
+    : std::true_type {};
+
 /**
  * GraphSketchDriver class:
  * Driver for sketching algorithms on a single machine.
@@ -66,11 +109,38 @@ class DriverException : public std::exception {
  *          verifier. The verifier encodes the graph state at the time of a query losslessly
  *          and should be used by the algorithm to check its query answer. This is only used for
  *          correctness testing, not for production code.
+ *
+ *    9) void set_task_pool(TaskPool *pool)                                              [optional]
+ *          If implemented, the driver provides the algorithm with its worker threads as a
+ *          TaskPool. The algorithm should use this pool to parallelize its queries so that the
+ *          same threads perform updates and queries. The pool only runs tasks on the workers after
+ *          prep_query(). The driver sets the pool to nullptr when it is destroyed.
+ *
+ *   10) void apply_numa_policy(const NumaPolicy &policy)                                [optional]
+ *          If implemented, and the configuration requests a sketch placement other than
+ *          FIRST_TOUCH or local worker memory, the driver calls this function after creating its
+ *          worker threads. The algorithm should place its sketches and the scratch memory of each
+ *          worker across the NUMA nodes of the machine as requested.
+ *
+ *   11) void pre_insert_batch(const GraphUpdate *upds, size_t num_upds, int thr_id)     [optional]
+ *          If implemented, stream threads call this function once per buffer of updates instead
+ *          of calling pre_insert() for each update. It must be equivalent to calling pre_insert()
+ *          on each update in order.
+ *
+ *   12) QueryStats get_query_stats()                                                    [optional]
+ *          If implemented, the driver includes the returned stats of the algorithm's queries in
+ *          the snapshots returned by get_stats(). It may be called at any time by any thread.
  */
 template <class Alg>
 class GraphSketchDriver {
  private:
-  GutteringSystem *gts;
+  // The vertices are divided into contiguous partitions, each with its own guttering system. The
+  // gutters of a partition are indexed by vertex id minus the first vertex of the partition.
+  // Without partitioned ingestion there is a single partition holding every vertex.
+  std::vector<GutteringSystem *> gts;
+  std::vector<node_id_t> partition_first;  // first vertex of each partition
+  size_t num_partitions;
+  GutterSystem gutter_sys;
   Alg *sketching_alg;
   GraphStream *stream;
 #ifdef VERIFY_SAMPLES_F
@@ -81,13 +151,53 @@ class GraphSketchDriver {
   WorkerThreadGroup<Alg> *worker_threads;
 
   size_t num_stream_threads;
+  NumaTopology topology;
+  bool pin_threads;
   static constexpr size_t update_array_size = 4000;
 
   std::atomic<size_t> total_updates;
+
+  // number of slots in each stream thread's UpdateCancellationCache. 0 if disabled
+  size_t cancellation_window;
+  std::atomic<size_t> cancelled_updates;  // stream updates dropped by the caches
+
+  // Counters of each worker thread for get_stats(). Each worker increments its own.
+  struct alignas(64) WorkerCounters {
+    std::atomic<uint64_t> batches;
+    std::atomic<uint64_t> updates;
+    std::atomic<uint64_t> batch_sizes[RuntimeStats::histogram_buckets];
+  };
+  std::unique_ptr<WorkerCounters[]> worker_counters;
+  size_t num_workers;
+  std::atomic<size_t> ingested_updates;  // stream updates inserted to the gutters
+  std::atomic<size_t> grouped_updates;   // updates of grouped streams, which bypass the gutters
+  std::atomic<uint64_t> num_flushes;
+  std::atomic<uint64_t> last_flush_ns;
+  std::atomic<uint64_t> total_flush_ns;
+  std::chrono::steady_clock::time_point construct_time;
  public:
   GraphSketchDriver(Alg *sketching_alg, GraphStream *stream, DriverConfiguration config,
                     size_t num_stream_threads = 1)
-      : sketching_alg(sketching_alg), stream(stream), num_stream_threads(num_stream_threads) {
+      : sketching_alg(sketching_alg),
+        stream(stream),
+        num_stream_threads(num_stream_threads),
+        pin_threads(config.get_pin_threads()) {
+    gutter_sys = config.get_gutter_sys();
+    cancellation_window = config.get_cancellation_window();
+    if (config.get_partition_ingestion()) {
+      // each NUMA node owns a partition of the vertices and the workers pinned to that node
+      num_partitions = topology.num_nodes();
+      if (config.get_worker_threads() < num_partitions) {
+        std::cerr << "WARNING: Partitioned ingestion requires a worker per NUMA node. Using "
+                  << num_partitions << " workers" << std::endl;
+        config.worker_threads(num_partitions);
+      }
+      config.pin_threads(true).sketch_placement(PARTITION).local_worker_memory(true);
+      pin_threads = true;
+    } else {
+      num_partitions = 1;
+    }
+
     sketching_alg->allocate_worker_memory(config.get_worker_threads());
     // set the leaf size of the guttering system appropriately
     if (config.gutter_conf().get_gutter_bytes() == GutteringConfiguration::uninit_param) {
@@ -95,20 +205,42 @@ class GraphSketchDriver {
                                         sizeof(node_id_t));
     }
 
-    std::cout << config << std::endl;
-    // Create the guttering system
-    if (config.get_gutter_sys() == GUTTERTREE)
-      gts = new GutterTree(config.get_disk_dir() + "/", sketching_alg->get_num_vertices(),
-                           config.get_worker_threads(), config.gutter_conf(), true);
-    else if (config.get_gutter_sys() == STANDALONE)
-      gts = new StandAloneGutters(sketching_alg->get_num_vertices(), config.get_worker_threads(),
-                                  num_stream_threads, config.gutter_conf());
-    else
-      gts = new CacheGuttering(sketching_alg->get_num_vertices(), config.get_worker_threads(),
-                               num_stream_threads, config.gutter_conf());
+    if (!config.get_quiet()) std::cout << config << std::endl;
+    // Create a guttering system for each partition. Worker i works on partition
+    // i % num_partitions, which matches the NUMA node it is pinned to.
+    node_id_t num_vertices = sketching_alg->get_num_vertices();
+    for (size_t p = 0; p < num_partitions; p++) {
+      node_id_t first = NumaTopology::partition_begin(p, num_vertices, num_partitions);
+      node_id_t part_vertices =
+          NumaTopology::partition_begin(p + 1, num_vertices, num_partitions) - first;
+      size_t part_workers = (config.get_worker_threads() - p + num_partitions - 1) / num_partitions;
+      std::string disk_dir = config.get_disk_dir() + "/";
+      if (num_partitions > 1) disk_dir += "partition" + std::to_string(p) + "_";
+
+      partition_first.push_back(first);
+      if (config.get_gutter_sys() == GUTTERTREE)
+        gts.push_back(new GutterTree(disk_dir, part_vertices, part_workers, config.gutter_conf(),
+                                     true));
+      else if (config.get_gutter_sys() == STANDALONE)
+        gts.push_back(new StandAloneGutters(part_vertices, part_workers, num_stream_threads,
+                                            config.gutter_conf()));
+      else
+        gts.push_back(new CacheGuttering(part_vertices, part_workers, num_stream_threads,
+                                         config.gutter_conf()));
+    }
 
-    worker_threads = new WorkerThreadGroup<Alg>(config.get_worker_threads(), this, gts);
-    sketching_alg->print_configuration();
+    // large batches are split among idle workers, but not so finely that applying each portion
+    // is dominated by the cost of merging its delta sketch
+    num_workers = config.get_worker_threads();
+    worker_counters.reset(new WorkerCounters[num_workers]());
+    worker_threads = new WorkerThreadGroup<Alg>(config.get_worker_threads(), this, gts,
+                                                partition_first,
+                                                sketching_alg->get_desired_updates_per_batch() / 4);
+    if constexpr (accepts_task_pool<Alg>::value) sketching_alg->set_task_pool(worker_threads);
+    if (pin_threads && !worker_threads->pin_workers(topology))
+      std::cerr << "WARNING: Could not pin worker threads to CPUs" << std::endl;
+    place_memory(config);
+    if (!config.get_quiet()) sketching_alg->print_configuration();
 
     if (num_stream_threads > 1 && !stream->get_update_is_thread_safe()) {
       std::cerr
@@ -121,12 +253,42 @@ class GraphSketchDriver {
 #endif
 
     total_updates = 0;
-    std::cout << std::endl;
+    cancelled_updates = 0;
+    ingested_updates = 0;
+    grouped_updates = 0;
+    num_flushes = 0;
+    last_flush_ns = 0;
+    total_flush_ns = 0;
+    construct_time = std::chrono::steady_clock::now();
+    if (!config.get_quiet()) std::cout << std::endl;
+  }
+
+  /**
+   * Ask the algorithm to place its memory across the NUMA nodes of the machine, if the
+   * configuration requests it.
+   */
+  void place_memory(DriverConfiguration &config) {
+    if (config.get_sketch_placement() == FIRST_TOUCH && !config.get_local_worker_memory()) return;
+
+    NumaPolicy policy{&topology, config.get_sketch_placement(), config.get_local_worker_memory(),
+                      {}};
+    if (policy.local_worker_memory && !pin_threads) {
+      std::cerr << "WARNING: Local worker memory requires pinned threads. Ignoring." << std::endl;
+      policy.local_worker_memory = false;
+    }
+    for (size_t i = 0; i < config.get_worker_threads(); i++)
+      policy.worker_nodes.push_back(topology.node_for_thread(i));
+
+    if constexpr (accepts_numa_policy<Alg>::value)
+      sketching_alg->apply_numa_policy(policy);
+    else
+      std::cerr << "WARNING: Algorithm does not support NUMA placement. Ignoring." << std::endl;
   }
 
   ~GraphSketchDriver() {
+    if constexpr (accepts_task_pool<Alg>::value) sketching_alg->set_task_pool(nullptr);
     delete worker_threads;
-    delete gts;
+    for (GutteringSystem *partition : gts) delete partition;
 #ifdef VERIFY_SAMPLES_F
     delete verifier;
 #endif
@@ -145,41 +307,94 @@ class GraphSketchDriver {
     }
     worker_threads->resume_workers();
 
+    ZeroCopyStream *zero_copy_stream = dynamic_cast<ZeroCopyStream *>(stream);
     auto task = [&](int thr_id) {
+      Tracer::set_thread_name("stream " + std::to_string(thr_id));
       GraphStreamUpdate update_array[update_array_size];
+      // the updates taken from update_array and the gutter insertions they produce. Each buffer
+      // is handed to the algorithm and guttering systems in a single call.
+      std::vector<GraphUpdate> upd_buffer;
+      std::vector<update_t> gutter_buffer;
+      upd_buffer.reserve(update_array_size);
+      gutter_buffer.reserve(2 * update_array_size);
+      auto add_update = [&](const GraphUpdate &upd) {
+        upd_buffer.push_back(upd);
+        gutter_buffer.push_back({upd.edge.src, upd.edge.dst});
+        gutter_buffer.push_back({upd.edge.dst, upd.edge.src});
+      };
+      std::unique_ptr<UpdateCancellationCache> cancel_cache;
+      if (cancellation_window > 0)
+        cancel_cache = std::make_unique<UpdateCancellationCache>(cancellation_window);
 #ifdef VERIFY_SAMPLES_F
       GraphVerifier local_verifier(sketching_alg->get_num_vertices());
 #endif
 
       while (true) {
-        size_t updates = stream->get_update_buffer(update_array, update_array_size);
+        // streams that support it are parsed in place, others are copied into update_array
+        const GraphStreamUpdate *stream_updates = update_array;
+        size_t updates;
+        bool reached_breakpoint = false;
+        {
+          PerfScope scope(PERF_STREAM_READ);
+          TraceScope trace(TRACE_STREAM_READ);
+          if (zero_copy_stream != nullptr) {
+            updates = zero_copy_stream->get_update_view(stream_updates, update_array_size);
+            reached_breakpoint = updates == 0;
+          } else {
+            updates = stream->get_update_buffer(update_array, update_array_size);
+          }
+          trace.set_arg(updates);
+        }
+        upd_buffer.clear();
+        gutter_buffer.clear();
         for (size_t i = 0; i < updates; i++) {
           GraphUpdate upd;
-          upd.edge = update_array[i].edge;
-          upd.type = static_cast<UpdateType>(update_array[i].type);
+          upd.edge = stream_updates[i].edge;
+          upd.type = static_cast<UpdateType>(stream_updates[i].type);
           if (upd.type == BREAKPOINT) {
-            // reached the breakpoint. Update verifier if applicable and return
+            reached_breakpoint = true;
+            break;
+          }
+          if (cancel_cache)
+            cancel_cache->insert(upd, add_update);
+          else
+            add_update(upd);
 #ifdef VERIFY_SAMPLES_F
-            std::lock_guard<std::mutex> lk(verifier_mtx);
-            verifier->combine(local_verifier);
+          local_verifier.edge_update(upd.edge);
 #endif
-            return;
-          }
-          else {
-            sketching_alg->pre_insert(upd, thr_id);
-            Edge edge = upd.edge;
-            gts->insert({edge.src, edge.dst}, thr_id);
-            gts->insert({edge.dst, edge.src}, thr_id);
+        }
+        if (cancel_cache) {
+          // updates must not be held in the window past the breakpoint
+          if (reached_breakpoint) cancel_cache->flush(add_update);
+          cancelled_updates += cancel_cache->take_num_cancelled();
+        }
+        pre_insert_buffer(upd_buffer, thr_id);
+        {
+          PerfScope scope(PERF_GUTTER_INSERT);
+          insert_to_gutters(gutter_buffer, thr_id);
+        }
+        ingested_updates.fetch_add(upd_buffer.size(), std::memory_order_relaxed);
+
+        if (reached_breakpoint) {
+          // reached the breakpoint. Update verifier if applicable and return
 #ifdef VERIFY_SAMPLES_F
-            local_verifier.edge_update(edge);
+          std::lock_guard<std::mutex> lk(verifier_mtx);
+          verifier->combine(local_verifier);
 #endif
-          }
+          return;
         }
       }
     };
 
     std::vector<std::thread> threads;
-    for (size_t i = 0; i < num_stream_threads; i++) threads.emplace_back(task, i);
+    for (size_t i = 0; i < num_stream_threads; i++) {
+      threads.emplace_back(task, i);
+      // stream threads take the CPUs after those of the workers
+      if (pin_threads) {
+        size_t cpu_idx = worker_threads->get_num_threads() + i;
+        NumaTopology::pin_thread(threads[i], topology.cpu_for_thread(cpu_idx));
+      }
+    }
 
     // wait for threads to finish
     for (size_t i = 0; i < num_stream_threads; i++) threads[i].join();
@@ -190,20 +405,132 @@ class GraphSketchDriver {
 #endif
   }
 
+  /**
+   * Apply every update of a grouped stream. Each run is passed directly to the workers as a batch
+   * of updates, bypassing the guttering system. Updates already guttered by
+   * process_stream_until() are applied first.
+   * @param grouped  the stream to process.
+   * @throws StreamException if the grouped stream is truncated.
+   */
+  void process_grouped_stream(GroupedStreamReader &grouped) {
+    // the workers only run tasks once flushed
+    worker_threads->begin_flush();
+    for (GutteringSystem *partition : gts) partition->force_flush();
+    worker_threads->flush_workers();
+
+    size_t max_batch = sketching_alg->get_desired_updates_per_batch();
+    std::exception_ptr err;
+    std::mutex err_lock;
+    worker_threads->run([&](size_t thr_id, size_t /* num_threads */) {
+      node_id_t src;
+      std::vector<node_id_t> dsts;
+      std::vector<GraphUpdate> edges;
+#ifdef VERIFY_SAMPLES_F
+      GraphVerifier local_verifier(sketching_alg->get_num_vertices());
+#endif
+      try {
+        while (grouped.get_run(src, dsts, max_batch)) {
+          // each edge appears in the runs of both its endpoints, but must be pre-inserted once.
+          // Grouped streams do not record update types, which pre_insert does not depend upon.
+          edges.clear();
+          for (node_id_t dst : dsts) {
+            if (src < dst) edges.push_back({{src, dst}, INSERT});
+          }
+          pre_insert_buffer(edges, thr_id);
+#ifdef VERIFY_SAMPLES_F
+          for (const GraphUpdate &upd : edges) local_verifier.edge_update(upd.edge);
+#endif
+          batch_callback(thr_id, src, dsts);
+          grouped_updates.fetch_add(dsts.size(), std::memory_order_relaxed);
+        }
+      } catch (...) {
+        std::lock_guard<std::mutex> lk(err_lock);
+        err = std::current_exception();
+      }
+#ifdef VERIFY_SAMPLES_F
+      std::lock_guard<std::mutex> lk(verifier_mtx);
+      verifier->combine(local_verifier);
+#endif
+    });
+    if (err) std::rethrow_exception(err);
+
+#ifdef VERIFY_SAMPLES_F
+    sketching_alg->set_verifier(std::make_unique<GraphVerifier>(*verifier));
+#endif
+  }
+
   void prep_query(int query_code) {
     if (sketching_alg->has_cached_query(query_code)) {
       flush_start = flush_end = std::chrono::steady_clock::now();
       return;
     }
     flush_start = std::chrono::steady_clock::now();
-    gts->force_flush();
-    worker_threads->flush_workers();
+    {
+      TraceScope trace(TRACE_PREP_QUERY_FLUSH);
+      worker_threads->begin_flush();
+      for (size_t p = 0; p < num_partitions; p++) {
+        TraceScope gutter_trace(TRACE_GUTTER_FLUSH, p);
+        gts[p]->force_flush();
+      }
+      worker_threads->flush_workers();
+    }
     flush_end = std::chrono::steady_clock::now();
+
+    uint64_t flush_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(flush_end - flush_start).count();
+    last_flush_ns = flush_ns;
+    total_flush_ns += flush_ns;
+    ++num_flushes;
+  }
+
+  // pass a buffer of updates to the algorithm's pre_insert hook
+  void pre_insert_buffer(const std::vector<GraphUpdate> &upds, int thr_id) {
+    if constexpr (accepts_pre_insert_batch<Alg>::value) {
+      sketching_alg->pre_insert_batch(upds.data(), upds.size(), thr_id);
+    } else {
+      for (const GraphUpdate &upd : upds) sketching_alg->pre_insert(upd, thr_id);
+    }
+  }
+
+  /**
+   * Insert a buffer of updates to the guttering systems of the partitions that own their source
+   * vertices. We dispatch on the type of guttering system once per buffer rather than making a
+   * virtual call per update.
+   */
+  void insert_to_gutters(const std::vector<update_t> &upds, int thr_id) {
+    if (gutter_sys == GUTTERTREE)
+      insert_to_gutters<GutterTree>(upds, thr_id);
+    else if (gutter_sys == STANDALONE)
+      insert_to_gutters<StandAloneGutters>(upds, thr_id);
+    else
+      insert_to_gutters<CacheGuttering>(upds, thr_id);
+  }
+
+  template <class Gutters>
+  void insert_to_gutters(const std::vector<update_t> &upds, int thr_id) {
+    // the qualified Gutters::insert() calls are not virtual
+    if (num_partitions == 1) {
+      Gutters *gutters = static_cast<Gutters *>(gts[0]);
+      for (const update_t &upd : upds) gutters->Gutters::insert(upd, thr_id);
+      return;
+    }
+    node_id_t num_vertices = sketching_alg->get_num_vertices();
+    for (const update_t &upd : upds) {
+      size_t p = NumaTopology::vertex_partition(upd.first, num_vertices, num_partitions);
+      Gutters *gutters = static_cast<Gutters *>(gts[p]);
+      gutters->Gutters::insert({upd.first - partition_first[p], upd.second}, thr_id);
+    }
   }
 
   inline void batch_callback(int thr_id, node_id_t src_vertex,
                              const std::vector<node_id_t> &dst_vertices) {
+    TraceScope trace(TRACE_BATCH_APPLY, dst_vertices.size());
     total_updates += dst_vertices.size();
+    WorkerCounters &counters = worker_counters[thr_id];
+    counters.batches.fetch_add(1, std::memory_order_relaxed);
+    counters.updates.fetch_add(dst_vertices.size(), std::memory_order_relaxed);
+    counters.batch_sizes[RuntimeStats::histogram_bucket(dst_vertices.size())].fetch_add(
+        1, std::memory_order_relaxed);
     sketching_alg->apply_update_batch(thr_id, src_vertex, dst_vertices);
   }
 
@@ -222,11 +549,48 @@ class GraphSketchDriver {
 
   size_t get_total_updates() { return total_updates.load(); }
 
+  // the number of stream updates that cancelled before reaching the guttering system
+  size_t get_cancelled_updates() { return cancelled_updates.load(); }
+
+  /**
+   * A snapshot of the counters of the driver and, if it reports them, the queries of the
+   * algorithm. Safe to call at any time from any thread, for example to export the stats
+   * periodically for monitoring. Each counter is read individually, so counters read while
+   * updates are being applied may be slightly out of step with one another.
+   */
+  RuntimeStats get_stats() {
+    RuntimeStats stats;
+    std::chrono::duration<double> uptime = std::chrono::steady_clock::now() - construct_time;
+    stats.uptime_seconds = uptime.count();
+    // read before the applied updates, which count each grouped update first
+    uint64_t grouped = grouped_updates.load();
+    stats.ingested_updates = ingested_updates.load();
+    stats.cancelled_updates = cancelled_updates.load();
+    stats.applied_updates = total_updates.load();
+    for (size_t i = 0; i < num_workers; i++) {
+      WorkerCounters &counters = worker_counters[i];
+      stats.workers.push_back({counters.batches.load(), counters.updates.load()});
+      for (size_t b = 0; b < RuntimeStats::histogram_buckets; b++)
+        stats.batch_size_histogram[b] += counters.batch_sizes[b].load();
+    }
+    // each ingested update is inserted to the gutters of both of its endpoints
+    uint64_t guttered = 2 * stats.ingested_updates;
+    uint64_t applied_from_gutters = stats.applied_updates - grouped;
+    stats.buffered_updates = guttered > applied_from_gutters ? guttered - applied_from_gutters : 0;
+
+    stats.flushes = num_flushes.load();
+    stats.last_flush_seconds = last_flush_ns.load() / 1e9;
+    stats.total_flush_seconds = total_flush_ns.load() / 1e9;
+    if constexpr (reports_query_stats<Alg>::value) stats.query = sketching_alg->get_query_stats();
+    return stats;
+  }
+
   // time hooks for experiments
   std::chrono::steady_clock::time_point flush_start;
   std::chrono::steady_clock::time_point flush_end;
 
   // getters
-  inline GutteringSystem * get_gts() { return gts; } 
+  inline GutteringSystem * get_gts(size_t partition = 0) { return gts[partition]; }
+  inline size_t get_num_partitions() { return num_partitions; }
   inline WorkerThreadGroup<Alg> * get_worker_threads() { return worker_threads; }
 };
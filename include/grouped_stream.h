@@ -0,0 +1,75 @@
+#pragma once
+#include <graph_stream.h>
+
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * A binary stream whose updates are grouped into runs by source vertex, for example an adjacency
+ * list dump. The driver applies each run directly as a batch of updates, bypassing guttering.
+ *
+ * File format:
+ *    node_id_t num_vertices
+ *    edge_id_t num_updates     total length of all the runs
+ *    runs, each of the form:
+ *      node_id_t src
+ *      uint32_t  length
+ *      node_id_t dst[length]
+ *
+ * Each run only updates the sketch of src. So every edge (u, v) must appear both in a run of u
+ * and in a run of v. The GroupedStreamWriter does not enforce this.
+ */
+class GroupedStreamReader {
+ private:
+  std::ifstream in;
+  std::mutex read_lock;
+  node_id_t num_vertices;
+  edge_id_t num_updates;
+
+  // the run we are part way through
+  node_id_t run_src = 0;
+  uint32_t run_remaining = 0;
+
+ public:
+  /**
+   * @param file_name  the grouped stream to read.
+   * @throws StreamException if the file cannot be opened.
+   */
+  GroupedStreamReader(const std::string &file_name);
+
+  /**
+   * Get the next portion of a run. Long runs are returned in several portions.
+   * This function is thread-safe.
+   * @param src          returns the source vertex of the run.
+   * @param dsts         returns the destinations of the portion.
+   * @param max_updates  the maximum length of the portion.
+   * @return             false once the stream is exhausted.
+   * @throws StreamException if the file is truncated.
+   */
+  bool get_run(node_id_t &src, std::vector<node_id_t> &dsts, size_t max_updates);
+
+  node_id_t vertices() { return num_vertices; }
+  edge_id_t updates() { return num_updates; }
+};
+
+/**
+ * Writes a grouped stream, see GroupedStreamReader for the format.
+ */
+class GroupedStreamWriter {
+ private:
+  std::ofstream out;
+  node_id_t num_vertices;
+  edge_id_t num_updates = 0;
+
+ public:
+  /**
+   * @throws StreamException if the file cannot be opened.
+   */
+  GroupedStreamWriter(const std::string &file_name, node_id_t num_vertices);
+  ~GroupedStreamWriter();  // writes the header
+
+  // Write a run. Runs longer than UINT32_MAX are split.
+  void write_run(node_id_t src, const node_id_t *dsts, size_t length);
+};
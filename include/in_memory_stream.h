@@ -0,0 +1,115 @@
+#pragma once
+#include <graph_stream.h>
+
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "futex_word.h"
+#include "mmap_binary_stream.h"
+
+/**
+ * A stream of updates held in memory, either owned by the stream or borrowed from the caller.
+ * Threads claim ranges of the array with an atomic offset and the driver parses them in place,
+ * so benchmarks measure sketching without any I/O.
+ */
+class InMemoryStream : public GraphStream, public ZeroCopyStream {
+ private:
+  std::vector<GraphStreamUpdate> owned_updates;
+  const GraphStreamUpdate *stream_updates;
+
+  std::atomic<edge_id_t> stream_off{0};   // index of the next unclaimed update
+  std::atomic<edge_id_t> break_index{0};  // index of the breakpoint
+
+ public:
+  // Take ownership of the updates
+  InMemoryStream(node_id_t num_vertices, std::vector<GraphStreamUpdate> &&updates);
+
+  // Read updates owned by the caller, which must outlive the stream
+  InMemoryStream(node_id_t num_vertices, const GraphStreamUpdate *updates, edge_id_t num_updates);
+
+  size_t get_update_view(const GraphStreamUpdate *&updates, size_t max_updates) override;
+  size_t get_update_buffer(GraphStreamUpdate *upd_buf, size_t num_updates) override;
+
+  bool get_update_is_thread_safe() override { return true; }
+  void seek(edge_id_t edge_idx) override { stream_off = edge_idx; }
+  bool set_break_point(edge_id_t break_idx) override;
+  void serialize_metadata(std::ostream &out) override;
+};
+
+/**
+ * A stream fed by a producer, either a callback run on a thread owned by the stream or a caller
+ * that pushes updates, for example as they arrive from the network. Updates pass through a fixed
+ * size ring buffer. There may be one producer and any number of reader threads, and neither side
+ * takes a lock: readers claim ranges of the ring with an atomic offset and release them in order,
+ * and the producer publishes updates with an atomic offset. A full ring blocks the producer and
+ * an empty one blocks the readers.
+ *
+ * The number of updates is unknown until the producer closes the stream, so edges() is 0 until
+ * then. It is only safe to call edges() on a RingBufferStream, not through a GraphStream, since
+ * GraphStream::edges() reads the count without synchronizing with close(). Updates are gone once
+ * read, so the stream cannot seek backwards.
+ */
+class RingBufferStream : public GraphStream {
+ public:
+  /**
+   * Writes up to max_updates updates into buf and returns how many it wrote. Returning 0 ends
+   * the stream.
+   */
+  using Producer = std::function<size_t(GraphStreamUpdate *buf, size_t max_updates)>;
+
+ private:
+  std::vector<GraphStreamUpdate> ring;
+  size_t ring_mask;
+
+  // Positions in the stream. Every update before published is in the ring, every update before
+  // claimed is taken by a reader, and every update before released has been copied out.
+  alignas(64) std::atomic<edge_id_t> published{0};
+  alignas(64) std::atomic<edge_id_t> claimed{0};
+  alignas(64) std::atomic<edge_id_t> released{0};
+  std::atomic<edge_id_t> break_index{END_OF_STREAM};
+  std::atomic<bool> closed{false};
+  std::atomic<bool> stopping{false};  // set when the stream is destroyed
+
+  FutexWord data_word;   // changes when updates are published or the stream is closed
+  FutexWord space_word;  // changes when updates are released
+
+  std::thread producer_thread;
+
+  // Wait for space in the ring and return the contiguous free slots after the published updates
+  GraphStreamUpdate *reserve(size_t &free_slots);
+  void publish(size_t num_updates);
+
+ public:
+  /**
+   * @param num_vertices  the number of vertices in the graph.
+   * @param capacity      the number of updates the ring holds. Rounded up to a power of 2.
+   */
+  RingBufferStream(node_id_t num_vertices, size_t capacity = 1 << 20);
+
+  // Run the producer on a thread owned by the stream until it returns 0, then close the stream
+  RingBufferStream(node_id_t num_vertices, Producer producer, size_t capacity = 1 << 20);
+  ~RingBufferStream();
+
+  /**
+   * Append updates to the stream, waiting while the ring is full. Only one thread may push, and
+   * not while a producer callback is running.
+   */
+  void push(const GraphStreamUpdate *updates, size_t num_updates);
+
+  // End the stream. Readers reach the breakpoint once they have read every pushed update.
+  void close();
+
+  // The number of updates, or 0 until the stream is closed. Any thread may call this.
+  edge_id_t edges() { return closed.load(std::memory_order_acquire) ? num_edges : 0; }
+
+  size_t get_update_buffer(GraphStreamUpdate *upd_buf, size_t num_updates) override;
+
+  bool get_update_is_thread_safe() override { return true; }
+
+  // @throws StreamException unless edge_idx is the next unread update
+  void seek(edge_id_t edge_idx) override;
+  bool set_break_point(edge_id_t break_idx) override;
+  void serialize_metadata(std::ostream &out) override;
+};
@@ -0,0 +1,85 @@
+#pragma once
+#include <graph_zeppelin_common.h>
+
+#include <cstddef>
+#include <iostream>
+
+#include "cc_alg_configuration.h"
+#include "driver_configuration.h"
+
+// The estimated memory of each part of ingestion and queries, in bytes
+struct MemoryEstimate {
+  size_t sketch_bytes = 0;        // the sketch of every vertex
+  size_t delta_sketch_bytes = 0;  // the delta sketch of each worker
+  size_t gutter_bytes = 0;        // gutters held in memory and batches in the work queue
+  size_t vertex_bytes = 0;        // DSU, representatives and spanning forest of every vertex
+  size_t query_bytes = 0;         // merge instructions and supernode sketches of a query
+
+  size_t total() const {
+    return sketch_bytes + delta_sketch_bytes + gutter_bytes + vertex_bytes + query_bytes;
+  }
+
+  friend std::ostream& operator<< (std::ostream &out, const MemoryEstimate &estimate);
+};
+
+/**
+ * Chooses the configuration of the driver and the connected components algorithm that fits in a
+ * memory budget. Sketch memory and gutter memory are otherwise configured independently, and
+ * in-memory gutters for many vertices can exhaust memory on their own.
+ *
+ * The vertex sketches, the per vertex bookkeeping and the spanning forest do not depend on the
+ * configuration, so the budget must at least cover them. With the rest, plan() picks the first
+ * of these that fits, roughly from fastest to slowest:
+ *   1) CacheTree, then StandAloneGutters, with batch factors from 2 down to 0.25, each leaf gutter
+ *      holding one batch
+ *   2) the on-disk GutterTree, with batch factors from 1 down to 0.25
+ * and halves the number of workers, each of which has a delta sketch, until one of them fits.
+ *
+ * These are estimates. They exclude the stream's buffers and allocator overhead, so leave some
+ * headroom in the budget.
+ */
+class MemoryBudget {
+ private:
+  node_id_t num_vertices;
+  size_t budget_bytes;
+  size_t num_stream_threads;
+
+  // guttering parameters plan() sets, since the memory of the guttering system depends on them
+  static constexpr size_t queue_factor = 8;
+  static constexpr size_t wq_batch_per_elm = 8;
+  static constexpr size_t fanout = 64;
+  static constexpr size_t buffer_exp = 20;
+
+ public:
+  MemoryBudget(node_id_t num_vertices, size_t budget_bytes, size_t num_stream_threads = 1)
+      : num_vertices(num_vertices),
+        budget_bytes(budget_bytes),
+        num_stream_threads(num_stream_threads) {}
+
+  /**
+   * Estimate the memory of a configuration with the guttering parameters plan() sets
+   * @param gutter_sys       the guttering system
+   * @param workers          the number of worker threads
+   * @param gutter_bytes     the size of a leaf gutter, which is also the size of a batch
+   * @param sketches_factor  the sketches factor of the algorithm
+   */
+  MemoryEstimate estimate(GutterSystem gutter_sys, size_t workers, size_t gutter_bytes,
+                          double sketches_factor = 1) const;
+
+  // Estimate the memory of the configurations, with the guttering parameters plan() sets
+  MemoryEstimate estimate(DriverConfiguration driver_config, CCAlgConfiguration alg_config) const;
+
+  /**
+   * Set the guttering system, gutter sizes, batch factor and number of workers of the
+   * configurations so that their estimate fits in the budget. The other options are kept.
+   * Throws std::runtime_error if no configuration fits.
+   * @return the estimate of the chosen configuration
+   */
+  MemoryEstimate plan(DriverConfiguration &driver_config, CCAlgConfiguration &alg_config) const;
+
+  size_t get_budget_bytes() const { return budget_bytes; }
+
+  // The leaf gutter size in bytes that holds one batch of the given batch factor
+  static size_t batch_bytes(node_id_t num_vertices, double batch_factor,
+                            double sketches_factor = 1);
+};
@@ -0,0 +1,65 @@
+#pragma once
+#include <graph_stream.h>
+
+#include <atomic>
+#include <string>
+
+/**
+ * A stream whose updates can be read in place, without copying them into a caller's buffer.
+ * The driver checks for this interface and, if present, parses updates directly from the views.
+ */
+class ZeroCopyStream {
+ public:
+  virtual ~ZeroCopyStream() = default;
+
+  /**
+   * Claim the next updates of the stream, up to the breakpoint. This function is thread-safe.
+   * The returned view remains valid for the lifetime of the stream.
+   * @param updates      returns a pointer to the first claimed update.
+   * @param max_updates  the maximum number of updates to claim.
+   * @return             the number of updates claimed. 0 once the breakpoint is reached.
+   */
+  virtual size_t get_update_view(const GraphStreamUpdate *&updates, size_t max_updates) = 0;
+};
+
+/**
+ * Reads a stream in the BinaryFileStream format by mapping the file into memory. Threads claim
+ * chunks of the file with an atomic offset, so any number of threads may read without a lock,
+ * and updates are parsed in place rather than copied out by read system calls.
+ */
+class MMapBinaryStream : public GraphStream, public ZeroCopyStream {
+ private:
+  std::string file_name;
+  int stream_fd;
+  const char *mapping = nullptr;
+  size_t file_bytes;
+  const GraphStreamUpdate *stream_updates;  // the updates following the header
+
+  std::atomic<edge_id_t> stream_off{0};    // index of the next unclaimed update
+  std::atomic<edge_id_t> break_index{0};   // index of the breakpoint
+  std::atomic<size_t> advised_until{0};    // byte offset the kernel has been asked to read up to
+
+  static constexpr size_t header_size = sizeof(node_id_t) + sizeof(edge_id_t);
+  // ask the kernel to read this far ahead of the furthest claimed update, one window at a time
+  static constexpr size_t readahead_bytes = 64 * 1024 * 1024;
+
+  void advise_readahead(edge_id_t claimed_end);
+
+ public:
+  /**
+   * @param file_name  the binary stream to read.
+   * @throws StreamException if the file cannot be opened or mapped.
+   */
+  MMapBinaryStream(const std::string &file_name);
+  ~MMapBinaryStream();
+
+  size_t get_update_view(const GraphStreamUpdate *&updates, size_t max_updates) override;
+
+  // Copies updates into upd_buf. Prefer get_update_view().
+  size_t get_update_buffer(GraphStreamUpdate *upd_buf, size_t num_updates) override;
+
+  bool get_update_is_thread_safe() override { return true; }
+  void seek(edge_id_t edge_idx) override { stream_off = edge_idx; }
+  bool set_break_point(edge_id_t break_idx) override;
+  void serialize_metadata(std::ostream &out) override;
+};
@@ -0,0 +1,89 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+// Where to place the sketches of an algorithm across the NUMA nodes of the machine
+enum SketchPlacement {
+  FIRST_TOUCH,  // wherever the operating system puts them (usually the constructing thread's node)
+  INTERLEAVE,   // spread the pages of the sketches round robin across all nodes
+  PARTITION     // divide the vertices into contiguous ranges, one per node
+};
+
+/**
+ * The NUMA nodes of the machine and the CPUs this process may run on within each of them.
+ * Read from sysfs. If NUMA information is unavailable the machine is treated as a single node.
+ */
+class NumaTopology {
+ private:
+  std::vector<std::vector<int>> node_cpus;  // the allowed CPUs of each node, nodes without
+                                            // allowed CPUs are omitted
+  std::vector<int> node_ids;                // operating system id of each node
+
+ public:
+  NumaTopology();
+
+  size_t num_nodes() const { return node_cpus.size(); }
+  int get_node_id(size_t node) const { return node_ids[node]; }
+  const std::vector<int> &get_node_cpus(size_t node) const { return node_cpus[node]; }
+
+  /**
+   * Threads are spread round robin across the nodes and then across the CPUs of each node.
+   * @param thr_id  the index of the thread among all the threads we pin.
+   * @return        the node (index into this topology) and CPU of the thread.
+   */
+  size_t node_for_thread(size_t thr_id) const { return thr_id % num_nodes(); }
+  int cpu_for_thread(size_t thr_id) const;
+
+  /**
+   * Restrict a thread to a single CPU.
+   * @return  true if successful.
+   */
+  static bool pin_thread(std::thread &thr, int cpu);
+
+  /**
+   * Move the pages overlapping [addr, addr + bytes) to a NUMA node, and keep future pages there.
+   * @param node   operating system id of the node
+   * @return       true if successful.
+   */
+  static bool bind_memory(void *addr, size_t bytes, int node);
+
+  /**
+   * Spread the pages overlapping [addr, addr + bytes) round robin across all of our nodes.
+   * @return       true if successful.
+   */
+  bool interleave_memory(void *addr, size_t bytes) const;
+
+  static size_t page_size();
+
+  /**
+   * The vertices [0, num_vertices) are divided into num_parts contiguous partitions whose sizes
+   * differ by at most one. Used both to place sketches and to route updates to the partition,
+   * and thus the NUMA node, that owns their vertex.
+   * @return  the first vertex of partition part. partition_begin(num_parts) is num_vertices.
+   */
+  static uint64_t partition_begin(size_t part, uint64_t num_vertices, size_t num_parts) {
+    return num_vertices * part / num_parts;
+  }
+  // the partition that contains vertex
+  static size_t vertex_partition(uint64_t vertex, uint64_t num_vertices, size_t num_parts) {
+    return (num_parts * (vertex + 1) + num_vertices - 1) / num_vertices - 1;
+  }
+
+  /**
+   * Allocate zeroed, page aligned memory whose placement may be controlled with the functions
+   * above without affecting any other allocation.
+   * @throws std::bad_alloc if the memory cannot be allocated.
+   */
+  static void *allocate_pages(size_t bytes);
+  static void free_pages(void *addr, size_t bytes);
+};
+
+// The NUMA placement the driver requests of the algorithm it manages
+struct NumaPolicy {
+  const NumaTopology *topology;
+  SketchPlacement placement;
+  bool local_worker_memory;         // place each worker's scratch memory on the worker's node
+  std::vector<size_t> worker_nodes; // the node (index into topology) each worker runs on
+};
@@ -0,0 +1,134 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// The phases of stream ingestion and queries that the PerfProfiler attributes hardware events to
+enum PerfPhase {
+  PERF_STREAM_READ,         // reading and parsing a buffer of updates from the stream
+  PERF_GUTTER_INSERT,       // inserting a buffer of updates into the guttering system
+  PERF_APPLY_UPDATE_BATCH,  // applying a batch of updates to a vertex sketch, delta merge included
+  PERF_DELTA_MERGE,         // merging the delta sketch of a batch into the vertex sketch
+  PERF_BORUVKA_ROUND,       // sampling and merging the sketches of one Boruvka round
+  PERF_MERGE_INSTRUCTIONS,  // constructing the merge instructions for the next round
+  NUM_PERF_PHASES
+};
+
+enum PerfEvent {
+  PERF_CYCLES,
+  PERF_INSTRUCTIONS,
+  PERF_LLC_MISSES,   // last level cache read misses
+  PERF_DTLB_MISSES,  // data TLB read misses
+  NUM_PERF_EVENTS
+};
+
+const char *perf_phase_name(PerfPhase phase);
+const char *perf_event_name(PerfEvent event);
+
+// The totals of a phase, summed over every thread that ran it
+struct PerfPhaseTotals {
+  uint64_t calls = 0;
+  double thread_seconds = 0;           // wall time summed over threads
+  double events[NUM_PERF_EVENTS] = {};  // scaled up if the kernel multiplexed the counters
+};
+
+/**
+ * Optional profiling layer that counts hardware events with perf_event_open and attributes them
+ * to the phases of the driver and algorithm. Each thread opens its own group of counters the
+ * first time it enters a phase, counting user space only, and reads the group as it enters and
+ * leaves each phase. Profiling is disabled by default, in which case a phase costs one relaxed
+ * load.
+ *
+ * If the kernel does not permit counting (see /proc/sys/kernel/perf_event_paranoid) or the
+ * machine lacks an event, the event is reported as unavailable and calls and time are still
+ * recorded.
+ */
+class PerfProfiler {
+ private:
+  static std::atomic<bool> is_enabled;
+  static std::atomic<uint64_t> task_phase;  // phase << 32 | round, of TaskPool tasks
+ public:
+  // Boruvka rounds beyond this are counted towards the last round
+  static constexpr size_t max_rounds = 64;
+
+  static void enable(bool enable = true) { is_enabled.store(enable, std::memory_order_relaxed); }
+  static bool enabled() { return is_enabled.load(std::memory_order_relaxed); }
+
+  // Zero every total. Must not be called while a phase is running.
+  static void reset();
+
+  // Whether any thread was able to count an event
+  static bool event_available(PerfEvent event);
+
+  static PerfPhaseTotals get_totals(PerfPhase phase, size_t round = 0);
+
+  /**
+   * Write the totals of every phase as JSON, Boruvka rounds and merge instructions per round.
+   * Events that are unavailable are null.
+   */
+  static void write_json(std::ostream &out);
+  static void write_json(const std::string &filename);
+
+  /**
+   * Set the phase that the threads of a TaskPool count the tasks they run towards. The parallel
+   * sections of queries run on the pool, so their phase is set by the thread that starts them.
+   */
+  static void set_task_phase(PerfPhase phase, size_t round) {
+    task_phase.store((uint64_t)phase << 32 | round, std::memory_order_relaxed);
+  }
+  static void clear_task_phase() { set_task_phase(NUM_PERF_PHASES, 0); }
+  static PerfPhase get_task_phase(size_t &round) {
+    uint64_t packed = task_phase.load(std::memory_order_relaxed);
+    round = packed & 0xFFFFFFFF;
+    return (PerfPhase)(packed >> 32);
+  }
+};
+
+struct PerfThreadCounters;
+
+/**
+ * Counts the hardware events of the calling thread between construction and destruction towards
+ * a phase. Scopes may nest, in which case the events count towards each of them.
+ */
+class PerfScope {
+ private:
+  PerfThreadCounters *counters = nullptr;
+  PerfPhase phase;
+  size_t round;
+  uint64_t start[NUM_PERF_EVENTS + 3];  // event values, time enabled and running, and wall time
+
+  void begin();
+  void end();
+
+ public:
+  PerfScope(PerfPhase phase, size_t round = 0) : phase(phase), round(round) {
+    if (PerfProfiler::enabled() && phase < NUM_PERF_PHASES) begin();
+  }
+  ~PerfScope() {
+    if (counters != nullptr) end();
+  }
+  PerfScope(const PerfScope &) = delete;
+  PerfScope &operator=(const PerfScope &) = delete;
+
+  // A scope for a TaskPool task, in the phase set by the thread that started the task
+  static PerfScope task() {
+    size_t round;
+    PerfPhase phase = PerfProfiler::get_task_phase(round);
+    return PerfScope(phase, round);
+  }
+};
+
+/**
+ * Sets the phase of TaskPool tasks for its lifetime.
+ */
+class PerfTaskPhase {
+ public:
+  PerfTaskPhase(PerfPhase phase, size_t round = 0) {
+    if (PerfProfiler::enabled()) PerfProfiler::set_task_phase(phase, round);
+  }
+  ~PerfTaskPhase() { PerfProfiler::clear_task_phase(); }
+  PerfTaskPhase(const PerfTaskPhase &) = delete;
+  PerfTaskPhase &operator=(const PerfTaskPhase &) = delete;
+};
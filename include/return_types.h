@@ -7,6 +7,7 @@
 #include <vector>
 
 #include "dsu.h"
+#include "task_pool.h"
 #include "types.h"
 
 // This class defines the connected components of a graph
@@ -18,6 +19,8 @@ class ConnectedComponents {
 
  public:
   ConnectedComponents(node_id_t num_vertices, DisjointSetUnion_MT<node_id_t> &dsu);
+  ConnectedComponents(node_id_t num_vertices, DisjointSetUnion_MT<node_id_t> &dsu,
+                      TaskPool &pool);
   ~ConnectedComponents();
 
   std::vector<std::set<node_id_t>> get_component_sets();
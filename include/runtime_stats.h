@@ -0,0 +1,110 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// The batches and updates applied by one worker thread
+struct WorkerStats {
+  uint64_t batches = 0;
+  uint64_t updates = 0;
+};
+
+// One Boruvka round of a query and the results of sampling each supernode during it
+struct QueryRoundStats {
+  double seconds = 0;
+  uint64_t good_samples = 0;
+  uint64_t zero_samples = 0;
+  uint64_t fail_samples = 0;
+};
+
+// The queries an algorithm has answered by running Boruvka, and the last of them
+struct QueryStats {
+  uint64_t queries = 0;
+  size_t last_query_rounds = 0;  // Boruvka rounds run, including the final round
+  double last_query_seconds = 0;
+  std::vector<QueryRoundStats> last_query_round_stats;
+};
+
+/**
+ * A snapshot of the counters of a GraphSketchDriver and its algorithm. Counters are totals since
+ * the driver was constructed, so rates are differences between snapshots.
+ */
+struct RuntimeStats {
+  // Bucket i of the batch size histogram counts batches of [2^i, 2^(i+1)) updates
+  static constexpr size_t histogram_buckets = 32;
+
+  double uptime_seconds = 0;           // since the driver was constructed
+  uint64_t ingested_updates = 0;       // stream updates passed to the guttering system
+  uint64_t cancelled_updates = 0;      // stream updates that cancelled before the gutters
+  uint64_t applied_updates = 0;        // updates applied to the sketches, two per stream update
+  uint64_t buffered_updates = 0;       // updates in the gutters or work queue, not yet applied
+  std::vector<WorkerStats> workers;
+  uint64_t batch_size_histogram[histogram_buckets] = {};
+
+  uint64_t flushes = 0;  // flushes of the gutters by prep_query()
+  double last_flush_seconds = 0;
+  double total_flush_seconds = 0;
+
+  QueryStats query;
+
+  static size_t histogram_bucket(size_t batch_size) {
+    size_t bucket = batch_size == 0 ? 0 : 63 - __builtin_clzll(batch_size);
+    return bucket < histogram_buckets ? bucket : histogram_buckets - 1;
+  }
+
+  void write_json(std::ostream &out) const;
+
+  // Write in the Prometheus text exposition format, for example for node_exporter's textfile
+  // collector
+  void write_prometheus(std::ostream &out) const;
+
+  /**
+   * Write to a file, replacing it atomically so readers never see a partial snapshot.
+   * @throws std::runtime_error if the file cannot be written.
+   */
+  void export_json(const std::string &filename) const;
+  void export_prometheus(const std::string &filename) const;
+};
+
+/**
+ * Counters incremented concurrently by many threads. Each thread increments its own stripe of
+ * the counters, so increments rarely contend, and reading a counter sums the stripes.
+ */
+template <size_t num_counters>
+class StripedCounters {
+ private:
+  static constexpr size_t num_stripes = 64;
+  struct alignas(64) Stripe {
+    std::atomic<uint64_t> counts[num_counters];
+  };
+  std::unique_ptr<Stripe[]> stripes;
+
+  static size_t stripe_idx() {
+    static std::atomic<size_t> next_stripe{0};
+    thread_local size_t idx = next_stripe++ % num_stripes;
+    return idx;
+  }
+
+ public:
+  StripedCounters() : stripes(new Stripe[num_stripes]) { reset(); }
+
+  void increment(size_t counter) {
+    stripes[stripe_idx()].counts[counter].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  uint64_t get(size_t counter) const {
+    uint64_t sum = 0;
+    for (size_t s = 0; s < num_stripes; s++)
+      sum += stripes[s].counts[counter].load(std::memory_order_relaxed);
+    return sum;
+  }
+
+  void reset() {
+    for (size_t s = 0; s < num_stripes; s++)
+      for (auto &count : stripes[s].counts) count.store(0, std::memory_order_relaxed);
+  }
+};
@@ -77,11 +77,24 @@ class Sketch {
   }
 
   /**
-   * Construct a sketch object with already allocated bucket (For GPU-Purpose)
+   * The number of buckets in a sketch. Used to allocate buckets for the constructor below.
+   * @param vector_len       Length of the vector we are sketching
+   * @param num_samples      Number of samples the sketch supports
+   * @param cols_per_sample  [Optional] Number of sketch columns for each sample (default = 1)
+   */
+  static size_t calc_num_buckets(vec_t vector_len, size_t num_samples,
+                                 size_t cols_per_sample = default_cols_per_sample) {
+    return num_samples * cols_per_sample * calc_bkt_per_col(vector_len) + 1;
+  }
+
+  /**
+   * Construct a sketch object with already allocated bucket (For GPU-Purpose, or to place
+   * sketches in a shared memory arena). The buckets are not freed by the sketch.
    * @param vector_len       Length of the vector we are sketching
    * @param seed             Random seed of the sketch
    * @param sketch_id        Id of current sketch (Vertex Id)
-   * @param _buckets         Pointer to all buckets
+   * @param _buckets         Pointer to all buckets. This sketch uses the buckets beginning at
+   *                         _buckets[sketch_id * calc_num_buckets()]
    * @param num_samples      [Optional] Number of samples this sketch supports (default = 1)
    * @param cols_per_sample  [Optional] Number of sketch columns for each sample (default = 1)
    */
@@ -0,0 +1,87 @@
+#pragma once
+#include <graph_stream.h>
+#include <omp.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "stream_generator_configuration.h"
+
+/**
+ * Generates a synthetic stream from a random graph model, in parallel. Every edge is inserted
+ * once. A churn fraction of the edges are then deleted and inserted again, and a delete fraction
+ * of the edges are deleted for good, so the stream never deletes an absent edge or inserts a
+ * present one.
+ *
+ * Edges are sampled in parallel and stored as a bijective hash of the edge, then partitioned into
+ * buckets by hash and deduplicated by sorting each bucket. The stream is the buckets in order, so
+ * edges appear in a pseudo-random order that depends only on the configuration. Each bucket is
+ * emitted as its insertions, then the deletions and insertions of its churned edges, then its
+ * final deletions.
+ *
+ * The distinct edges are held in memory, 8 bytes each.
+ */
+class StreamGenerator {
+ private:
+  StreamGeneratorConfiguration config;
+  size_t bucket_bits;
+  std::vector<std::vector<uint64_t>> buckets;  // the hashed edges of each bucket, sorted
+  std::vector<edge_id_t> bucket_updates;       // the number of updates of each bucket
+
+  edge_id_t num_edges = 0;  // distinct edges
+  edge_id_t num_updates = 0;
+  edge_id_t num_final_edges = 0;
+
+  uint64_t hash_edge(Edge edge) const;
+  Edge unhash_edge(uint64_t hash) const;
+  // Sample an edge that is not a self loop. Returns false if none is found in max_sample_attempts
+  bool sample_edge(std::mt19937_64 &gen, Edge &edge) const;
+  // does the edge churn, and is it deleted by the end of the stream
+  void edge_fate(uint64_t hash, bool &churned, bool &deleted) const;
+  void generate_edges();
+
+ public:
+  // Rejected samples, such as self loops, allowed in a row before the model is deemed degenerate
+  static constexpr size_t max_sample_attempts = 1 << 20;
+
+  /**
+   * @throws std::runtime_error if the model almost never yields an edge that is not a self loop,
+   *         for example RMAT over a number of vertices its probabilities hardly ever reach.
+   */
+  StreamGenerator(const StreamGeneratorConfiguration &config);
+
+  // Append the updates of a bucket to out
+  void emit_bucket(size_t bucket, std::vector<GraphStreamUpdate> &out) const;
+
+  /**
+   * Call func(updates, num_updates) on consecutive batches of the stream, in order.
+   * Batches are generated in parallel.
+   */
+  template <class Func>
+  void for_each_batch(Func func) const {
+    size_t group = 4 * (size_t)omp_get_max_threads();
+    std::vector<std::vector<GraphStreamUpdate>> batches(group);
+    for (size_t first = 0; first < buckets.size(); first += group) {
+      size_t last = std::min(first + group, buckets.size());
+#pragma omp parallel for schedule(dynamic)
+      for (size_t b = first; b < last; b++) {
+        batches[b - first].clear();
+        emit_bucket(b, batches[b - first]);
+      }
+      for (size_t b = first; b < last; b++)
+        func(batches[b - first].data(), batches[b - first].size());
+    }
+  }
+
+  // Write the stream in the BinaryFileStream format
+  void write_binary_stream(const std::string &file_name) const;
+
+  // The whole stream in memory
+  std::vector<GraphStreamUpdate> get_updates() const;
+
+  node_id_t vertices() const { return config._num_vertices; }
+  edge_id_t updates() const { return num_updates; }
+  edge_id_t edges() const { return num_edges; }              // distinct edges inserted
+  edge_id_t final_edges() const { return num_final_edges; }  // edges present at the end
+};
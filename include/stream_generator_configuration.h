@@ -0,0 +1,73 @@
+#pragma once
+
+#include <graph_zeppelin_common.h>
+
+#include <iostream>
+
+// The random graph model from which a stream's edges are drawn
+enum GraphModel {
+  ERDOS_RENYI, // endpoints chosen uniformly at random
+  RMAT,        // recursive matrix (Kronecker) model, giving skewed degrees and communities
+  POWER_LAW    // Chung-Lu model, where vertex i has expected degree proportional to (i+1)^-alpha
+};
+
+// Parameters for generating a synthetic stream
+class StreamGeneratorConfiguration {
+private:
+  GraphModel _model = ERDOS_RENYI;
+
+  node_id_t _num_vertices = 1024;
+
+  // The number of edges to sample. Duplicate edges and self loops are discarded, so the graph may
+  // have slightly fewer edges.
+  edge_id_t _num_edges = 8192;
+
+  // Fraction of edges that are deleted and inserted again before the end of the stream
+  double _churn = 0;
+
+  // Fraction of edges that are deleted by the end of the stream
+  double _delete_fraction = 0;
+
+  // Probabilities of the top-left, top-right and bottom-left quadrants in the RMAT model
+  double _rmat_a = 0.57;
+  double _rmat_b = 0.19;
+  double _rmat_c = 0.19;
+
+  // Exponent of the degree distribution in the POWER_LAW model. Must be greater than 2.
+  double _power_law_exponent = 2.5;
+
+  size_t _seed = 0;
+
+  friend class StreamGenerator;
+
+public:
+  StreamGeneratorConfiguration() {};
+
+  // setters
+  StreamGeneratorConfiguration& model(GraphModel model);
+  StreamGeneratorConfiguration& num_vertices(node_id_t num_vertices);
+  StreamGeneratorConfiguration& num_edges(edge_id_t num_edges);
+  StreamGeneratorConfiguration& churn(double churn);
+  StreamGeneratorConfiguration& delete_fraction(double delete_fraction);
+  StreamGeneratorConfiguration& rmat_probabilities(double a, double b, double c);
+  StreamGeneratorConfiguration& power_law_exponent(double exponent);
+  StreamGeneratorConfiguration& seed(size_t seed);
+
+  // getters
+  GraphModel get_model() { return _model; }
+  node_id_t get_num_vertices() { return _num_vertices; }
+  edge_id_t get_num_edges() { return _num_edges; }
+  double get_churn() { return _churn; }
+  double get_delete_fraction() { return _delete_fraction; }
+  double get_power_law_exponent() { return _power_law_exponent; }
+  size_t get_seed() { return _seed; }
+
+  friend std::ostream& operator<< (std::ostream &out, const StreamGeneratorConfiguration &conf);
+
+  // no use of equal operator
+  StreamGeneratorConfiguration& operator=(const StreamGeneratorConfiguration &) = delete;
+
+  // moving and copying allowed
+  StreamGeneratorConfiguration(const StreamGeneratorConfiguration &oth) = default;
+  StreamGeneratorConfiguration (StreamGeneratorConfiguration &&) = default;
+};
@@ -0,0 +1,157 @@
+#pragma once
+#include <omp.h>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+
+#include "perf_counters.h"
+#include "tracer.h"
+
+/**
+ * A group of threads that the query algorithms use to run their parallel sections.
+ * When an algorithm is managed by a GraphSketchDriver, the driver's WorkerThreadGroup is the
+ * TaskPool so the same threads perform both sketch updates and queries. Otherwise, the algorithm
+ * falls back to an OmpTaskPool.
+ */
+class TaskPool {
+ public:
+  virtual ~TaskPool() = default;
+
+  /**
+   * Run task(thr_id, num_threads) once on each thread of the pool and wait for all of them to
+   * return. num_threads may be less than get_num_threads(). The task must not throw.
+   */
+  virtual void run(const std::function<void(size_t, size_t)> &task) = 0;
+
+  /**
+   * Wait until every thread running the current task has reached the barrier.
+   * May only be called from within a task.
+   */
+  virtual void barrier() = 0;
+
+  // The maximum number of threads that will run a task
+  virtual size_t get_num_threads() = 0;
+};
+
+/**
+ * A reusable barrier for a fixed group of threads.
+ */
+class SpinBarrier {
+ private:
+  std::atomic<size_t> num_waiting{0};
+  std::atomic<size_t> generation{0};
+  size_t num_threads = 1;
+
+ public:
+  void reset(size_t threads) {
+    num_threads = threads;
+    num_waiting = 0;
+  }
+
+  void wait() {
+    size_t gen = generation.load(std::memory_order_acquire);
+    if (num_waiting.fetch_add(1, std::memory_order_acq_rel) + 1 == num_threads) {
+      // last thread to arrive releases the others
+      num_waiting.store(0, std::memory_order_relaxed);
+      generation.fetch_add(1, std::memory_order_release);
+    } else {
+      while (generation.load(std::memory_order_acquire) == gen) std::this_thread::yield();
+    }
+  }
+};
+
+/**
+ * TaskPool that runs each task in an OpenMP parallel region.
+ */
+class OmpTaskPool : public TaskPool {
+ private:
+  size_t max_threads;  // 0 for as many as OpenMP chooses
+
+ public:
+  OmpTaskPool(size_t max_threads = 0) : max_threads(max_threads) {}
+
+  void run(const std::function<void(size_t, size_t)> &task) override {
+#pragma omp parallel num_threads(get_num_threads())
+    {
+      PerfScope scope = PerfScope::task();
+      TraceScope trace(TRACE_POOL_TASK);
+      task(omp_get_thread_num(), omp_get_num_threads());
+    }
+  }
+
+  // an orphaned barrier binds to the parallel region of the current task
+  void barrier() override {
+#pragma omp barrier
+  }
+
+  size_t get_num_threads() override {
+    return max_threads > 0 ? max_threads : omp_get_max_threads();
+  }
+};
+
+/**
+ * Call body(i) for every i in [begin, end) using the threads of a TaskPool.
+ * Each thread begins with an equal share of the range and takes grain indices at a time from
+ * the front of it. A thread that finishes its share steals the back half of the work remaining
+ * to another thread, so a few expensive indices do not leave the rest of the pool idle.
+ * body must not throw.
+ */
+template <class Body>
+void parallel_for(TaskPool &pool, uint32_t begin, uint32_t end, const Body &body,
+                  uint32_t grain = 64) {
+  if (begin >= end) return;
+
+  // the remaining work of each thread. High 32 bits are the front, low 32 bits are the back.
+  struct alignas(64) WorkRange {
+    std::atomic<uint64_t> range;
+  };
+  auto pack = [](uint64_t front, uint64_t back) { return (front << 32) | back; };
+
+  size_t max_threads = pool.get_num_threads();
+  std::unique_ptr<WorkRange[]> work(new WorkRange[max_threads]);
+  for (size_t t = 0; t < max_threads; t++) work[t].range = 0;
+
+  pool.run([&](size_t thr_id, size_t num_threads) {
+    uint64_t length = end - begin;
+    uint64_t front = begin + length * thr_id / num_threads;
+    uint64_t back = begin + length * (thr_id + 1) / num_threads;
+    work[thr_id].range.store(pack(front, back));
+    pool.barrier();  // every range must be published before anyone tries to steal
+
+    while (true) {
+      // take grain indices from the front of our own range
+      uint64_t cur = work[thr_id].range.load();
+      uint64_t cur_front = cur >> 32;
+      uint64_t cur_back = cur & 0xFFFFFFFF;
+      if (cur_front < cur_back) {
+        uint64_t new_front = std::min(cur_front + grain, cur_back);
+        if (!work[thr_id].range.compare_exchange_weak(cur, pack(new_front, cur_back))) continue;
+        for (uint64_t i = cur_front; i < new_front; i++) body(i);
+        continue;
+      }
+
+      // our range is empty so steal the back half of another thread's range
+      bool stole = false;
+      for (size_t v = 1; v < num_threads && !stole; v++) {
+        WorkRange &victim = work[(thr_id + v) % num_threads];
+        uint64_t vic = victim.range.load();
+        uint64_t vic_front = vic >> 32;
+        uint64_t vic_back = vic & 0xFFFFFFFF;
+        while (vic_back - vic_front > grain && vic_front < vic_back) {
+          uint64_t mid = vic_front + (vic_back - vic_front) / 2;
+          if (victim.range.compare_exchange_weak(vic, pack(vic_front, mid))) {
+            work[thr_id].range.store(pack(mid, vic_back));
+            stole = true;
+            break;
+          }
+          vic_front = vic >> 32;
+          vic_back = vic & 0xFFFFFFFF;
+        }
+      }
+      if (!stole) return;  // nothing worth stealing is left
+    }
+  });
+}
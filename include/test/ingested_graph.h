@@ -0,0 +1,34 @@
+#pragma once
+#include <memory>
+
+#include "cc_sketch_alg.h"
+#include "graph_sketch_driver.h"
+#include "in_memory_stream.h"
+#include "stream_generator.h"
+
+/**
+ * A random graph held in memory and the CCSketchAlg and GraphSketchDriver that ingest it, for
+ * the tests that ingest a small graph and then inspect the driver or algorithm.
+ */
+class IngestedGraph {
+ public:
+  InMemoryStream stream;
+  std::unique_ptr<CCSketchAlg> cc_alg;
+  std::unique_ptr<GraphSketchDriver<CCSketchAlg>> driver;
+
+  IngestedGraph(StreamGeneratorConfiguration gen_config);
+
+  /**
+   * Construct the algorithm and driver, which have not ingested any updates yet.
+   * @param seed  the seed of the algorithm's sketches
+   */
+  void build(size_t seed, CCAlgConfiguration alg_config = CCAlgConfiguration(),
+             DriverConfiguration driver_config = DriverConfiguration(),
+             size_t stream_threads = 1);
+
+  /**
+   * Ingest the whole stream, up to and including the flush of prep_query(CONNECTIVITY).
+   * Builds the algorithm and driver with the default configurations if build() was not called.
+   */
+  void ingest();
+};
@@ -0,0 +1,77 @@
+#pragma once
+#include <graph_stream.h>
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <vector>
+
+/**
+ * Reads a text edge list, such as a SNAP dump, directly as a stream without converting it first.
+ * Each line holds one update:
+ *    src dst           or, if has_type,    type src dst
+ * Values may be separated by spaces, tabs or commas, and further columns such as weights are
+ * ignored. Blank lines and lines starting with '#' or '%' are skipped. type is 0 for an insertion
+ * and 1 for a deletion. Without types every update is an insertion.
+ *
+ * The file is mapped into memory and split into chunks at line boundaries. On construction the
+ * chunks are counted in parallel, then stream threads parse different chunks in parallel.
+ */
+class TextEdgeListStream : public GraphStream {
+ private:
+  std::string file_name;
+  int stream_fd;
+  const char *mapping = nullptr;
+  size_t file_bytes;
+  bool has_type;
+
+  std::vector<size_t> chunk_begin;     // byte offset of each chunk, and the end of the file
+  std::vector<edge_id_t> chunk_first;  // index of the first update of each chunk, and num_edges
+
+  std::atomic<edge_id_t> stream_off{0};  // index of the next unclaimed update
+  std::atomic<edge_id_t> break_index{0};
+
+  // the chunk holding update idx, for idx < num_edges
+  size_t chunk_of(edge_id_t idx) {
+    return std::upper_bound(chunk_first.begin(), chunk_first.end(), idx) - chunk_first.begin() - 1;
+  }
+  // split the file into chunks and count the updates of each
+  void index_chunks(size_t chunk_bytes, bool find_vertices);
+  // parse count updates of a chunk, after skipping the first skip updates
+  void parse_chunk(size_t chunk, edge_id_t skip, edge_id_t count, GraphStreamUpdate *out);
+  // parse the update on the line [p, line_end)
+  void parse_update(const char *p, const char *line_end, GraphStreamUpdate &out);
+
+ public:
+  /**
+   * @param file_name     the edge list to read.
+   * @param num_vertices  [Optional] the number of vertices. If 0, one more than the largest vertex
+   *                      id, which requires parsing the whole file on construction (default = 0).
+   * @param has_type      [Optional] does each line begin with the update type (default = false).
+   * @param chunk_bytes   [Optional] the approximate size of each chunk (default = 32 KiB).
+   * @throws StreamException if the file cannot be opened or contains a malformed line, or if
+   *         num_vertices is 0 and a vertex id is the largest node_id_t.
+   */
+  TextEdgeListStream(const std::string &file_name, node_id_t num_vertices = 0,
+                     bool has_type = false, size_t chunk_bytes = 32 * 1024);
+  ~TextEdgeListStream();
+
+  /**
+   * Parse the next updates of the stream. This function is thread-safe. Claims end on a chunk
+   * boundary where possible, so that no chunk is parsed more than once.
+   * @throws StreamException if a line is malformed.
+   */
+  size_t get_update_buffer(GraphStreamUpdate *upd_buf, size_t num_updates) override;
+
+  /**
+   * Parse the updates [begin, end) of the stream, regardless of the stream position and
+   * breakpoint. This function is thread-safe.
+   * @throws StreamException if a line is malformed.
+   */
+  void get_updates(edge_id_t begin, edge_id_t end, GraphStreamUpdate *out);
+
+  bool get_update_is_thread_safe() override { return true; }
+  void seek(edge_id_t edge_idx) override { stream_off = std::min(edge_idx, num_edges); }
+  bool set_break_point(edge_id_t break_idx) override;
+  void serialize_metadata(std::ostream &out) override;
+};
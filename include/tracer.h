@@ -0,0 +1,98 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// The spans of ingestion and queries the Tracer records
+enum TraceEvent {
+  TRACE_STREAM_READ,        // a stream thread reading a buffer of updates. arg: updates read
+  TRACE_BATCH_APPLY,        // a worker applying a batch of updates. arg: updates in the batch
+  TRACE_GUTTER_FLUSH,       // forcing the gutters of a partition to flush. arg: partition
+  TRACE_PREP_QUERY_FLUSH,   // prep_query() flushing the gutters and waiting for the workers
+  TRACE_BORUVKA_ROUND,      // one Boruvka round of a query. arg: round
+  TRACE_POOL_TASK,          // a thread running its part of a TaskPool task
+  NUM_TRACE_EVENTS
+};
+
+const char *trace_event_name(TraceEvent event);
+
+/**
+ * Optional tracer that records a timeline of ingestion and queries and writes it in the Chrome
+ * trace event format, viewable in chrome://tracing or https://ui.perfetto.dev. Each thread
+ * records spans into its own fixed size ring buffer, so recording takes no locks and the most
+ * recent spans of each thread are kept.
+ *
+ * Tracing is compiled out unless ENABLE_TRACING is defined. Without it TraceScope is empty and
+ * costs nothing. When compiled in, it is still disabled until enable() is called.
+ */
+class Tracer {
+ private:
+  static std::atomic<bool> is_enabled;
+
+ public:
+  static void enable(bool enable = true) { is_enabled.store(enable, std::memory_order_relaxed); }
+  static bool enabled() { return is_enabled.load(std::memory_order_relaxed); }
+
+  // The number of spans each thread keeps. Applies to threads that have not yet recorded any.
+  static void set_thread_capacity(size_t num_spans);
+
+  // Name the calling thread in the trace, for example "worker 3"
+  static void set_thread_name(const std::string &name);
+
+  static uint64_t now_ns() {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+  }
+
+  // Record a span of the calling thread
+  static void record(TraceEvent event, uint64_t begin_ns, uint64_t end_ns, uint64_t arg);
+
+  /**
+   * Discard every recorded span. Recording takes no locks, so this may only be called while no
+   * thread is tracing, for example before enable() or while the traced threads are idle.
+   */
+  static void clear();
+
+  /**
+   * Write the recorded spans of every thread, including threads that have exited, as Chrome
+   * trace event JSON. Spans being recorded while writing may be torn, so call this while the
+   * traced threads are idle, for example after a query.
+   */
+  static void write_chrome_trace(std::ostream &out);
+  static void write_chrome_trace(const std::string &filename);
+};
+
+#ifdef ENABLE_TRACING
+/**
+ * Records a span of the calling thread from construction to destruction.
+ */
+class TraceScope {
+ private:
+  TraceEvent event;
+  uint64_t arg;
+  uint64_t begin_ns = 0;
+
+ public:
+  TraceScope(TraceEvent event, uint64_t arg = 0) : event(event), arg(arg) {
+    if (Tracer::enabled()) begin_ns = Tracer::now_ns();
+  }
+  ~TraceScope() {
+    if (begin_ns != 0) Tracer::record(event, begin_ns, Tracer::now_ns(), arg);
+  }
+  TraceScope(const TraceScope &) = delete;
+  TraceScope &operator=(const TraceScope &) = delete;
+
+  // Set the argument of the span, if it is only known once the span has begun
+  void set_arg(uint64_t new_arg) { arg = new_arg; }
+};
+#else
+// Tracing is compiled out
+class TraceScope {
+ public:
+  TraceScope(TraceEvent, uint64_t = 0) {}
+  void set_arg(uint64_t) {}
+};
+#endif
@@ -0,0 +1,78 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "types.h"
+
+/**
+ * A small direct mapped window of recent stream updates, local to a single stream thread.
+ * Sketch updates are XORs, so an insertion and deletion of the same edge cancel. When an update
+ * finds its opposite in the window, both are dropped before reaching the guttering system.
+ * Any other update that maps to an occupied slot evicts the update in the slot, which is then
+ * passed on as usual.
+ */
+class UpdateCancellationCache {
+ private:
+  struct Slot {
+    GraphUpdate upd;
+    bool occupied = false;
+  };
+  std::vector<Slot> slots;
+  size_t slot_mask;
+  size_t num_cancelled = 0;  // number of updates dropped
+
+  static uint64_t edge_key(const Edge &edge) {
+    return (uint64_t(std::min(edge.src, edge.dst)) << 32) | std::max(edge.src, edge.dst);
+  }
+  size_t slot_of(uint64_t key) const {
+    // fibonacci hashing spreads the key across the high bits
+    return ((key * 0x9E3779B97F4A7C15ULL) >> 32) & slot_mask;
+  }
+
+ public:
+  /**
+   * @param num_slots  size of the window. Rounded up to a power of two.
+   */
+  UpdateCancellationCache(size_t num_slots) {
+    size_t size = 1;
+    while (size < num_slots) size *= 2;
+    slots.resize(size);
+    slot_mask = size - 1;
+  }
+
+  /**
+   * Add an update to the window.
+   * @param upd   the update.
+   * @param emit  called with any update that must be passed on now.
+   */
+  template <class Emit>
+  void insert(const GraphUpdate &upd, Emit &&emit) {
+    uint64_t key = edge_key(upd.edge);
+    Slot &slot = slots[slot_of(key)];
+    if (slot.occupied && edge_key(slot.upd.edge) == key && slot.upd.type != upd.type) {
+      slot.occupied = false;
+      num_cancelled += 2;
+      return;
+    }
+    if (slot.occupied) emit(slot.upd);
+    slot.upd = upd;
+    slot.occupied = true;
+  }
+
+  // Pass on every update remaining in the window and empty it
+  template <class Emit>
+  void flush(Emit &&emit) {
+    for (Slot &slot : slots) {
+      if (slot.occupied) emit(slot.upd);
+      slot.occupied = false;
+    }
+  }
+
+  // Returns the number of updates dropped since the last call
+  size_t take_num_cancelled() {
+    size_t ret = num_cancelled;
+    num_cancelled = 0;
+    return ret;
+  }
+};
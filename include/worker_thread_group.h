@@ -1,15 +1,39 @@
 #pragma once
-#include <condition_variable>
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <functional>
 #include <mutex>
 #include <thread>
+#include <vector>
 
+#include "futex_word.h"
+#include "numa_topology.h"
 #include "sketch.h"
+#include "task_pool.h"
 
 // forward declarations
 template<class Alg>
 class GraphSketchDriver;
+template<class Alg>
+class WorkerThreadGroup;
 class GutteringSystem;
 
+// A task posted by the WorkerThreadGroup for its paused WorkerThreads to run
+struct WorkerTask {
+  const std::function<void(size_t, size_t)> *func = nullptr;
+  std::atomic<size_t> id{0};        // incremented each time a new task is posted
+  std::atomic<size_t> num_done{0};  // number of WorkerThreads that have finished the current task
+};
+
+// A portion of a large batch of updates that any WorkerThread may apply
+struct SplitBatch {
+  node_id_t src_vertex;
+  const node_id_t *dst_begin;
+  const node_id_t *dst_end;
+  std::atomic<size_t> *remaining;  // number of portions of the batch left to apply
+};
+
 /**
  * This class manages a thread of execution for performing sketch updates
  */
@@ -19,18 +43,18 @@ class WorkerThread {
   /**
    * Create a WorkerThread object by setting metadata and spinning up a thread.
    * @param _id       the id of the new WorkerThread.
+   * @param _group    the WorkerThreadGroup that coordinates this WorkerThread.
    * @param _driver   the sketch algorithm driver this WorkerThread works for.
    * @param _gts      Guttering system to pull batches of updates from.
-   * @param cond      a reference to the condition variable that coordinates the workers
-   * @param lk        a reference to the lock that coordinates the workers
+   * @param _first_vertex  the vertex that gutter 0 of the guttering system belongs to.
    */
-  WorkerThread(int _id, GraphSketchDriver<Alg> *_driver, GutteringSystem *_gts,
-               std::condition_variable &cond, std::mutex &lk)
+  WorkerThread(int _id, WorkerThreadGroup<Alg> *_group, GraphSketchDriver<Alg> *_driver,
+               GutteringSystem *_gts, node_id_t _first_vertex)
       : id(_id),
+        group(_group),
         driver(_driver),
         gts(_gts),
-        flush_condition(cond),
-        flush_lock(lk),
+        first_vertex(_first_vertex),
         thr(start_worker, this) {}
   ~WorkerThread() {
     // join the WorkerThread thread to reclaim resources
@@ -38,14 +62,12 @@ class WorkerThread {
   }
 
   void pause() { do_pause = true; }
-  void unpause() {
-    do_pause = false;
-    paused = false;
-  }
+  void unpause() { do_pause = false; }
 
   void stop() { shutdown = true; }
 
-  bool check_paused() { return paused; }
+  // restrict this WorkerThread to a single CPU. Returns true if successful.
+  bool pin(int cpu) { return NumaTopology::pin_thread(thr, cpu); }
 
  private:
 
@@ -61,8 +83,12 @@ class WorkerThread {
 
   // function which runs the WorkerThread process
   void do_work() {
+    Tracer::set_thread_name("worker " + std::to_string(id));
     WorkQueue::DataNode *data;
     while (true) {
+      // the epoch, counted in resumes, in which we are checking the guttering system for work
+      uint32_t epoch = group->get_epoch();
+
       // call get_data which will handle waiting on the queue
       // and will enforce locking.
       bool valid = gts->get_data(data);
@@ -70,32 +96,87 @@ class WorkerThread {
       if (valid) {
         const std::vector<update_batch> &batches = data->get_batches();
         for (auto &batch : batches) {
-          if (batch.upd_vec.size() > 0) driver->batch_callback(id, batch.node_idx, batch.upd_vec);
+          if (batch.upd_vec.size() > 0)
+            process_batch(batch.node_idx + first_vertex, batch.upd_vec);
         }
         gts->get_data_callback(data);  // inform guttering system that we're done
       } else if (shutdown)
         return;
       else if (do_pause) {
-        std::unique_lock<std::mutex> lk(flush_lock);
-        paused = true;                 // this thread is currently paused
-        flush_condition.notify_all();  // notify that we are paused
-
-        // wait until flush finished
-        flush_condition.wait(lk, [&] { return !do_pause || shutdown; });
-        paused = false;  // no longer paused
-        lk.unlock();
-        flush_condition.notify_all();  // notify that we are unpaused
+        // this thread is currently paused. The last worker to pause completes the flush.
+        ++group->idle_workers;
+        if (group->count_paused(epoch)) group->flush_word.notify_all();
+
+        // wait until flush finished, helping other workers and running any tasks given to us
+        // in the meantime
+        while (true) {
+          uint32_t state = group->state_word.load();
+          if (!do_pause || shutdown || group->get_epoch() != epoch) break;
+
+          if (group->split_pending > 0) {
+            group->apply_split_batch(id, split_scratch);
+          } else if (group->task.id != last_task) {
+            last_task = group->task.id;
+            {
+              PerfScope scope = PerfScope::task();
+              TraceScope trace(TRACE_POOL_TASK);
+              (*group->task.func)(id, group->num_workers);
+            }
+            if (++group->task.num_done == group->num_workers) group->task_word.notify_all();
+          } else {
+            group->state_word.wait(state);
+          }
+        }
+        --group->idle_workers;  // no longer paused
       }
     }
   }
+
+  /**
+   * Apply a batch of updates. If the batch is large and other workers are paused, or will soon be
+   * because we are flushing, split it so they can apply portions of it with their own scratch
+   * memory. Only paused workers pick up portions. A worker waiting for a batch sleeps inside the
+   * guttering system, which we cannot wake, so outside of a flush or pause batches are not split.
+   */
+  void process_batch(node_id_t src_vertex, const std::vector<node_id_t> &dst_vertices) {
+    size_t min_split = group->min_split_updates;
+    size_t helpers = group->flushing ? group->num_workers - 1 : group->idle_workers.load();
+    if (helpers == 0 || dst_vertices.size() < 2 * min_split) {
+      driver->batch_callback(id, src_vertex, dst_vertices);
+      return;
+    }
+
+    size_t num_parts = std::min(helpers + 1, dst_vertices.size() / min_split);
+    size_t part_size = (dst_vertices.size() + num_parts - 1) / num_parts;
+    std::atomic<size_t> remaining(num_parts - 1);
+    const node_id_t *begin = dst_vertices.data();
+    const node_id_t *end = begin + dst_vertices.size();
+    {
+      std::lock_guard<std::mutex> lk(group->split_lock);
+      for (const node_id_t *part = begin + part_size; part < end; part += part_size)
+        group->split_queue.push_back(
+            {src_vertex, part, std::min(part + part_size, end), &remaining});
+      group->split_pending += num_parts - 1;
+    }
+    group->state_word.notify_all();
+
+    // apply the first portion ourselves and then help until the rest of the batch is applied
+    split_scratch.assign(begin, begin + part_size);
+    driver->batch_callback(id, src_vertex, split_scratch);
+    while (remaining > 0) {
+      if (!group->apply_split_batch(id, split_scratch)) std::this_thread::yield();
+    }
+  }
+
   const int id;
+  WorkerThreadGroup<Alg> *group;
   GraphSketchDriver<Alg> *driver;
   GutteringSystem *gts;
-  std::condition_variable &flush_condition;
-  std::mutex &flush_lock;
-  bool shutdown = false;
-  bool do_pause = false;
-  bool paused = false;
+  node_id_t first_vertex;
+  size_t last_task = 0;  // id of the last task we ran
+  std::vector<node_id_t> split_scratch;  // holds the portion of a split batch we are applying
+  std::atomic<bool> shutdown{false};
+  std::atomic<bool> do_pause{false};
 
   // The thread that performs the work
   std::thread thr;
@@ -103,67 +184,187 @@ class WorkerThread {
 
 /**
  * This class manages a group of worker threads. Allowing the driver to start/flush/stop them.
+ * While flushed, the workers act as a TaskPool that runs the parallel portions of queries.
  */
 template<class Alg>
-class WorkerThreadGroup {
+class WorkerThreadGroup : public TaskPool {
  private:
+  friend class WorkerThread<Alg>;
+
   // list of all WorkerThreads
   WorkerThread<Alg> **workers;
   size_t num_workers;
-  GutteringSystem *gts;
+  GraphSketchDriver<Alg> *driver;
+  // the guttering system of each partition of the vertices. Worker i pulls batches from
+  // partition i % gts.size()
+  std::vector<GutteringSystem *> gts;
+
+  // Workers sleep on state_word while paused. It is notified whenever the workers are resumed,
+  // stopped, given a task, or given portions of a split batch.
+  FutexWord state_word;
+
+  // The high 32 bits are the epoch, incremented each time the workers are resumed. The low 32
+  // bits are the number of workers that have paused during this epoch. A worker only counts
+  // itself if it found the guttering system empty during the current epoch.
+  std::atomic<uint64_t> pause_state{0};
+  FutexWord flush_word;  // notified when the last worker pauses
+  FutexWord task_word;   // notified when the last worker finishes a task
+
+  WorkerTask task;
+  SpinBarrier task_barrier;
+  OmpTaskPool busy_pool;  // runs tasks while the workers are not flushed
+  bool busy_task = false;  // is the current task running on busy_pool
+  bool flushed = false;              // are the workers paused and able to run tasks
+  std::atomic<bool> flushing{false};  // is the driver flushing updates to the workers
+
+  // portions of large batches waiting to be applied. Protected by split_lock.
+  std::deque<SplitBatch> split_queue;
+  std::mutex split_lock;
+  std::atomic<size_t> split_pending{0};  // size of split_queue
+  std::atomic<size_t> idle_workers{0};  // number of paused workers, which apply split batches
+  size_t min_split_updates;             // minimum number of updates in a portion of a batch
+
+  uint32_t get_epoch() { return pause_state.load() >> 32; }
+
+  // Count a worker as paused in epoch. Returns true if it was the last worker to pause.
+  bool count_paused(uint32_t epoch) {
+    uint64_t cur = pause_state.load();
+    while ((cur >> 32) == epoch) {
+      if (pause_state.compare_exchange_weak(cur, cur + 1))
+        return (cur & 0xFFFFFFFF) + 1 == num_workers;
+    }
+    return false;  // the workers were resumed, so this pause is stale
+  }
 
-  std::condition_variable flush_condition;
-  std::mutex flush_lock;
+  /**
+   * Apply one portion of a split batch, if there are any.
+   * @param thr_id    id of the calling WorkerThread.
+   * @param scratch   vector used to hold the updates of the portion.
+   * @return          true if we applied a portion.
+   */
+  bool apply_split_batch(int thr_id, std::vector<node_id_t> &scratch) {
+    SplitBatch split;
+    {
+      std::lock_guard<std::mutex> lk(split_lock);
+      if (split_queue.empty()) return false;
+      split = split_queue.front();
+      split_queue.pop_front();
+      --split_pending;
+    }
+    scratch.assign(split.dst_begin, split.dst_end);
+    driver->batch_callback(thr_id, split.src_vertex, scratch);
+    --*split.remaining;
+    return true;
+  }
 
  public:
-  WorkerThreadGroup(size_t num_workers, GraphSketchDriver<Alg> *driver, GutteringSystem *gts)
-      : num_workers(num_workers), gts(gts) {
+  /**
+   * @param num_workers        the number of WorkerThreads to create.
+   * @param driver             the driver the WorkerThreads work for.
+   * @param gts                the guttering system of each partition of the vertices.
+   * @param partition_first    the first vertex of each partition.
+   * @param min_split_updates  batches are only split into portions of at least this many updates.
+   */
+  WorkerThreadGroup(size_t num_workers, GraphSketchDriver<Alg> *driver,
+                    const std::vector<GutteringSystem *> &gts,
+                    const std::vector<node_id_t> &partition_first, size_t min_split_updates)
+      : num_workers(num_workers),
+        driver(driver),
+        gts(gts),
+        busy_pool(num_workers),
+        min_split_updates(std::max(min_split_updates, (size_t)1)) {
     workers = new WorkerThread<Alg> *[num_workers];
     for (size_t i = 0; i < num_workers; i++) {
-      workers[i] = new WorkerThread<Alg>(i, driver, gts, flush_condition, flush_lock);
+      size_t p = i % gts.size();
+      workers[i] = new WorkerThread<Alg>(i, this, driver, gts[p], partition_first[p]);
     }
   }
   ~WorkerThreadGroup() {
-    gts->set_non_block(true);  // make the WorkerThreads bypass waiting in queue
+    // make the WorkerThreads bypass waiting in queue
+    for (GutteringSystem *partition : gts) partition->set_non_block(true);
 
     for (size_t i = 0; i < num_workers; i++) workers[i]->stop();
 
-    flush_condition.notify_all();  // tell any paused threads to continue and exit
+    state_word.notify_all();  // tell any paused threads to continue and exit
     for (size_t i = 0; i < num_workers; i++) delete workers[i];
     delete[] workers;
   }
 
+  /**
+   * Pin each WorkerThread to its own CPU, spreading the workers across the NUMA nodes. Worker i
+   * is pinned to node i % num_nodes, so with partitioned ingestion it runs on the node that owns
+   * its partition.
+   * @return  true if every worker was pinned.
+   */
+  bool pin_workers(const NumaTopology &topology) {
+    bool success = true;
+    for (size_t i = 0; i < num_workers; i++)
+      success &= workers[i]->pin(topology.cpu_for_thread(i));
+    return success;
+  }
+
+  /**
+   * Tell the workers that the driver is about to flush the guttering system. Until they are
+   * resumed, the workers split large batches so the flush is not held up by a single worker.
+   */
+  void begin_flush() { flushing = true; }
+
   void flush_workers() {
-    gts->set_non_block(true);  // make the WorkerThreads bypass waiting in queue
+    // make the WorkerThreads bypass waiting in queue
+    for (GutteringSystem *partition : gts) partition->set_non_block(true);
     for (size_t i = 0; i < num_workers; i++) workers[i]->pause();
 
     // wait until all WorkerThreads are flushed
     while (true) {
-      std::unique_lock<std::mutex> lk(flush_lock);
-      flush_condition.wait_for(lk, std::chrono::milliseconds(500), [&] {
-        for (size_t i = 0; i < num_workers; i++)
-          if (!workers[i]->check_paused()) return false;
-        return true;
-      });
-
-      // double check that we didn't get a spurious wake-up
-      bool all_paused = true;
-      for (size_t i = 0; i < num_workers; i++) {
-        if (!workers[i]->check_paused()) {
-          all_paused = false;  // a worker still working so don't stop
-          break;
-        }
-      }
-      lk.unlock();
-
-      if (all_paused) break;  // all workers are done so exit
+      uint32_t state = flush_word.load();
+      if ((pause_state.load() & 0xFFFFFFFF) == num_workers) break;
+      flush_word.wait(state);
     }
+    flushed = true;
   }
   void resume_workers() {
-    // unpause the WorkerThreads
+    flushed = false;
+    flushing = false;
+    // make WorkerThreads wait on the queue
+    for (GutteringSystem *partition : gts) partition->set_non_block(false);
+
+    // unpause the WorkerThreads and begin a new epoch in which none of them are paused
     for (size_t i = 0; i < num_workers; i++) workers[i]->unpause();
+    pause_state = (uint64_t)(get_epoch() + 1) << 32;
+    state_word.notify_all();
+  }
+
+  /**
+   * Run a task on every WorkerThread. If the workers are not flushed, they may be blocked
+   * waiting for updates, so the task instead runs in an OpenMP parallel region of at most as
+   * many threads as there are workers.
+   */
+  void run(const std::function<void(size_t, size_t)> &func) override {
+    if (!flushed) {
+      busy_task = true;
+      busy_pool.run(func);
+      busy_task = false;
+      return;
+    }
 
-    gts->set_non_block(false); // make WorkerThreads wait on the queue
-    flush_condition.notify_all();
+    task_barrier.reset(num_workers);
+    task.func = &func;
+    task.num_done = 0;
+    ++task.id;
+    state_word.notify_all();
+    while (true) {
+      uint32_t state = task_word.load();
+      if (task.num_done == num_workers) break;
+      task_word.wait(state);
+    }
   }
+
+  void barrier() override {
+    if (busy_task)
+      busy_pool.barrier();
+    else
+      task_barrier.wait();
+  }
+
+  size_t get_num_threads() override { return num_workers; }
 };
@@ -0,0 +1,328 @@
+#include "async_binary_stream.h"
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+
+/**
+ * A minimal io_uring submission and completion queue, driven by a single thread.
+ */
+class UringReader {
+ private:
+  int ring_fd = -1;
+  void *sq_ring = MAP_FAILED;
+  void *cq_ring = MAP_FAILED;
+  io_uring_sqe *sqes = (io_uring_sqe *)MAP_FAILED;
+  size_t sq_ring_bytes = 0;
+  size_t cq_ring_bytes = 0;
+  size_t sqes_bytes = 0;
+
+  unsigned *sq_head;
+  unsigned *sq_tail;
+  unsigned *sq_mask;
+  unsigned *sq_array;
+  unsigned *cq_head;
+  unsigned *cq_tail;
+  unsigned *cq_mask;
+  io_uring_cqe *cqes;
+
+  int enter(unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0);
+  }
+
+ public:
+  ~UringReader() {
+    if (sqes != MAP_FAILED) munmap(sqes, sqes_bytes);
+    if (cq_ring != MAP_FAILED && cq_ring != sq_ring) munmap(cq_ring, cq_ring_bytes);
+    if (sq_ring != MAP_FAILED) munmap(sq_ring, sq_ring_bytes);
+    if (ring_fd >= 0) close(ring_fd);
+  }
+
+  // Returns false if the kernel does not allow io_uring
+  bool init(unsigned entries) {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring_fd = syscall(__NR_io_uring_setup, entries, &params);
+    if (ring_fd < 0) return false;
+
+    sq_ring_bytes = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_bytes = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) sq_ring_bytes = cq_ring_bytes = std::max(sq_ring_bytes, cq_ring_bytes);
+    sqes_bytes = params.sq_entries * sizeof(io_uring_sqe);
+
+    sq_ring = mmap(nullptr, sq_ring_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                   ring_fd, IORING_OFF_SQ_RING);
+    if (sq_ring == MAP_FAILED) return false;
+    cq_ring = single_mmap ? sq_ring
+                          : mmap(nullptr, cq_ring_bytes, PROT_READ | PROT_WRITE,
+                                 MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+    if (cq_ring == MAP_FAILED) return false;
+    sqes = (io_uring_sqe *)mmap(nullptr, sqes_bytes, PROT_READ | PROT_WRITE,
+                                MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) return false;
+
+    sq_head = (unsigned *)((char *)sq_ring + params.sq_off.head);
+    sq_tail = (unsigned *)((char *)sq_ring + params.sq_off.tail);
+    sq_mask = (unsigned *)((char *)sq_ring + params.sq_off.ring_mask);
+    sq_array = (unsigned *)((char *)sq_ring + params.sq_off.array);
+    cq_head = (unsigned *)((char *)cq_ring + params.cq_off.head);
+    cq_tail = (unsigned *)((char *)cq_ring + params.cq_off.tail);
+    cq_mask = (unsigned *)((char *)cq_ring + params.cq_off.ring_mask);
+    cqes = (io_uring_cqe *)((char *)cq_ring + params.cq_off.cqes);
+    return true;
+  }
+
+  // Returns false if the read could not be submitted
+  bool submit_read(int fd, void *buf, unsigned len, uint64_t offset, uint64_t user_data) {
+    unsigned tail = *sq_tail;
+    unsigned idx = tail & *sq_mask;
+    io_uring_sqe *sqe = &sqes[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)buf;
+    sqe->len = len;
+    sqe->off = offset;
+    sqe->user_data = user_data;
+    sq_array[idx] = idx;
+    __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+    if (enter(1, 0, 0) == 1) return true;
+
+    // the kernel consumed the entry after all, so the read is in flight
+    if (__atomic_load_n(sq_head, __ATOMIC_ACQUIRE) != tail) return true;
+    // withdraw the entry, or the next submission would also submit this read into a buffer the
+    // caller is about to fill with pread and later reuse
+    __atomic_store_n(sq_tail, tail, __ATOMIC_RELEASE);
+    return false;
+  }
+
+  // Wait for a read to complete. res is the number of bytes read or a negative errno.
+  void wait_completion(uint64_t &user_data, int &res) {
+    while (true) {
+      unsigned head = *cq_head;
+      if (head != __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE)) {
+        io_uring_cqe *cqe = &cqes[head & *cq_mask];
+        user_data = cqe->user_data;
+        res = cqe->res;
+        __atomic_store_n(cq_head, head + 1, __ATOMIC_RELEASE);
+        return;
+      }
+      enter(0, 1, IORING_ENTER_GETEVENTS);
+    }
+  }
+};
+
+AsyncBinaryStream::AsyncBinaryStream(const std::string &file_name, size_t num_buffers,
+                                     size_t buffer_bytes, bool use_io_uring)
+    : file_name(file_name), num_buffers(std::max(num_buffers, (size_t)1)) {
+  stream_fd = open(file_name.c_str(), O_RDONLY);
+  if (stream_fd < 0) throw StreamException("AsyncBinaryStream: could not open " + file_name);
+  if (pread(stream_fd, &num_vertices, sizeof(num_vertices), 0) != sizeof(num_vertices) ||
+      pread(stream_fd, &num_edges, sizeof(num_edges), sizeof(num_vertices)) != sizeof(num_edges)) {
+    close(stream_fd);
+    throw StreamException("AsyncBinaryStream: could not read header of " + file_name);
+  }
+  posix_fadvise(stream_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+  buffer_updates = std::max(buffer_bytes / edge_size, (size_t)1);
+  num_blocks = (num_edges + buffer_updates - 1) / buffer_updates;
+  buffers.reset(new Buffer[this->num_buffers]);
+  for (size_t i = 0; i < this->num_buffers; i++) {
+    buffers[i].data = (char *)aligned_alloc(4096, (buffer_updates * edge_size + 4095) / 4096 * 4096);
+    if (buffers[i].data == nullptr) throw std::bad_alloc();
+  }
+
+  if (use_io_uring) {
+    uring.reset(new UringReader());
+    uring_enabled = uring->init(this->num_buffers);
+    if (!uring_enabled) uring.reset();
+  }
+  break_index = num_edges;
+  start_io(0);
+}
+
+AsyncBinaryStream::~AsyncBinaryStream() {
+  end_io();
+  for (size_t i = 0; i < num_buffers; i++) free(buffers[i].data);
+  close(stream_fd);
+}
+
+void AsyncBinaryStream::start_io(edge_id_t first_update) {
+  for (size_t i = 0; i < num_buffers; i++) {
+    buffers[i].block = no_block;
+    buffers[i].consumed = 0;
+    buffers[i].free = true;
+  }
+  // the updates of the first block before first_update will never be claimed
+  edge_id_t first_block = first_update / buffer_updates;
+  buffers[first_block % num_buffers].consumed = first_update % buffer_updates;
+  stop_io = false;
+  io_error = false;
+  io_thread = std::thread(&AsyncBinaryStream::io_loop, this, first_block);
+}
+
+void AsyncBinaryStream::end_io() {
+  stop_io = true;
+  free_word.notify_all();
+  io_thread.join();
+}
+
+bool AsyncBinaryStream::read_buffer(size_t buf_idx) {
+  Buffer &buf = buffers[buf_idx];
+  size_t bytes = block_length(buf.reading_block) * edge_size;
+  uint64_t offset = header_size + buf.reading_block * buffer_updates * edge_size + buf.filled;
+  if (uring_enabled)
+    return uring->submit_read(stream_fd, buf.data + buf.filled, bytes - buf.filled, offset,
+                              buf_idx);
+
+  ssize_t res = pread(stream_fd, buf.data + buf.filled, bytes - buf.filled, offset);
+  if (res <= 0) return false;
+  buf.filled += res;
+  return true;
+}
+
+void AsyncBinaryStream::io_loop(edge_id_t first_block) {
+  edge_id_t next_block = first_block;
+  size_t in_flight = 0;
+  std::deque<size_t> pread_done;  // buffers whose pread finished, when not using io_uring
+
+  while (true) {
+    // start reading blocks into every free buffer, in order
+    while (!stop_io && !io_error && next_block < num_blocks) {
+      size_t buf_idx = next_block % num_buffers;
+      Buffer &buf = buffers[buf_idx];
+      if (!buf.free) break;
+      buf.free = false;
+      buf.filled = 0;
+      buf.reading_block = next_block++;
+      if (!uring_enabled) {
+        // read the whole block before announcing it
+        size_t bytes = block_length(buf.reading_block) * edge_size;
+        while (buf.filled < bytes && read_buffer(buf_idx)) continue;
+        if (buf.filled < bytes) {
+          io_error = true;
+          ready_word.notify_all();
+          break;
+        }
+        pread_done.push_back(buf_idx);
+        in_flight++;
+        break;  // announce it before reading more
+      }
+      if (!read_buffer(buf_idx)) {
+        // io_uring refused the read, so fall back to pread from here on
+        uring_enabled = false;
+        buf.free = true;
+        next_block--;
+        continue;
+      }
+      in_flight++;
+    }
+
+    if (in_flight == 0) {
+      if (stop_io || io_error || next_block >= num_blocks) return;
+      // wait for the buffer of the next block to be consumed
+      uint32_t state = free_word.load();
+      if (!stop_io && !buffers[next_block % num_buffers].free) free_word.wait(state);
+      continue;
+    }
+
+    // wait for a read to complete
+    size_t buf_idx;
+    if (!pread_done.empty()) {
+      buf_idx = pread_done.front();
+      pread_done.pop_front();
+    } else {
+      uint64_t user_data;
+      int res;
+      uring->wait_completion(user_data, res);
+      buf_idx = user_data;
+      Buffer &buf = buffers[buf_idx];
+      size_t bytes = block_length(buf.reading_block) * edge_size;
+      if (res > 0) buf.filled += res;
+      if (res < 0 && !stop_io) {
+        // the kernel may not support this operation, so finish with pread from here on
+        uring_enabled = false;
+      }
+      if (buf.filled < bytes && (res > 0 || !uring_enabled) && !stop_io) {
+        // short read. Read the rest of the block.
+        if (uring_enabled) {
+          if (read_buffer(buf_idx)) continue;
+          uring_enabled = false;
+        }
+        while (buf.filled < bytes) {
+          if (!read_buffer(buf_idx)) break;
+        }
+      }
+      if (buf.filled < bytes && !stop_io) {
+        // keep collecting the other completions so no read targets freed memory
+        io_error = true;
+        ready_word.notify_all();
+        in_flight--;
+        continue;
+      }
+    }
+    in_flight--;
+    buffers[buf_idx].block = buffers[buf_idx].reading_block;
+    ready_word.notify_all();
+  }
+}
+
+size_t AsyncBinaryStream::get_update_buffer(GraphStreamUpdate *upd_buf, size_t num_updates) {
+  // claim updates up to the breakpoint and the end of a block
+  edge_id_t begin = stream_off.load();
+  edge_id_t end;
+  do {
+    edge_id_t break_idx = break_index.load();
+    if (begin >= break_idx) {
+      upd_buf[0] = {BREAKPOINT, {0, 0}};
+      return 1;
+    }
+    edge_id_t block_end = (begin / buffer_updates + 1) * buffer_updates;
+    end = std::min({begin + num_updates, break_idx, block_end});
+  } while (!stream_off.compare_exchange_weak(begin, end));
+
+  edge_id_t block = begin / buffer_updates;
+  Buffer &buf = buffers[block % num_buffers];
+  while (true) {
+    uint32_t state = ready_word.load();
+    if (buf.block == block) break;
+    if (io_error) throw StreamException("AsyncBinaryStream: could not read " + file_name);
+    ready_word.wait(state);
+  }
+
+  memcpy(upd_buf, buf.data + (begin - block * buffer_updates) * edge_size,
+         (end - begin) * edge_size);
+  if (buf.consumed.fetch_add(end - begin) + (end - begin) == block_length(block)) {
+    // the block has been consumed so the buffer may be refilled
+    buf.consumed = 0;
+    buf.block = no_block;
+    buf.free = true;
+    free_word.notify_all();
+  }
+  return end - begin;
+}
+
+void AsyncBinaryStream::seek(edge_id_t edge_idx) {
+  end_io();
+  stream_off = std::min(edge_idx, num_edges);
+  start_io(stream_off);
+}
+
+bool AsyncBinaryStream::set_break_point(edge_id_t break_idx) {
+  break_idx = std::min(break_idx, num_edges);
+  if (break_idx < stream_off) return false;
+  break_index = break_idx;
+  return true;
+}
+
+void AsyncBinaryStream::serialize_metadata(std::ostream &out) {
+  out << "AsyncBinaryStream " << file_name << std::endl;
+}
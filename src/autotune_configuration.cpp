@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <iostream>
+#include <thread>
+
+#include "autotune_configuration.h"
+
+AutotuneConfiguration& AutotuneConfiguration::total_threads(size_t num_threads) {
+  _total_threads = num_threads;
+  return *this;
+}
+
+AutotuneConfiguration& AutotuneConfiguration::calibration_updates(size_t num_updates) {
+  _calibration_updates = num_updates;
+  if (_calibration_updates < 1024) {
+    std::cout << "calibration_updates=" << _calibration_updates << " is out of bounds. "
+              << "[1024, infty) Defaulting to 1024." << std::endl;
+    _calibration_updates = 1024;
+  }
+  return *this;
+}
+
+AutotuneConfiguration& AutotuneConfiguration::repetitions(size_t repetitions) {
+  _repetitions = repetitions;
+  if (_repetitions < 1) {
+    std::cout << "repetitions=" << _repetitions << " is out of bounds. [1, infty)"
+              << "Defaulting to 1." << std::endl;
+    _repetitions = 1;
+  }
+  return *this;
+}
+
+AutotuneConfiguration& AutotuneConfiguration::batch_factors(std::vector<double> factors) {
+  _batch_factors.clear();
+  for (double factor : factors) {
+    if (factor <= 0)
+      std::cout << "batch factor=" << factor << " is out of bounds. (0, infty) Ignoring."
+                << std::endl;
+    else
+      _batch_factors.push_back(factor);
+  }
+  if (_batch_factors.empty()) {
+    std::cout << "No valid batch factors. Defaulting to {1}." << std::endl;
+    _batch_factors = {1};
+  }
+  return *this;
+}
+
+AutotuneConfiguration& AutotuneConfiguration::gutter_scales(std::vector<double> scales) {
+  _gutter_scales.clear();
+  for (double scale : scales) {
+    if (scale <= 0)
+      std::cout << "gutter scale=" << scale << " is out of bounds. (0, infty) Ignoring."
+                << std::endl;
+    else
+      _gutter_scales.push_back(scale);
+  }
+  if (_gutter_scales.empty()) {
+    std::cout << "No valid gutter scales. Defaulting to {1}." << std::endl;
+    _gutter_scales = {1};
+  }
+  return *this;
+}
+
+AutotuneConfiguration& AutotuneConfiguration::seed(size_t seed) {
+  _seed = seed;
+  return *this;
+}
+
+AutotuneConfiguration& AutotuneConfiguration::memory_budget(size_t budget_bytes) {
+  _memory_budget = budget_bytes;
+  return *this;
+}
+
+size_t AutotuneConfiguration::get_total_threads() {
+  if (_total_threads > 0) return _total_threads;
+  return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+static void print_candidates(std::ostream &out, const std::vector<double> &candidates) {
+  out << "{";
+  for (size_t i = 0; i < candidates.size(); i++)
+    out << (i > 0 ? ", " : "") << candidates[i];
+  out << "}";
+}
+
+std::ostream& operator<< (std::ostream &out, const AutotuneConfiguration &conf) {
+    out << "Autotuner Configuration:" << std::endl;
+    if (conf._total_threads == 0)
+      out << " Total threads         = All" << std::endl;
+    else
+      out << " Total threads         = " << conf._total_threads << std::endl;
+    out << " Calibration updates   = " << conf._calibration_updates << std::endl;
+    out << " Repetitions           = " << conf._repetitions << std::endl;
+    out << " Batch factors         = ";
+    print_candidates(out, conf._batch_factors);
+    out << std::endl;
+    out << " Gutter scales         = ";
+    print_candidates(out, conf._gutter_scales);
+    out << std::endl;
+    if (conf._memory_budget == 0)
+      out << " Memory budget         = None" << std::endl;
+    else
+      out << " Memory budget         = " << conf._memory_budget << std::endl;
+    out << " Seed                  = " << conf._seed;
+    return out;
+  }
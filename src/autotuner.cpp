@@ -0,0 +1,157 @@
+#include "autotuner.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "cc_sketch_alg.h"
+#include "graph_sketch_driver.h"
+#include "in_memory_stream.h"
+#include "memory_budget.h"
+#include "stream_generator.h"
+
+Autotuner::Autotuner(AutotuneConfiguration config) : config(config) {}
+
+std::vector<std::pair<size_t, size_t>> Autotuner::thread_splits(size_t total_threads) {
+  // a few stream threads keep many workers busy, so powers of two up to half the threads
+  std::vector<std::pair<size_t, size_t>> splits;
+  for (size_t stream_threads = 1; stream_threads == 1 || 2 * stream_threads <= total_threads;
+       stream_threads *= 2) {
+    size_t workers = total_threads > stream_threads ? total_threads - stream_threads : 1;
+    splits.emplace_back(workers, stream_threads);
+  }
+  return splits;
+}
+
+void Autotuner::run_trial(node_id_t num_vertices, const std::vector<GraphStreamUpdate> &updates,
+                          const DriverConfiguration &base_driver_config,
+                          const CCAlgConfiguration &base_alg_config, AutotuneTrial &trial) {
+  trial.updates_per_second = 0;
+  for (size_t rep = 0; rep < config._repetitions; rep++) {
+    DriverConfiguration driver_config = base_driver_config;
+    CCAlgConfiguration alg_config = base_alg_config;
+    alg_config.batch_factor(trial.batch_factor);
+    driver_config.worker_threads(trial.worker_threads);
+    // every calibration run constructs a driver, which would print its configuration
+    driver_config.quiet(true);
+
+    InMemoryStream stream(num_vertices, updates.data(), updates.size());
+    CCSketchAlg cc_alg{num_vertices, config._seed + rep, alg_config};
+    size_t batch_bytes = cc_alg.get_desired_updates_per_batch() * sizeof(node_id_t);
+    trial.gutter_bytes = std::max(size_t(batch_bytes * trial.gutter_scale), sizeof(node_id_t));
+    driver_config.gutter_conf().gutter_bytes(trial.gutter_bytes);
+    GraphSketchDriver<CCSketchAlg> driver(&cc_alg, &stream, driver_config, trial.stream_threads);
+
+    // the flush of prep_query is included, since smaller gutters flush faster
+    auto start = std::chrono::steady_clock::now();
+    driver.process_stream_until(END_OF_STREAM);
+    driver.prep_query(CONNECTIVITY);
+    std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+    trial.updates_per_second =
+        std::max(trial.updates_per_second, updates.size() / std::max(seconds.count(), 1e-9));
+  }
+}
+
+AutotuneResult Autotuner::tune_updates(node_id_t num_vertices,
+                                       const std::vector<GraphStreamUpdate> &updates,
+                                       const DriverConfiguration &base_driver_config,
+                                       const CCAlgConfiguration &base_alg_config) {
+  // with a memory budget, tune the configuration that fits it and skip candidates that do not
+  DriverConfiguration planned_driver_config = base_driver_config;
+  CCAlgConfiguration planned_alg_config = base_alg_config;
+  if (config._memory_budget > 0)
+    MemoryBudget(num_vertices, config._memory_budget)
+        .plan(planned_driver_config, planned_alg_config);
+  double sketches_factor = planned_alg_config.get_sketches_factor();
+  auto fits_budget = [&](size_t workers, size_t stream_threads, double batch_factor,
+                         double scale) {
+    if (config._memory_budget == 0) return true;
+    size_t batch_bytes = MemoryBudget::batch_bytes(num_vertices, batch_factor, sketches_factor);
+    size_t gutter_bytes = std::max(size_t(batch_bytes * scale), sizeof(node_id_t));
+    MemoryBudget budget(num_vertices, config._memory_budget, stream_threads);
+    return budget.estimate(planned_driver_config.get_gutter_sys(), workers, gutter_bytes,
+                           sketches_factor).total() <= config._memory_budget;
+  };
+
+  std::vector<AutotuneTrial> trials;
+  size_t best = 0;
+  // measure a candidate unless an earlier parameter already did, and keep it if it is fastest
+  auto measure = [&](size_t workers, size_t stream_threads, double batch_factor, double scale) {
+    for (const AutotuneTrial &trial : trials) {
+      if (trial.worker_threads == workers && trial.stream_threads == stream_threads &&
+          trial.batch_factor == batch_factor && trial.gutter_scale == scale)
+        return;
+    }
+    if (!fits_budget(workers, stream_threads, batch_factor, scale)) return;
+    AutotuneTrial trial{workers, stream_threads, batch_factor, scale, 0, 0};
+    run_trial(num_vertices, updates, planned_driver_config, planned_alg_config, trial);
+    trials.push_back(trial);
+    if (trial.updates_per_second > trials[best].updates_per_second) best = trials.size() - 1;
+  };
+
+  double base_batch_factor = planned_alg_config.get_batch_factor();
+  for (auto split : thread_splits(config.get_total_threads()))
+    measure(split.first, split.second, base_batch_factor, 1);
+  // the planned configuration fits the budget with a single stream thread
+  if (trials.empty())
+    measure(planned_driver_config.get_worker_threads(), 1, base_batch_factor, 1);
+
+  for (double batch_factor : config._batch_factors)
+    measure(trials[best].worker_threads, trials[best].stream_threads, batch_factor, 1);
+
+  for (double scale : config._gutter_scales)
+    measure(trials[best].worker_threads, trials[best].stream_threads, trials[best].batch_factor,
+            scale);
+
+  AutotuneTrial winner = trials[best];
+  DriverConfiguration driver_config = planned_driver_config;
+  driver_config.worker_threads(winner.worker_threads);
+  driver_config.gutter_conf().gutter_bytes(winner.gutter_bytes);
+  CCAlgConfiguration alg_config = planned_alg_config;
+  alg_config.batch_factor(winner.batch_factor);
+  return {driver_config, alg_config, winner.stream_threads, winner, trials};
+}
+
+AutotuneResult Autotuner::tune(GraphStream &stream, const DriverConfiguration &base_driver_config,
+                               const CCAlgConfiguration &base_alg_config) {
+  std::vector<GraphStreamUpdate> updates;
+  std::vector<GraphStreamUpdate> buf(4096);
+  stream.seek(0);
+  stream.set_break_point(config._calibration_updates);
+  bool done = false;
+  while (!done && updates.size() < config._calibration_updates) {
+    size_t wanted = std::min(buf.size(), config._calibration_updates - updates.size());
+    size_t num_read = stream.get_update_buffer(buf.data(), wanted);
+    for (size_t i = 0; i < num_read && !done; i++) {
+      if (buf[i].type == BREAKPOINT)
+        done = true;
+      else
+        updates.push_back(buf[i]);
+    }
+  }
+  stream.seek(0);
+  stream.set_break_point(END_OF_STREAM);
+
+  return tune_updates(stream.vertices(), updates, base_driver_config, base_alg_config);
+}
+
+AutotuneResult Autotuner::tune_synthetic(node_id_t num_vertices,
+                                         const DriverConfiguration &base_driver_config,
+                                         const CCAlgConfiguration &base_alg_config) {
+  auto gen_config = StreamGeneratorConfiguration()
+                        .num_vertices(num_vertices)
+                        .num_edges(config._calibration_updates)
+                        .seed(config._seed);
+  std::vector<GraphStreamUpdate> updates = StreamGenerator(gen_config).get_updates();
+  return tune_updates(num_vertices, updates, base_driver_config, base_alg_config);
+}
+
+std::ostream& operator<< (std::ostream &out, const AutotuneResult &result) {
+    out << "Autotuner Result:" << std::endl;
+    out << " Worker thread count   = " << result.best.worker_threads << std::endl;
+    out << " Stream thread count   = " << result.best.stream_threads << std::endl;
+    out << " Batch size factor     = " << result.best.batch_factor << std::endl;
+    out << " Gutter bytes          = " << result.best.gutter_bytes << std::endl;
+    out << " Updates per second    = " << result.best.updates_per_second << std::endl;
+    out << " Calibration runs      = " << result.trials.size();
+    return out;
+  }
@@ -27,6 +27,16 @@ CCAlgConfiguration& CCAlgConfiguration::batch_factor(double factor) {
   return *this;
 }
 
+CCAlgConfiguration& CCAlgConfiguration::merge_mode(BoruvkaMergeMode mode) {
+  _merge_mode = mode;
+  return *this;
+}
+
+CCAlgConfiguration& CCAlgConfiguration::exhaustive_sampling(bool exhaustive) {
+  _exhaustive_sampling = exhaustive;
+  return *this;
+}
+
 std::ostream& operator<< (std::ostream &out, const CCAlgConfiguration &conf) {
     out << "Connected Components Algorithm Configuration:" << std::endl;
 #ifdef L0_SAMPLING
@@ -41,6 +51,12 @@ std::ostream& operator<< (std::ostream &out, const CCAlgConfiguration &conf) {
 #endif
     out << " Num sketches factor   = " << conf._sketches_factor << std::endl;
     out << " Batch size factor     = " << conf._batch_factor << std::endl;
+    if (conf._merge_mode == IN_PLACE_MERGE)
+      out << " Boruvka merge mode    = InPlace" << std::endl;
+    else
+      out << " Boruvka merge mode    = RemergeChildren" << std::endl;
+    out << " Exhaustive sampling   = " << (conf._exhaustive_sampling ? "True" : "False")
+        << std::endl;
     out << " On disk data location = " << conf._disk_dir;
     return out;
   }
@@ -5,7 +5,6 @@
 #include <iostream>
 #include <map>
 #include <random>
-#include <omp.h>
 #include <unordered_map>
 
 CCSketchAlg::CCSketchAlg(node_id_t num_vertices, size_t seed, CCAlgConfiguration config)
@@ -16,10 +15,8 @@ CCSketchAlg::CCSketchAlg(node_id_t num_vertices, size_t seed, CCAlgConfiguration
   vec_t sketch_vec_len = Sketch::calc_vector_length(num_vertices);
   size_t sketch_num_samples = Sketch::calc_cc_samples(num_vertices, config.get_sketches_factor());
 
-  for (node_id_t i = 0; i < num_vertices; ++i) {
-    representatives->insert(i);
-    sketches[i] = new Sketch(sketch_vec_len, seed, sketch_num_samples);
-  }
+  allocate_sketch_arena(sketch_vec_len, sketch_num_samples);
+  for (node_id_t i = 0; i < num_vertices; ++i) representatives->insert(i);
 
   spanning_forest = new std::unordered_set<node_id_t>[num_vertices];
   spanning_forest_mtx = new std::mutex[num_vertices];
@@ -42,10 +39,8 @@ CCSketchAlg::CCSketchAlg(node_id_t num_vertices, bool cuda_uvm, size_t seed, Buc
     }
   }
   else {
-    for (node_id_t i = 0; i < num_vertices; ++i) {
-      representatives->insert(i);
-      sketches[i] = new Sketch(sketch_vec_len, seed, sketch_num_samples);
-    }
+    allocate_sketch_arena(sketch_vec_len, sketch_num_samples);
+    for (node_id_t i = 0; i < num_vertices; ++i) representatives->insert(i);
   }
 
   spanning_forest = new std::unordered_set<node_id_t>[num_vertices];
@@ -78,9 +73,10 @@ CCSketchAlg::CCSketchAlg(node_id_t num_vertices, size_t seed, std::ifstream &bin
   vec_t sketch_vec_len = Sketch::calc_vector_length(num_vertices);
   size_t sketch_num_samples = Sketch::calc_cc_samples(num_vertices, config.get_sketches_factor());
 
+  allocate_sketch_arena(sketch_vec_len, sketch_num_samples);
   for (node_id_t i = 0; i < num_vertices; ++i) {
     representatives->insert(i);
-    sketches[i] = new Sketch(sketch_vec_len, seed, binary_stream, sketch_num_samples);
+    binary_stream.read((char *)sketches[i]->get_bucket_ptr(), sketches[i]->bucket_array_bytes());
   }
   binary_stream.close();
 
@@ -93,9 +89,11 @@ CCSketchAlg::CCSketchAlg(node_id_t num_vertices, size_t seed, std::ifstream &bin
 CCSketchAlg::~CCSketchAlg() {
   for (size_t i = 0; i < num_vertices; ++i) delete sketches[i];
   delete[] sketches;
+  NumaTopology::free_pages(sketch_arena, sketch_arena_bytes);
   if (delta_sketches != nullptr) {
     for (size_t i = 0; i < num_delta_sketches; i++) delete delta_sketches[i];
     delete[] delta_sketches;
+    NumaTopology::free_pages(delta_arena, delta_stride_bytes * num_delta_sketches);
   }
 
   delete representatives;
@@ -103,6 +101,46 @@ CCSketchAlg::~CCSketchAlg() {
   delete[] spanning_forest_mtx;
 }
 
+void CCSketchAlg::allocate_sketch_arena(vec_t sketch_vec_len, size_t sketch_num_samples) {
+  size_t num_buckets = Sketch::calc_num_buckets(sketch_vec_len, sketch_num_samples);
+  sketch_arena_bytes = num_buckets * sizeof(Bucket) * num_vertices;
+  sketch_arena = (Bucket *)NumaTopology::allocate_pages(sketch_arena_bytes);
+  for (node_id_t i = 0; i < num_vertices; ++i)
+    sketches[i] = new Sketch(sketch_vec_len, seed, i, sketch_arena, sketch_num_samples);
+}
+
+void CCSketchAlg::apply_numa_policy(const NumaPolicy &policy) {
+  const NumaTopology &topology = *policy.topology;
+  bool success = true;
+  if (sketch_arena != nullptr && policy.placement == INTERLEAVE) {
+    success = topology.interleave_memory(sketch_arena, sketch_arena_bytes);
+  } else if (sketch_arena != nullptr && policy.placement == PARTITION) {
+    size_t num_nodes = topology.num_nodes();
+    for (size_t node = 0; node < num_nodes; node++) {
+      node_id_t first = NumaTopology::partition_begin(node, num_vertices, num_nodes);
+      node_id_t last = NumaTopology::partition_begin(node + 1, num_vertices, num_nodes);
+      if (first == last) continue;
+      Bucket *begin = sketches[first]->get_bucket_ptr();
+      size_t bytes = sketches[first]->bucket_array_bytes() * (last - first);
+      success &= NumaTopology::bind_memory(begin, bytes, topology.get_node_id(node));
+    }
+  }
+  if (!success)
+    std::cerr << "WARNING: Could not place the vertex sketches across NUMA nodes" << std::endl;
+
+  if (policy.local_worker_memory && delta_arena != nullptr) {
+    success = true;
+    for (size_t i = 0; i < num_delta_sketches && i < policy.worker_nodes.size(); i++) {
+      char *delta = (char *)delta_arena + i * delta_stride_bytes;
+      int node = topology.get_node_id(policy.worker_nodes[i]);
+      success &= NumaTopology::bind_memory(delta, delta_stride_bytes, node);
+    }
+    if (!success)
+      std::cerr << "WARNING: Could not place the delta sketches on their workers' NUMA nodes"
+                << std::endl;
+  }
+}
+
 void CCSketchAlg::pre_insert(GraphUpdate upd, int /* thr_id */) {
 #ifdef NO_EAGER_DSU
   (void)upd;
@@ -133,6 +171,7 @@ void CCSketchAlg::pre_insert(GraphUpdate upd, int /* thr_id */) {
 void CCSketchAlg::apply_update_batch(int thr_id, node_id_t src_vertex,
                                      const std::vector<node_id_t> &dst_vertices) {
   if (update_locked) throw UpdateLockedException();
+  PerfScope scope(PERF_APPLY_UPDATE_BATCH);
   Sketch &delta_sketch = *delta_sketches[thr_id];
   delta_sketch.zero_contents();
 
@@ -140,6 +179,7 @@ void CCSketchAlg::apply_update_batch(int thr_id, node_id_t src_vertex,
     delta_sketch.update(static_cast<vec_t>(concat_pairing_fn(src_vertex, dst)));
   }
 
+  PerfScope merge_scope(PERF_DELTA_MERGE);
   std::lock_guard<std::mutex> lk(sketches[src_vertex]->mutex);
   sketches[src_vertex]->merge(delta_sketch);
 }
@@ -162,36 +202,59 @@ void CCSketchAlg::update(GraphUpdate upd) {
 // sample from a sketch that represents a supernode of vertices
 // that is, 1 or more vertices merged together during Boruvka
 inline bool CCSketchAlg::sample_supernode(Sketch &skt) {
+  if (config._exhaustive_sampling) return exhaustive_sample_supernode(skt);
+
   bool modified = false;
   SketchSample sample = skt.sample();
 
   Edge e = inv_concat_pairing_fn(sample.idx);
   SampleResult result_type = sample.result;
+  sample_counts.increment(result_type);
 
   // std::cout << " " << result_type << " e:" << e.src << " " << e.dst << std::endl;
 
   if (result_type == FAIL) {
     modified = true;
   } else if (result_type == GOOD) {
-    DSUMergeRet<node_id_t> m_ret = dsu.merge(e.src, e.dst);
-    if (m_ret.merged) {
-#ifdef VERIFY_SAMPLES_F
-      verifier->verify_edge(e);
-#endif
-      modified = true;
-      // Update spanning forest
-      auto src = std::min(e.src, e.dst);
-      auto dst = std::max(e.src, e.dst);
-      {
-        std::lock_guard<std::mutex> lk(spanning_forest_mtx[src]);
-        spanning_forest[src].insert(dst);
-      }
+    if (merge_sampled_edge(e)) modified = true;
+  }
+
+  return modified;
+}
+
+inline bool CCSketchAlg::exhaustive_sample_supernode(Sketch &skt) {
+  bool modified = false;
+  ExhaustiveSketchSample sample = skt.exhaustive_sample();
+  sample_counts.increment(sample.result);
+
+  if (sample.result == FAIL) {
+    modified = true;
+  } else if (sample.result == GOOD) {
+    for (vec_t idx : sample.idxs) {
+      if (merge_sampled_edge(inv_concat_pairing_fn(idx))) modified = true;
     }
   }
 
   return modified;
 }
 
+inline bool CCSketchAlg::merge_sampled_edge(Edge e) {
+  DSUMergeRet<node_id_t> m_ret = dsu.merge(e.src, e.dst);
+  if (!m_ret.merged) return false;
+
+#ifdef VERIFY_SAMPLES_F
+  verifier->verify_edge(e);
+#endif
+  // Update spanning forest
+  auto src = std::min(e.src, e.dst);
+  auto dst = std::max(e.src, e.dst);
+  {
+    std::lock_guard<std::mutex> lk(spanning_forest_mtx[src]);
+    spanning_forest[src].insert(dst);
+  }
+  return true;
+}
+
 /*
  * Returns the ith half-open range in the division of [0, length] into divisions segments.
  */
@@ -248,20 +311,20 @@ inline bool merge_global(const size_t cur_round, const Sketch &local_sketch,
 
 // faster query procedure optimized for when we know there is no merging to do (i.e. round 0)
 inline bool CCSketchAlg::run_round_zero() {
-  bool modified = false;
+  std::atomic<bool> modified(false);
   bool except = false;
   std::exception_ptr err;
-#pragma omp parallel for
-  for (node_id_t i = 0; i < num_vertices; i++) {
+  std::mutex err_lock;
+  parallel_for(*task_pool, 0, num_vertices, [&](node_id_t i) {
     try {
       // num_query += 1;
       if (sample_supernode(*sketches[i]) && !modified) modified = true;
     } catch (...) {
+      std::lock_guard<std::mutex> lk(err_lock);
       except = true;
-#pragma omp critical
       err = std::current_exception();
     }
-  }
+  });
   if (except) {
     // if one of our threads produced an exception throw it here
     std::rethrow_exception(err);
@@ -277,23 +340,21 @@ bool CCSketchAlg::perform_boruvka_round(const size_t cur_round,
     return run_round_zero();
   }
 
-  bool modified = false;
+  std::atomic<bool> modified(false);
   bool except = false;
   std::exception_ptr err;
+  std::mutex err_lock;
   for (size_t i = 0; i < global_merges.size(); i++) {
     global_merges[i].sketch.zero_contents();
     global_merges[i].num_merge_needed = -1;
     global_merges[i].num_merge_done = 0;
   }
 
-#pragma omp parallel default(shared)
-  {
+  task_pool->run([&](size_t thr_id, size_t num_threads) {
     // some thread local variables
     Sketch local_sketch(Sketch::calc_vector_length(num_vertices), seed,
                         Sketch::calc_cc_samples(num_vertices, config.get_sketches_factor()));
 
-    size_t thr_id = omp_get_thread_num();
-    size_t num_threads = omp_get_num_threads();
     std::pair<node_id_t, node_id_t> partition = get_ith_partition(num_vertices, thr_id, num_threads);
     node_id_t start = partition.first;
     node_id_t end = partition.second;
@@ -390,11 +451,11 @@ bool CCSketchAlg::perform_boruvka_round(const size_t cur_round,
       }
     }
     if (local_except) {
-#pragma omp critical
+      std::lock_guard<std::mutex> lk(err_lock);
       err = local_err;
       except = true;
     }
-  }
+  });
 
   // std::cout << "Number of roots queried = " << num_query << std::endl;
 
@@ -408,16 +469,13 @@ bool CCSketchAlg::perform_boruvka_round(const size_t cur_round,
 
 inline void CCSketchAlg::create_merge_instructions(std::vector<MergeInstr> &merge_instr) {
   std::vector<node_id_t> cc_prefix(num_vertices, 0);
-  node_id_t range_sums[omp_get_max_threads()];
+  std::vector<node_id_t> range_sums(task_pool->get_num_threads());
 
-#pragma omp parallel default(shared)
-  {
+  task_pool->run([&](size_t thr_id, size_t num_threads) {
     // thread local variables
     std::unordered_map<node_id_t, std::vector<node_id_t>> local_ccs;
     std::vector<node_id_t> local_cc_idx;
 
-    size_t thr_id = omp_get_thread_num();
-    size_t num_threads = omp_get_num_threads();
     std::pair<node_id_t, node_id_t> partition = get_ith_partition(num_vertices, thr_id, num_threads);
     node_id_t start = partition.first;
     node_id_t end = partition.second;
@@ -437,29 +495,27 @@ inline void CCSketchAlg::create_merge_instructions(std::vector<MergeInstr> &merg
       node_id_t root = cc.first;
       const std::vector<node_id_t> &vertices = cc.second;
 
-      node_id_t idx;
-#pragma omp atomic capture
-      {idx = cc_prefix[root]; cc_prefix[root] += vertices.size(); }
+      node_id_t idx = __atomic_fetch_add(&cc_prefix[root], vertices.size(), __ATOMIC_RELAXED);
 
       local_cc_idx.push_back(idx);
     }
-#pragma omp barrier
+    task_pool->barrier();
 
     // perform a prefix sum over cc_prefix
     for (node_id_t i = start + 1; i < end; i++) {
       cc_prefix[i] += cc_prefix[i-1];
     }
-#pragma omp barrier
+    task_pool->barrier();
 
     // perform single threaded prefix sum of the resulting sums from each thread
-#pragma omp single
-    {
+    if (thr_id == 0) {
       range_sums[0] = 0;
-      for (int t = 1; t < omp_get_num_threads(); t++) {
+      for (size_t t = 1; t < num_threads; t++) {
         node_id_t cur = get_ith_partition(num_vertices, t - 1, num_threads).second - 1;
         range_sums[t] = cc_prefix[cur] + range_sums[t - 1];
       }
     }
+    task_pool->barrier();
 
     // in parallel finish the prefix sums
     if (thr_id > 0) {
@@ -467,7 +523,7 @@ inline void CCSketchAlg::create_merge_instructions(std::vector<MergeInstr> &merg
         cc_prefix[i] += range_sums[thr_id];
       }
     }
-#pragma omp barrier
+    task_pool->barrier();
 
     // Finally, write the local_ccs to the correct portion of the merge_instr array
     node_id_t i = 0;
@@ -485,17 +541,42 @@ inline void CCSketchAlg::create_merge_instructions(std::vector<MergeInstr> &merg
       }
       i++;
     }
-  }
+  });
+}
+
+QueryRoundStats CCSketchAlg::take_round_stats(double seconds) {
+  QueryRoundStats stats;
+  stats.seconds = seconds;
+  stats.good_samples = sample_counts.get(GOOD);
+  stats.zero_samples = sample_counts.get(ZERO);
+  stats.fail_samples = sample_counts.get(FAIL);
+  sample_counts.reset();
+  return stats;
+}
+
+void CCSketchAlg::publish_query_stats(std::vector<QueryRoundStats> &&round_stats) {
+  std::chrono::duration<double> query_time = std::chrono::steady_clock::now() - cc_alg_start;
+  std::lock_guard<std::mutex> lk(query_stats_mtx);
+  ++query_stats.queries;
+  // a count of rounds, unlike last_query_rounds which is the index of the last round
+  query_stats.last_query_rounds = round_stats.size();
+  query_stats.last_query_seconds = query_time.count();
+  query_stats.last_query_round_stats = std::move(round_stats);
 }
 
 void CCSketchAlg::boruvka_emulation() {
+  if (config._merge_mode == IN_PLACE_MERGE) {
+    in_place_boruvka_emulation();
+    return;
+  }
+
   // auto start = std::chrono::steady_clock::now();
   update_locked = true;
 
   cc_alg_start = std::chrono::steady_clock::now();
   std::vector<MergeInstr> merge_instr(num_vertices);
 
-  size_t num_threads = omp_get_max_threads();
+  size_t num_threads = task_pool->get_num_threads();
   std::vector<GlobalMergeData> global_merges;
   global_merges.reserve(num_threads);
   for (size_t i = 0; i < num_threads; i++) {
@@ -514,25 +595,178 @@ void CCSketchAlg::boruvka_emulation() {
   //             << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()
   //             << std::endl;
 
+  last_query_round_times.clear();
+  last_query_merge_instr_times.clear();
+  std::vector<QueryRoundStats> round_stats;
+  sample_counts.reset();
   while (true) {
     // std::cout << "   Round: " << round_num << std::endl;
     // start = std::chrono::steady_clock::now();
-    modified = perform_boruvka_round(round_num, merge_instr, global_merges);
+    TraceScope trace(TRACE_BORUVKA_ROUND, round_num);
+    auto round_start = std::chrono::steady_clock::now();
+    {
+      PerfTaskPhase perf_phase(PERF_BORUVKA_ROUND, round_num);
+      modified = perform_boruvka_round(round_num, merge_instr, global_merges);
+    }
     // std::cout << "     perform_boruvka_round = "
     //           << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()
     //           << std::endl;
 
-    if (!modified) break;
+    if (modified) {
+      // calculate updated merge instructions for next round
+      auto merge_start = std::chrono::steady_clock::now();
+      PerfTaskPhase perf_phase(PERF_MERGE_INSTRUCTIONS, round_num);
+      create_merge_instructions(merge_instr);
+      std::chrono::duration<double> merge_time = std::chrono::steady_clock::now() - merge_start;
+      last_query_merge_instr_times.push_back(merge_time.count());
+    }
+    std::chrono::duration<double> round_time = std::chrono::steady_clock::now() - round_start;
+    last_query_round_times.push_back(round_time.count());
+    round_stats.push_back(take_round_stats(round_time.count()));
 
-    // calculate updated merge instructions for next round
-    // start = std::chrono::steady_clock::now();
-    create_merge_instructions(merge_instr);
-    // std::cout << "     create_merge_instructions = "
-    //           << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()
-    //           << std::endl;
+    if (!modified) break;
     ++round_num;
   }
   last_query_rounds = round_num;
+  publish_query_stats(std::move(round_stats));
+
+  dsu_valid = true;
+  shared_dsu_valid = true;
+  update_locked = false;
+}
+
+inline bool CCSketchAlg::sample_roots(const std::vector<node_id_t> &roots) {
+  std::atomic<bool> modified(false);
+  bool except = false;
+  std::exception_ptr err;
+  std::mutex err_lock;
+  parallel_for(*task_pool, 0, roots.size(), [&](size_t i) {
+    try {
+      if (sample_supernode(*sketches[roots[i]]) && !modified) modified = true;
+    } catch (...) {
+      std::lock_guard<std::mutex> lk(err_lock);
+      except = true;
+      err = std::current_exception();
+    }
+  });
+  if (except) {
+    // if one of our threads produced an exception throw it here
+    std::rethrow_exception(err);
+  }
+
+  return modified;
+}
+
+void CCSketchAlg::apply_root_merges(size_t first_sample, const std::vector<MergeInstr> &merges) {
+  size_t n_samples = max_rounds() - first_sample;
+
+  task_pool->run([&](size_t thr_id, size_t num_threads) {
+    std::pair<node_id_t, node_id_t> partition = get_ith_partition(merges.size(), thr_id, num_threads);
+    node_id_t start = partition.first;
+    node_id_t end = partition.second;
+
+    // only allocated if we share a root with a neighboring thread
+    std::unique_ptr<Sketch> local_sketch;
+
+    node_id_t i = start;
+    while (i < end) {
+      node_id_t root = merges[i].root;
+      node_id_t run_end = i;
+      while (run_end < end && merges[run_end].root == root) ++run_end;
+
+      bool shared_root = (i == start && start > 0 && merges[start - 1].root == root) ||
+                         (run_end == end && end < merges.size() && merges[end].root == root);
+      if (shared_root) {
+        // other threads merge into this root as well, so merge locally and then into the root
+        if (local_sketch == nullptr)
+          local_sketch.reset(
+              new Sketch(Sketch::calc_vector_length(num_vertices), seed,
+                         Sketch::calc_cc_samples(num_vertices, config.get_sketches_factor())));
+        else
+          local_sketch->zero_contents();
+
+        for (node_id_t j = i; j < run_end; j++)
+          local_sketch->range_merge(*sketches[merges[j].child], first_sample, n_samples);
+
+        std::lock_guard<std::mutex> lk(sketches[root]->mutex);
+        sketches[root]->range_merge(*local_sketch, first_sample, n_samples);
+      } else {
+        // we are the only thread that merges into this root
+        for (node_id_t j = i; j < run_end; j++)
+          sketches[root]->range_merge(*sketches[merges[j].child], first_sample, n_samples);
+      }
+      i = run_end;
+    }
+  });
+}
+
+void CCSketchAlg::in_place_boruvka_emulation() {
+  update_locked = true;
+
+  cc_alg_start = std::chrono::steady_clock::now();
+  std::vector<node_id_t> roots(num_vertices);
+
+  dsu.reset();
+  for (node_id_t i = 0; i < num_vertices; ++i) {
+    roots[i] = i;
+    spanning_forest[i].clear();
+  }
+
+  // the merges performed in each round. Used to restore the vertex sketches when we are done.
+  std::vector<std::vector<MergeInstr>> merge_log;
+  size_t round_num = 0;
+  bool except = false;
+  std::exception_ptr err;
+  last_query_round_times.clear();
+  last_query_merge_instr_times.clear();
+  std::vector<QueryRoundStats> round_stats;
+  sample_counts.reset();
+  try {
+    while (true) {
+      TraceScope trace(TRACE_BORUVKA_ROUND, round_num);
+      auto round_start = std::chrono::steady_clock::now();
+      PerfTaskPhase perf_phase(PERF_BORUVKA_ROUND, round_num);
+      if (!sample_roots(roots)) {
+        std::chrono::duration<double> round_time = std::chrono::steady_clock::now() - round_start;
+        last_query_round_times.push_back(round_time.count());
+        round_stats.push_back(take_round_stats(round_time.count()));
+        break;
+      }
+
+      // merge the supernodes that were joined this round into the sketch of their new root
+      std::vector<MergeInstr> merges;
+      std::vector<node_id_t> new_roots;
+      for (node_id_t old_root : roots) {
+        node_id_t root = dsu.find_root(old_root);
+        if (root == old_root)
+          new_roots.push_back(root);
+        else
+          merges.push_back({root, old_root});
+      }
+      std::sort(merges.begin(), merges.end());
+      apply_root_merges(round_num + 1, merges);
+
+      merge_log.push_back(std::move(merges));
+      roots = std::move(new_roots);
+
+      std::chrono::duration<double> round_time = std::chrono::steady_clock::now() - round_start;
+      last_query_round_times.push_back(round_time.count());
+      round_stats.push_back(take_round_stats(round_time.count()));
+      ++round_num;
+    }
+  } catch (...) {
+    except = true;
+    err = std::current_exception();
+  }
+
+  // undo the merges, latest round first, to return the sketches to their original state
+  for (size_t r = merge_log.size(); r > 0; r--) {
+    apply_root_merges(r, merge_log[r - 1]);
+  }
+  if (except) std::rethrow_exception(err);
+
+  last_query_rounds = round_num;
+  publish_query_stats(std::move(round_stats));
 
   dsu_valid = true;
   shared_dsu_valid = true;
@@ -575,7 +809,10 @@ ConnectedComponents CCSketchAlg::connected_components() {
     if (except) std::rethrow_exception(err);
   }
 
-  ConnectedComponents cc(num_vertices, dsu);
+  auto build_start = std::chrono::steady_clock::now();
+  ConnectedComponents cc(num_vertices, dsu, *task_pool);
+  std::chrono::duration<double> build_time = std::chrono::steady_clock::now() - build_start;
+  last_cc_build_time = build_time.count();
 #ifdef VERIFY_SAMPLES_F
   verifier->verify_connected_components(cc);
 #endif
@@ -587,7 +824,10 @@ SpanningForest CCSketchAlg::calc_spanning_forest() {
   // TODO: Could probably optimize this a bit by writing new code
   connected_components();
 
+  auto build_start = std::chrono::steady_clock::now();
   SpanningForest ret(num_vertices, spanning_forest);
+  std::chrono::duration<double> build_time = std::chrono::steady_clock::now() - build_start;
+  last_sf_build_time = build_time.count();
 #ifdef VERIFY_SAMPLES_F
   verifier->verify_spanning_forests(std::vector<SpanningForest>{ret});
 #endif
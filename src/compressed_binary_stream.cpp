@@ -0,0 +1,225 @@
+#include "compressed_binary_stream.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+
+static inline uint64_t zigzag(int64_t x) { return ((uint64_t)x << 1) ^ (uint64_t)(x >> 63); }
+static inline int64_t unzigzag(uint64_t x) { return (int64_t)(x >> 1) ^ -(int64_t)(x & 1); }
+
+static inline uint8_t *put_varint(uint8_t *out, uint64_t x) {
+  while (x >= 0x80) {
+    *out++ = (uint8_t)x | 0x80;
+    x >>= 7;
+  }
+  *out++ = (uint8_t)x;
+  return out;
+}
+
+// Returns nullptr if the varint runs past end
+static inline const uint8_t *get_varint(const uint8_t *in, const uint8_t *end, uint64_t &x) {
+  // most values fit in a single byte
+  if (in < end && *in < 0x80) {
+    x = *in;
+    return in + 1;
+  }
+  x = 0;
+  for (int shift = 0; in < end && shift < 64; shift += 7) {
+    uint8_t byte = *in++;
+    x |= (uint64_t)(byte & 0x7f) << shift;
+    if (byte < 0x80) return in;
+  }
+  return nullptr;
+}
+
+CompressedBinaryStream::CompressedBinaryStream(const std::string &file_name)
+    : file_name(file_name) {
+  stream_fd = open(file_name.c_str(), O_RDONLY);
+  if (stream_fd < 0) throw StreamException("CompressedBinaryStream: could not open " + file_name);
+
+  struct stat st;
+  if (fstat(stream_fd, &st) != 0 || (size_t)st.st_size < header_size) {
+    close(stream_fd);
+    throw StreamException("CompressedBinaryStream: could not read header of " + file_name);
+  }
+  file_bytes = st.st_size;
+  mapping = (const char *)mmap(nullptr, file_bytes, PROT_READ, MAP_PRIVATE, stream_fd, 0);
+  if (mapping == MAP_FAILED) {
+    close(stream_fd);
+    throw StreamException("CompressedBinaryStream: could not map " + file_name);
+  }
+  madvise((void *)mapping, file_bytes, MADV_SEQUENTIAL);
+
+  const char *header = mapping;
+  uint32_t block_updates32;
+  uint64_t index_offset;
+  memcpy(&num_vertices, header, sizeof(num_vertices));
+  header += sizeof(num_vertices);
+  memcpy(&num_edges, header, sizeof(num_edges));
+  header += sizeof(num_edges);
+  memcpy(&block_updates32, header, sizeof(block_updates32));
+  header += sizeof(block_updates32);
+  memcpy(&index_offset, header, sizeof(index_offset));
+  block_updates = block_updates32;
+
+  // check the index so that decoding never reads outside the mapping
+  bool valid = block_updates > 0 && index_offset % sizeof(uint64_t) == 0 &&
+               index_offset >= header_size && index_offset <= file_bytes;
+  if (valid) {
+    num_blocks = (num_edges + block_updates - 1) / block_updates;
+    valid = (file_bytes - index_offset) / sizeof(uint64_t) >= num_blocks + 1;
+  }
+  if (valid) {
+    block_offsets = (const uint64_t *)(mapping + index_offset);
+    valid = block_offsets[0] == header_size && block_offsets[num_blocks] == index_offset;
+    for (edge_id_t b = 0; valid && b < num_blocks; b++)
+      valid = block_offsets[b] <= block_offsets[b + 1];
+  }
+  if (!valid) {
+    munmap((void *)mapping, file_bytes);
+    close(stream_fd);
+    throw StreamException("CompressedBinaryStream: malformed block index in " + file_name);
+  }
+  break_index = num_edges;
+}
+
+CompressedBinaryStream::~CompressedBinaryStream() {
+  munmap((void *)mapping, file_bytes);
+  close(stream_fd);
+}
+
+void CompressedBinaryStream::decode_block(edge_id_t block, edge_id_t skip, edge_id_t count,
+                                          GraphStreamUpdate *out) {
+  const uint8_t *in = (const uint8_t *)mapping + block_offsets[block];
+  const uint8_t *end = (const uint8_t *)mapping + block_offsets[block + 1];
+  int64_t prev_lo = 0;
+  for (edge_id_t i = 0; i < skip + count; i++) {
+    uint64_t key, diff;
+    in = get_varint(in, end, key);
+    if (in != nullptr) in = get_varint(in, end, diff);
+    if (in == nullptr)
+      throw StreamException("CompressedBinaryStream: malformed block in " + file_name);
+
+    int64_t lo = prev_lo + unzigzag(key >> 2);
+    prev_lo = lo;
+    if (i < skip) continue;
+    node_id_t src = lo;
+    node_id_t dst = lo + diff;
+    if (key & 2) std::swap(src, dst);
+    out[i - skip] = {(uint8_t)(key & 1), {src, dst}};
+  }
+}
+
+size_t CompressedBinaryStream::get_update_buffer(GraphStreamUpdate *upd_buf,
+                                                 size_t num_updates) {
+  edge_id_t begin = stream_off.load();
+  edge_id_t end;
+  do {
+    edge_id_t break_idx = break_index.load();
+    if (begin >= break_idx) {
+      upd_buf[0] = {BREAKPOINT, {0, 0}};
+      return 1;
+    }
+    end = std::min(begin + num_updates, break_idx);
+    // end on a block boundary so the next claim does not decode part of this block again
+    edge_id_t boundary = end / block_updates * block_updates;
+    if (end != break_idx && boundary > begin) end = boundary;
+  } while (!stream_off.compare_exchange_weak(begin, end));
+
+  for (edge_id_t block = begin / block_updates; block * block_updates < end; block++) {
+    edge_id_t first = std::max(begin, block * block_updates);
+    edge_id_t last = std::min(end, (block + 1) * block_updates);
+    decode_block(block, first - block * block_updates, last - first, upd_buf + (first - begin));
+  }
+  return end - begin;
+}
+
+bool CompressedBinaryStream::set_break_point(edge_id_t break_idx) {
+  break_idx = std::min(break_idx, num_edges);
+  if (break_idx < stream_off) return false;
+  break_index = break_idx;
+  return true;
+}
+
+void CompressedBinaryStream::serialize_metadata(std::ostream &out) {
+  out << "CompressedBinaryStream " << file_name << std::endl;
+}
+
+CompressedStreamWriter::CompressedStreamWriter(const std::string &file_name,
+                                               node_id_t num_vertices, uint32_t block_updates)
+    : out(file_name, std::ios::binary | std::ios::trunc),
+      num_vertices(num_vertices),
+      block_updates(std::max(block_updates, (uint32_t)1)) {
+  if (!out.is_open()) throw StreamException("CompressedStreamWriter: could not open " + file_name);
+  // reserve space for the header, which is written once we know the number of updates
+  char header[CompressedBinaryStream::header_size] = {};
+  out.write(header, sizeof(header));
+  write_offset = sizeof(header);
+}
+
+CompressedStreamWriter::~CompressedStreamWriter() {
+  write_blocks(true);
+
+  // pad so the index is aligned within the mapping
+  char padding[sizeof(uint64_t)] = {};
+  size_t padding_bytes = (sizeof(uint64_t) - write_offset % sizeof(uint64_t)) % sizeof(uint64_t);
+  out.write(padding, padding_bytes);
+  uint64_t index_offset = write_offset + padding_bytes;
+  block_offsets.push_back(index_offset);
+  out.write((char *)block_offsets.data(), block_offsets.size() * sizeof(uint64_t));
+
+  out.seekp(0);
+  out.write((char *)&num_vertices, sizeof(num_vertices));
+  out.write((char *)&num_updates, sizeof(num_updates));
+  out.write((char *)&block_updates, sizeof(block_updates));
+  out.write((char *)&index_offset, sizeof(index_offset));
+}
+
+void CompressedStreamWriter::write_updates(const GraphStreamUpdate *updates, size_t num) {
+  for (size_t i = 0; i < num; i++) {
+    if (updates[i].type != INSERT && updates[i].type != DELETE)
+      throw StreamException("CompressedStreamWriter: only INSERT and DELETE may be written");
+  }
+  pending.insert(pending.end(), updates, updates + num);
+  num_updates += num;
+  if (pending.size() >= encode_batch_blocks * block_updates) write_blocks(false);
+}
+
+void CompressedStreamWriter::write_blocks(bool flush) {
+  size_t blocks = flush ? (pending.size() + block_updates - 1) / block_updates
+                        : pending.size() / block_updates;
+  // each update takes at most two 10 byte varints
+  static constexpr size_t max_update_bytes = 20;
+  std::vector<std::vector<uint8_t>> encoded(blocks);
+
+#pragma omp parallel for
+  for (size_t b = 0; b < blocks; b++) {
+    size_t first = b * block_updates;
+    size_t last = std::min(first + block_updates, pending.size());
+    encoded[b].resize((last - first) * max_update_bytes);
+    uint8_t *ptr = encoded[b].data();
+    int64_t prev_lo = 0;
+    for (size_t i = first; i < last; i++) {
+      const GraphStreamUpdate &upd = pending[i];
+      node_id_t lo = std::min(upd.edge.src, upd.edge.dst);
+      node_id_t hi = std::max(upd.edge.src, upd.edge.dst);
+      uint64_t key = zigzag((int64_t)lo - prev_lo) << 2 | (upd.edge.src > upd.edge.dst) << 1 |
+                     (upd.type & 1);
+      ptr = put_varint(ptr, key);
+      ptr = put_varint(ptr, hi - lo);
+      prev_lo = lo;
+    }
+    encoded[b].resize(ptr - encoded[b].data());
+  }
+
+  for (auto &block : encoded) {
+    block_offsets.push_back(write_offset);
+    out.write((char *)block.data(), block.size());
+    write_offset += block.size();
+  }
+  pending.erase(pending.begin(), pending.begin() + std::min(pending.size(),
+                                                            blocks * block_updates));
+}
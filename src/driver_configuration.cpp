@@ -26,6 +26,36 @@ GutteringConfiguration& DriverConfiguration::gutter_conf() {
   return _gutter_conf;
 }
 
+DriverConfiguration& DriverConfiguration::pin_threads(bool pin_threads) {
+  _pin_threads = pin_threads;
+  return *this;
+}
+
+DriverConfiguration& DriverConfiguration::sketch_placement(SketchPlacement sketch_placement) {
+  _sketch_placement = sketch_placement;
+  return *this;
+}
+
+DriverConfiguration& DriverConfiguration::local_worker_memory(bool local_worker_memory) {
+  _local_worker_memory = local_worker_memory;
+  return *this;
+}
+
+DriverConfiguration& DriverConfiguration::partition_ingestion(bool partition_ingestion) {
+  _partition_ingestion = partition_ingestion;
+  return *this;
+}
+
+DriverConfiguration& DriverConfiguration::cancellation_window(size_t cancellation_window) {
+  _cancellation_window = cancellation_window;
+  return *this;
+}
+
+DriverConfiguration& DriverConfiguration::quiet(bool quiet) {
+  _quiet = quiet;
+  return *this;
+}
+
 std::ostream& operator<< (std::ostream &out, const DriverConfiguration &conf) {
     out << "GraphSketchDriver Configuration:" << std::endl;
     std::string gutter_system = "StandAloneGutters";
@@ -35,6 +65,18 @@ std::ostream& operator<< (std::ostream &out, const DriverConfiguration &conf) {
       gutter_system = "CacheTree";
     out << " Guttering system      = " << gutter_system << std::endl;
     out << " Worker thread count   = " << conf._num_worker_threads << std::endl;
-    out << " On disk data location = " << conf._disk_dir;
+    std::string placement = "FirstTouch";
+    if (conf._sketch_placement == INTERLEAVE)
+      placement = "Interleave";
+    else if (conf._sketch_placement == PARTITION)
+      placement = "Partition";
+    out << " On disk data location = " << conf._disk_dir << std::endl;
+    out << " Pin threads to CPUs   = " << (conf._pin_threads ? "True" : "False") << std::endl;
+    out << " Sketch placement      = " << placement << std::endl;
+    out << " Local worker memory   = " << (conf._local_worker_memory ? "True" : "False")
+        << std::endl;
+    out << " Partitioned ingestion = " << (conf._partition_ingestion ? "True" : "False")
+        << std::endl;
+    out << " Cancellation window   = " << conf._cancellation_window;
     return out;
   }
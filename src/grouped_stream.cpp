@@ -0,0 +1,59 @@
+#include "grouped_stream.h"
+
+#include <algorithm>
+#include <cstdint>
+
+GroupedStreamReader::GroupedStreamReader(const std::string &file_name)
+    : in(file_name, std::ios::binary) {
+  if (!in.is_open()) throw StreamException("GroupedStreamReader: could not open " + file_name);
+  in.read((char *)&num_vertices, sizeof(num_vertices));
+  in.read((char *)&num_updates, sizeof(num_updates));
+  if (!in) throw StreamException("GroupedStreamReader: could not read header of " + file_name);
+}
+
+bool GroupedStreamReader::get_run(node_id_t &src, std::vector<node_id_t> &dsts,
+                                  size_t max_updates) {
+  std::lock_guard<std::mutex> lk(read_lock);
+  while (run_remaining == 0) {
+    in.read((char *)&run_src, sizeof(run_src));
+    // the stream ends cleanly only between runs
+    if (in.gcount() == 0 && in.eof()) return false;
+    in.read((char *)&run_remaining, sizeof(run_remaining));
+    if (!in) throw StreamException("GroupedStreamReader: truncated run header");
+  }
+
+  size_t length = std::min((size_t)run_remaining, std::max(max_updates, (size_t)1));
+  src = run_src;
+  dsts.resize(length);
+  in.read((char *)dsts.data(), length * sizeof(node_id_t));
+  if (!in) throw StreamException("GroupedStreamReader: truncated run");
+  run_remaining -= length;
+  return true;
+}
+
+GroupedStreamWriter::GroupedStreamWriter(const std::string &file_name, node_id_t num_vertices)
+    : out(file_name, std::ios::binary | std::ios::trunc), num_vertices(num_vertices) {
+  if (!out.is_open()) throw StreamException("GroupedStreamWriter: could not open " + file_name);
+  // reserve space for the header, which is written once we know the number of updates
+  out.write((char *)&num_vertices, sizeof(num_vertices));
+  out.write((char *)&num_updates, sizeof(num_updates));
+}
+
+GroupedStreamWriter::~GroupedStreamWriter() {
+  out.seekp(0);
+  out.write((char *)&num_vertices, sizeof(num_vertices));
+  out.write((char *)&num_updates, sizeof(num_updates));
+}
+
+void GroupedStreamWriter::write_run(node_id_t src, const node_id_t *dsts, size_t length) {
+  // runs longer than the format allows are written as several runs
+  while (length > 0) {
+    uint32_t run_length = std::min(length, (size_t)UINT32_MAX);
+    out.write((char *)&src, sizeof(src));
+    out.write((char *)&run_length, sizeof(run_length));
+    out.write((char *)dsts, run_length * sizeof(node_id_t));
+    num_updates += run_length;
+    dsts += run_length;
+    length -= run_length;
+  }
+}
@@ -0,0 +1,177 @@
+#include "in_memory_stream.h"
+
+#include <algorithm>
+#include <cstring>
+
+InMemoryStream::InMemoryStream(node_id_t num_vertices, std::vector<GraphStreamUpdate> &&updates)
+    : owned_updates(std::move(updates)) {
+  this->num_vertices = num_vertices;
+  num_edges = owned_updates.size();
+  stream_updates = owned_updates.data();
+  break_index = num_edges;
+}
+
+InMemoryStream::InMemoryStream(node_id_t num_vertices, const GraphStreamUpdate *updates,
+                               edge_id_t num_updates)
+    : stream_updates(updates) {
+  this->num_vertices = num_vertices;
+  num_edges = num_updates;
+  break_index = num_edges;
+}
+
+size_t InMemoryStream::get_update_view(const GraphStreamUpdate *&updates, size_t max_updates) {
+  edge_id_t begin = stream_off.fetch_add(max_updates);
+  edge_id_t end = std::min(begin + max_updates, break_index.load());
+  if (begin >= end) return 0;
+
+  updates = stream_updates + begin;
+  return end - begin;
+}
+
+size_t InMemoryStream::get_update_buffer(GraphStreamUpdate *upd_buf, size_t num_updates) {
+  const GraphStreamUpdate *updates;
+  size_t claimed = get_update_view(updates, num_updates);
+  if (claimed == 0) {
+    upd_buf[0] = {BREAKPOINT, {0, 0}};
+    return 1;
+  }
+  memcpy(upd_buf, updates, claimed * sizeof(GraphStreamUpdate));
+  return claimed;
+}
+
+bool InMemoryStream::set_break_point(edge_id_t break_idx) {
+  break_idx = std::min(break_idx, num_edges);
+  // the stream offset may have overshot the previous breakpoint
+  edge_id_t cur = std::min(stream_off.load(), break_index.load());
+  if (break_idx < cur) return false;
+  stream_off = cur;
+  break_index = break_idx;
+  return true;
+}
+
+void InMemoryStream::serialize_metadata(std::ostream &out) {
+  out << "InMemoryStream " << num_vertices << " " << num_edges << std::endl;
+}
+
+RingBufferStream::RingBufferStream(node_id_t num_vertices, size_t capacity) {
+  this->num_vertices = num_vertices;
+  size_t ring_size = 1;
+  while (ring_size < capacity) ring_size *= 2;
+  ring.resize(ring_size);
+  ring_mask = ring_size - 1;
+}
+
+RingBufferStream::RingBufferStream(node_id_t num_vertices, Producer producer, size_t capacity)
+    : RingBufferStream(num_vertices, capacity) {
+  producer_thread = std::thread([this, producer]() {
+    while (true) {
+      size_t free_slots;
+      GraphStreamUpdate *slots = reserve(free_slots);
+      if (slots == nullptr) break;
+      size_t produced = producer(slots, free_slots);
+      if (produced == 0) break;
+      publish(produced);
+    }
+    close();
+  });
+}
+
+RingBufferStream::~RingBufferStream() {
+  // a producer waiting for readers that will never come must give up
+  stopping = true;
+  space_word.notify_all();
+  if (producer_thread.joinable()) producer_thread.join();
+}
+
+GraphStreamUpdate *RingBufferStream::reserve(size_t &free_slots) {
+  edge_id_t pub = published.load(std::memory_order_relaxed);
+  while (!stopping) {
+    uint32_t word = space_word.load();
+    size_t used = pub - released.load(std::memory_order_acquire);
+    if (used < ring.size()) {
+      size_t slot = pub & ring_mask;
+      free_slots = std::min(ring.size() - used, ring.size() - slot);
+      return &ring[slot];
+    }
+    space_word.wait(word);
+  }
+  free_slots = 0;
+  return nullptr;
+}
+
+void RingBufferStream::publish(size_t num_updates) {
+  published.store(published.load(std::memory_order_relaxed) + num_updates,
+                  std::memory_order_release);
+  data_word.notify_all();
+}
+
+void RingBufferStream::push(const GraphStreamUpdate *updates, size_t num_updates) {
+  while (num_updates > 0) {
+    size_t free_slots;
+    GraphStreamUpdate *slots = reserve(free_slots);
+    if (slots == nullptr) return;
+    size_t num = std::min(free_slots, num_updates);
+    memcpy(slots, updates, num * sizeof(GraphStreamUpdate));
+    publish(num);
+    updates += num;
+    num_updates -= num;
+  }
+}
+
+void RingBufferStream::close() {
+  // num_edges is written once, before closed is set, so edges() reads it only once it is final
+  if (closed) return;
+  num_edges = published.load();
+  closed = true;
+  data_word.notify_all();
+}
+
+size_t RingBufferStream::get_update_buffer(GraphStreamUpdate *upd_buf, size_t num_updates) {
+  while (true) {
+    uint32_t word = data_word.load();
+    edge_id_t begin = claimed.load();
+    edge_id_t break_idx = break_index.load();
+    if (begin >= break_idx) break;
+
+    edge_id_t pub = published.load(std::memory_order_acquire);
+    if (begin < pub) {
+      edge_id_t end = std::min({begin + num_updates, pub, break_idx});
+      if (!claimed.compare_exchange_weak(begin, end)) continue;
+
+      // the claimed range may wrap around the end of the ring
+      size_t slot = begin & ring_mask;
+      size_t first = std::min((size_t)(end - begin), ring.size() - slot);
+      memcpy(upd_buf, &ring[slot], first * sizeof(GraphStreamUpdate));
+      memcpy(upd_buf + first, &ring[0], (end - begin - first) * sizeof(GraphStreamUpdate));
+
+      // Release in order, so the producer never overwrites a range still being copied. Ranges
+      // claimed before ours are short copies that are already underway.
+      while (released.load(std::memory_order_acquire) != begin) std::this_thread::yield();
+      released.store(end, std::memory_order_release);
+      space_word.notify_all();
+      return end - begin;
+    }
+    // closed is set after the final publish, so the ring is drained if nothing more is published
+    if (closed && published.load() == begin) break;
+    data_word.wait(word);
+  }
+  upd_buf[0] = {BREAKPOINT, {0, 0}};
+  return 1;
+}
+
+void RingBufferStream::seek(edge_id_t edge_idx) {
+  if (edge_idx != claimed.load())
+    throw StreamException("RingBufferStream: cannot seek, updates are discarded once read");
+}
+
+bool RingBufferStream::set_break_point(edge_id_t break_idx) {
+  if (break_idx < claimed.load()) return false;
+  break_index = break_idx;
+  // readers waiting for updates may now be past the breakpoint
+  data_word.notify_all();
+  return true;
+}
+
+void RingBufferStream::serialize_metadata(std::ostream &out) {
+  out << "RingBufferStream " << num_vertices << " " << ring.size() << std::endl;
+}
@@ -0,0 +1,121 @@
+#include "memory_budget.h"
+
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <unordered_set>
+
+#include "bucket.h"
+#include "cc_sketch_alg.h"
+#include "numa_topology.h"
+#include "sketch.h"
+
+// Heap bytes of a node of a std::set or std::unordered_set of node ids, including malloc overhead
+static constexpr size_t set_node_bytes = 48;
+
+size_t MemoryBudget::batch_bytes(node_id_t num_vertices, double batch_factor,
+                                 double sketches_factor) {
+  // matches CCSketchAlg::get_desired_updates_per_batch()
+  size_t num_buckets = Sketch::calc_num_buckets(Sketch::calc_vector_length(num_vertices),
+                                                Sketch::calc_cc_samples(num_vertices,
+                                                                        sketches_factor));
+  size_t num = num_buckets * sizeof(Bucket) / sizeof(node_id_t);
+  num *= batch_factor;
+  return num * sizeof(node_id_t);
+}
+
+MemoryEstimate MemoryBudget::estimate(GutterSystem gutter_sys, size_t workers,
+                                      size_t gutter_bytes, double sketches_factor) const {
+  size_t num_buckets = Sketch::calc_num_buckets(Sketch::calc_vector_length(num_vertices),
+                                                Sketch::calc_cc_samples(num_vertices,
+                                                                        sketches_factor));
+  size_t page = NumaTopology::page_size();
+  size_t sketch_bytes = num_buckets * sizeof(Bucket);
+  size_t delta_stride = (sketch_bytes + page - 1) / page * page;
+
+  MemoryEstimate est;
+  est.sketch_bytes = (size_t)num_vertices * (sketch_bytes + sizeof(Sketch) + sizeof(Sketch *));
+  est.delta_sketch_bytes = workers * (delta_stride + sizeof(Sketch) + sizeof(Sketch *));
+
+  // each element of the work queue holds wq_batch_per_elm batches, and so does each worker
+  est.gutter_bytes = (queue_factor + 1) * workers * wq_batch_per_elm * gutter_bytes;
+  if (gutter_sys == GUTTERTREE) {
+    // the leaves are on disk, the buffers and a page for each child are in memory
+    est.gutter_bytes += 2 * (size_t(1) << buffer_exp) + fanout * page;
+  } else {
+    est.gutter_bytes += (size_t)num_vertices * gutter_bytes;
+    // the CacheTree buffers updates for the leaves in each stream thread
+    if (gutter_sys == CACHETREE) est.gutter_bytes += num_stream_threads * (size_t(1) << buffer_exp);
+  }
+
+  // the DSU, the representatives and the spanning forest, which has fewer edges than vertices
+  est.vertex_bytes =
+      (size_t)num_vertices * (sizeof(std::atomic<node_id_t>) + sizeof(node_id_t) +
+                              set_node_bytes + sizeof(std::unordered_set<node_id_t>) +
+                              sizeof(std::mutex) + set_node_bytes);
+
+  // merge instructions and the roots of each vertex, the spanning forest the query returns, and
+  // a supernode sketch of each thread
+  est.query_bytes = (size_t)num_vertices * (sizeof(MergeInstr) + 2 * sizeof(node_id_t) +
+                                            sizeof(Edge)) +
+                    workers * (sizeof(GlobalMergeData) + 2 * sketch_bytes);
+  return est;
+}
+
+MemoryEstimate MemoryBudget::estimate(DriverConfiguration driver_config,
+                                      CCAlgConfiguration alg_config) const {
+  size_t gutter_bytes = driver_config.gutter_conf().get_gutter_bytes();
+  if (gutter_bytes == GutteringConfiguration::uninit_param)
+    gutter_bytes = batch_bytes(num_vertices, alg_config.get_batch_factor(),
+                               alg_config.get_sketches_factor());
+  return estimate(driver_config.get_gutter_sys(), driver_config.get_worker_threads(),
+                  gutter_bytes, alg_config.get_sketches_factor());
+}
+
+MemoryEstimate MemoryBudget::plan(DriverConfiguration &driver_config,
+                                  CCAlgConfiguration &alg_config) const {
+  struct Candidate {
+    GutterSystem gutter_sys;
+    double batch_factor;
+  };
+  static constexpr Candidate candidates[] = {
+      {CACHETREE, 2},    {STANDALONE, 2},    {CACHETREE, 1},    {STANDALONE, 1},
+      {CACHETREE, 0.5},  {STANDALONE, 0.5},  {CACHETREE, 0.25}, {STANDALONE, 0.25},
+      {GUTTERTREE, 1},   {GUTTERTREE, 0.5},  {GUTTERTREE, 0.25}};
+
+  double sketches_factor = alg_config.get_sketches_factor();
+  MemoryEstimate smallest;
+  for (size_t workers = driver_config.get_worker_threads(); workers >= 1; workers /= 2) {
+    for (const Candidate &cand : candidates) {
+      size_t gutter_bytes = batch_bytes(num_vertices, cand.batch_factor, sketches_factor);
+      MemoryEstimate est = estimate(cand.gutter_sys, workers, gutter_bytes, sketches_factor);
+      if (smallest.total() == 0 || est.total() < smallest.total()) smallest = est;
+      if (est.total() > budget_bytes) continue;
+
+      driver_config.gutter_sys(cand.gutter_sys).worker_threads(workers);
+      driver_config.gutter_conf()
+          .gutter_bytes(gutter_bytes)
+          .queue_factor(queue_factor)
+          .wq_batch_per_elm(wq_batch_per_elm)
+          .fanout(fanout)
+          .buffer_exp(buffer_exp);
+      alg_config.batch_factor(cand.batch_factor);
+      return est;
+    }
+  }
+  throw std::runtime_error("MemoryBudget: " + std::to_string(num_vertices) +
+                           " vertices need at least " + std::to_string(smallest.total()) +
+                           " bytes, more than the budget of " + std::to_string(budget_bytes));
+}
+
+std::ostream& operator<< (std::ostream &out, const MemoryEstimate &estimate) {
+    out << "Memory Estimate (bytes):" << std::endl;
+    out << " Vertex sketches       = " << estimate.sketch_bytes << std::endl;
+    out << " Delta sketches        = " << estimate.delta_sketch_bytes << std::endl;
+    out << " Gutters               = " << estimate.gutter_bytes << std::endl;
+    out << " Vertex bookkeeping    = " << estimate.vertex_bytes << std::endl;
+    out << " Query                 = " << estimate.query_bytes << std::endl;
+    out << " Total                 = " << estimate.total();
+    return out;
+  }
@@ -0,0 +1,92 @@
+#include "mmap_binary_stream.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+MMapBinaryStream::MMapBinaryStream(const std::string &file_name) : file_name(file_name) {
+  stream_fd = open(file_name.c_str(), O_RDONLY);
+  if (stream_fd < 0) throw StreamException("MMapBinaryStream: could not open " + file_name);
+
+  struct stat st;
+  if (fstat(stream_fd, &st) != 0 || (size_t)st.st_size < header_size) {
+    close(stream_fd);
+    throw StreamException("MMapBinaryStream: could not read header of " + file_name);
+  }
+  file_bytes = st.st_size;
+  mapping = (const char *)mmap(nullptr, file_bytes, PROT_READ, MAP_PRIVATE, stream_fd, 0);
+  if (mapping == MAP_FAILED) {
+    close(stream_fd);
+    throw StreamException("MMapBinaryStream: could not map " + file_name);
+  }
+  // we read the file front to back, so the kernel may read ahead aggressively and drop pages
+  // behind us
+  madvise((void *)mapping, file_bytes, MADV_SEQUENTIAL);
+
+  memcpy(&num_vertices, mapping, sizeof(num_vertices));
+  memcpy(&num_edges, mapping + sizeof(num_vertices), sizeof(num_edges));
+  stream_updates = (const GraphStreamUpdate *)(mapping + header_size);
+  num_edges = std::min(num_edges, (edge_id_t)((file_bytes - header_size) / sizeof(GraphStreamUpdate)));
+  break_index = num_edges;
+  advise_readahead(0);
+}
+
+MMapBinaryStream::~MMapBinaryStream() {
+  munmap((void *)mapping, file_bytes);
+  close(stream_fd);
+}
+
+void MMapBinaryStream::advise_readahead(edge_id_t claimed_end) {
+  size_t want = std::min(header_size + claimed_end * sizeof(GraphStreamUpdate) + readahead_bytes,
+                         file_bytes);
+  size_t advised = advised_until.load();
+  // one thread advances the window while the others carry on
+  while (advised < want) {
+    size_t next = std::min(advised + readahead_bytes, file_bytes);
+    if (advised_until.compare_exchange_weak(advised, next)) {
+      size_t page = sysconf(_SC_PAGESIZE);
+      size_t begin = advised / page * page;
+      madvise((void *)(mapping + begin), next - begin, MADV_WILLNEED);
+      advised = next;
+    }
+  }
+}
+
+size_t MMapBinaryStream::get_update_view(const GraphStreamUpdate *&updates, size_t max_updates) {
+  edge_id_t begin = stream_off.fetch_add(max_updates);
+  edge_id_t end = std::min(begin + max_updates, break_index.load());
+  if (begin >= end) return 0;
+
+  advise_readahead(end);
+  updates = stream_updates + begin;
+  return end - begin;
+}
+
+size_t MMapBinaryStream::get_update_buffer(GraphStreamUpdate *upd_buf, size_t num_updates) {
+  const GraphStreamUpdate *updates;
+  size_t claimed = get_update_view(updates, num_updates);
+  if (claimed == 0) {
+    upd_buf[0] = {BREAKPOINT, {0, 0}};
+    return 1;
+  }
+  memcpy(upd_buf, updates, claimed * sizeof(GraphStreamUpdate));
+  return claimed;
+}
+
+bool MMapBinaryStream::set_break_point(edge_id_t break_idx) {
+  break_idx = std::min(break_idx, num_edges);
+  // the stream offset may have overshot the previous breakpoint
+  edge_id_t cur = std::min(stream_off.load(), break_index.load());
+  if (break_idx < cur) return false;
+  stream_off = cur;
+  break_index = break_idx;
+  return true;
+}
+
+void MMapBinaryStream::serialize_metadata(std::ostream &out) {
+  out << "MMapBinaryStream " << file_name << std::endl;
+}
@@ -0,0 +1,113 @@
+#include "numa_topology.h"
+
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <string>
+
+// parse a sysfs cpu list such as "0-3,8,10-11"
+static std::vector<int> parse_cpu_list(const std::string &list) {
+  std::vector<int> cpus;
+  std::stringstream ss(list);
+  std::string range;
+  while (std::getline(ss, range, ',')) {
+    if (range.empty() || range == "\n") continue;
+    size_t dash = range.find('-');
+    int first = std::stoi(range.substr(0, dash));
+    int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+    for (int c = first; c <= last; c++) cpus.push_back(c);
+  }
+  return cpus;
+}
+
+NumaTopology::NumaTopology() {
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  sched_getaffinity(0, sizeof(allowed), &allowed);
+
+  std::vector<int> nodes;
+  std::ifstream online("/sys/devices/system/node/online");
+  std::string node_list;
+  if (online.is_open() && std::getline(online, node_list)) nodes = parse_cpu_list(node_list);
+
+  for (int node : nodes) {
+    std::ifstream cpulist("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    std::string cpu_list;
+    if (!cpulist.is_open() || !std::getline(cpulist, cpu_list)) continue;
+
+    std::vector<int> cpus;
+    for (int cpu : parse_cpu_list(cpu_list))
+      if (CPU_ISSET(cpu, &allowed)) cpus.push_back(cpu);
+    if (cpus.empty()) continue;
+    node_cpus.push_back(cpus);
+    node_ids.push_back(node);
+  }
+
+  if (node_cpus.empty()) {
+    // no NUMA information so treat the machine as a single node
+    std::vector<int> cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+      if (CPU_ISSET(cpu, &allowed)) cpus.push_back(cpu);
+    node_cpus.push_back(cpus);
+    node_ids.push_back(0);
+  }
+}
+
+int NumaTopology::cpu_for_thread(size_t thr_id) const {
+  const std::vector<int> &cpus = node_cpus[node_for_thread(thr_id)];
+  return cpus[(thr_id / num_nodes()) % cpus.size()];
+}
+
+bool NumaTopology::pin_thread(std::thread &thr, int cpu) {
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  CPU_SET(cpu, &cpuset);
+  return pthread_setaffinity_np(thr.native_handle(), sizeof(cpuset), &cpuset) == 0;
+}
+
+size_t NumaTopology::page_size() { return sysconf(_SC_PAGESIZE); }
+
+void *NumaTopology::allocate_pages(size_t bytes) {
+  void *addr = mmap(nullptr, std::max(bytes, (size_t)1), PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (addr == MAP_FAILED) throw std::bad_alloc();
+  return addr;
+}
+
+void NumaTopology::free_pages(void *addr, size_t bytes) {
+  if (addr != nullptr) munmap(addr, std::max(bytes, (size_t)1));
+}
+
+// apply a memory policy to the pages overlapping [addr, addr + bytes) and move existing pages
+static bool set_memory_policy(void *addr, size_t bytes, int mode,
+                              const std::vector<int> &nodes) {
+  if (bytes == 0) return true;
+  size_t page = NumaTopology::page_size();
+  uintptr_t start = (uintptr_t)addr / page * page;
+  uintptr_t end = ((uintptr_t)addr + bytes + page - 1) / page * page;
+
+  int max_node = *std::max_element(nodes.begin(), nodes.end());
+  std::vector<unsigned long> mask(max_node / (8 * sizeof(unsigned long)) + 1, 0);
+  for (int node : nodes)
+    mask[node / (8 * sizeof(unsigned long))] |= 1UL << (node % (8 * sizeof(unsigned long)));
+
+  return syscall(SYS_mbind, start, end - start, mode, mask.data(), max_node + 2,
+                 MPOL_MF_MOVE) == 0;
+}
+
+bool NumaTopology::bind_memory(void *addr, size_t bytes, int node) {
+  return set_memory_policy(addr, bytes, MPOL_BIND, {node});
+}
+
+bool NumaTopology::interleave_memory(void *addr, size_t bytes) const {
+  return set_memory_policy(addr, bytes, MPOL_INTERLEAVE, node_ids);
+}
@@ -0,0 +1,260 @@
+#include "perf_counters.h"
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+std::atomic<bool> PerfProfiler::is_enabled{false};
+std::atomic<uint64_t> PerfProfiler::task_phase{(uint64_t)NUM_PERF_PHASES << 32};
+
+static std::atomic<bool> events_opened[NUM_PERF_EVENTS];
+
+const char *perf_phase_name(PerfPhase phase) {
+  switch (phase) {
+    case PERF_STREAM_READ: return "stream_read";
+    case PERF_GUTTER_INSERT: return "gutter_insert";
+    case PERF_APPLY_UPDATE_BATCH: return "apply_update_batch";
+    case PERF_DELTA_MERGE: return "delta_merge";
+    case PERF_BORUVKA_ROUND: return "boruvka_round";
+    case PERF_MERGE_INSTRUCTIONS: return "merge_instructions";
+    default: return "unknown";
+  }
+}
+
+const char *perf_event_name(PerfEvent event) {
+  switch (event) {
+    case PERF_CYCLES: return "cycles";
+    case PERF_INSTRUCTIONS: return "instructions";
+    case PERF_LLC_MISSES: return "llc_misses";
+    case PERF_DTLB_MISSES: return "dtlb_misses";
+    default: return "unknown";
+  }
+}
+
+// Index of each total within a Totals entry
+static constexpr size_t enabled_idx = NUM_PERF_EVENTS;
+static constexpr size_t running_idx = NUM_PERF_EVENTS + 1;
+static constexpr size_t nanos_idx = NUM_PERF_EVENTS + 2;
+static constexpr size_t calls_idx = NUM_PERF_EVENTS + 3;
+static constexpr size_t num_totals = NUM_PERF_EVENTS + 4;
+
+using Totals = std::atomic<uint64_t>[NUM_PERF_PHASES][PerfProfiler::max_rounds][num_totals];
+
+/**
+ * The counters of a thread and the totals of its phases. Only the thread writes its totals,
+ * others may read them while it runs.
+ */
+struct PerfThreadCounters {
+  int leader_fd = -1;
+  int fds[NUM_PERF_EVENTS];
+  int slot[NUM_PERF_EVENTS];  // position of each event in the group, -1 if unavailable
+  size_t group_size = 0;
+  Totals totals;
+
+  PerfThreadCounters();
+  ~PerfThreadCounters();
+  void read_counters(uint64_t *values);
+};
+
+// Every thread that has entered a phase, and the totals of those that have exited
+static std::mutex registry_mtx;
+static std::vector<PerfThreadCounters *> live_threads;
+static uint64_t retired_totals[NUM_PERF_PHASES][PerfProfiler::max_rounds][num_totals];
+
+static int open_event(uint32_t type, uint64_t config, int group_fd) {
+  perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = type;
+  attr.config = config;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format =
+      PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  return syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+
+static uint64_t cache_miss_config(uint64_t cache) {
+  return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+PerfThreadCounters::PerfThreadCounters() {
+  for (auto &phase : totals)
+    for (auto &round : phase)
+      for (auto &total : round) total.store(0, std::memory_order_relaxed);
+
+  const std::pair<uint32_t, uint64_t> events[NUM_PERF_EVENTS] = {
+      {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+      {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+      {PERF_TYPE_HW_CACHE, cache_miss_config(PERF_COUNT_HW_CACHE_LL)},
+      {PERF_TYPE_HW_CACHE, cache_miss_config(PERF_COUNT_HW_CACHE_DTLB)}};
+  for (size_t e = 0; e < NUM_PERF_EVENTS; e++) {
+    fds[e] = open_event(events[e].first, events[e].second, leader_fd);
+    if (fds[e] < 0) {
+      slot[e] = -1;
+      continue;
+    }
+    if (leader_fd < 0) leader_fd = fds[e];
+    slot[e] = group_size++;
+    events_opened[e] = true;
+  }
+  if (leader_fd >= 0) {
+    ioctl(leader_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(leader_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  }
+}
+
+PerfThreadCounters::~PerfThreadCounters() {
+  for (size_t e = 0; e < NUM_PERF_EVENTS; e++)
+    if (fds[e] >= 0) close(fds[e]);
+}
+
+void PerfThreadCounters::read_counters(uint64_t *values) {
+  auto now = std::chrono::steady_clock::now().time_since_epoch();
+  values[nanos_idx] = std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+  uint64_t group[3 + NUM_PERF_EVENTS] = {};  // nr, time enabled, time running, values
+  if (leader_fd >= 0 && read(leader_fd, group, (3 + group_size) * sizeof(uint64_t)) < 0)
+    memset(group, 0, sizeof(group));
+  values[enabled_idx] = group[1];
+  values[running_idx] = group[2];
+  for (size_t e = 0; e < NUM_PERF_EVENTS; e++)
+    values[e] = slot[e] >= 0 ? group[3 + slot[e]] : 0;
+}
+
+// Owns the counters of a thread, and folds its totals into the retired totals when it exits
+struct PerfThreadHolder {
+  std::unique_ptr<PerfThreadCounters> counters;
+
+  PerfThreadCounters *get() {
+    if (counters == nullptr) {
+      counters.reset(new PerfThreadCounters());
+      std::lock_guard<std::mutex> lk(registry_mtx);
+      live_threads.push_back(counters.get());
+    }
+    return counters.get();
+  }
+
+  ~PerfThreadHolder() {
+    if (counters == nullptr) return;
+    std::lock_guard<std::mutex> lk(registry_mtx);
+    for (size_t p = 0; p < NUM_PERF_PHASES; p++)
+      for (size_t r = 0; r < PerfProfiler::max_rounds; r++)
+        for (size_t t = 0; t < num_totals; t++)
+          retired_totals[p][r][t] += counters->totals[p][r][t].load(std::memory_order_relaxed);
+    live_threads.erase(std::find(live_threads.begin(), live_threads.end(), counters.get()));
+  }
+};
+
+static thread_local PerfThreadHolder thread_holder;
+
+void PerfScope::begin() {
+  counters = thread_holder.get();
+  round = std::min(round, PerfProfiler::max_rounds - 1);
+  counters->read_counters(start);
+}
+
+void PerfScope::end() {
+  uint64_t stop[NUM_PERF_EVENTS + 3];
+  counters->read_counters(stop);
+  auto &totals = counters->totals[phase][round];
+  // only this thread writes its totals, so a relaxed load and store suffices
+  auto add = [](std::atomic<uint64_t> &total, uint64_t delta) {
+    total.store(total.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+  };
+  for (size_t t = 0; t < NUM_PERF_EVENTS + 3; t++) add(totals[t], stop[t] - start[t]);
+  add(totals[calls_idx], 1);
+}
+
+void PerfProfiler::reset() {
+  std::lock_guard<std::mutex> lk(registry_mtx);
+  memset(retired_totals, 0, sizeof(retired_totals));
+  for (PerfThreadCounters *thr : live_threads)
+    for (auto &phase : thr->totals)
+      for (auto &round : phase)
+        for (auto &total : round) total.store(0, std::memory_order_relaxed);
+}
+
+bool PerfProfiler::event_available(PerfEvent event) { return events_opened[event]; }
+
+PerfPhaseTotals PerfProfiler::get_totals(PerfPhase phase, size_t round) {
+  round = std::min(round, max_rounds - 1);
+  uint64_t sum[num_totals];
+  {
+    std::lock_guard<std::mutex> lk(registry_mtx);
+    for (size_t t = 0; t < num_totals; t++) {
+      sum[t] = retired_totals[phase][round][t];
+      for (PerfThreadCounters *thr : live_threads)
+        sum[t] += thr->totals[phase][round][t].load(std::memory_order_relaxed);
+    }
+  }
+
+  PerfPhaseTotals totals;
+  totals.calls = sum[calls_idx];
+  totals.thread_seconds = sum[nanos_idx] / 1e9;
+  // the counters only ran for part of the time they were enabled if the kernel multiplexed them
+  double scale = sum[running_idx] > 0 ? (double)sum[enabled_idx] / sum[running_idx] : 1;
+  for (size_t e = 0; e < NUM_PERF_EVENTS; e++) totals.events[e] = sum[e] * scale;
+  return totals;
+}
+
+static void write_phase_json(std::ostream &out, PerfPhase phase, size_t round, bool per_round) {
+  PerfPhaseTotals totals = PerfProfiler::get_totals(phase, round);
+  out << "    {\"phase\": \"" << perf_phase_name(phase) << "\"";
+  if (per_round) out << ", \"round\": " << round;
+  out << ", \"calls\": " << totals.calls << ", \"thread_seconds\": " << totals.thread_seconds;
+  for (size_t e = 0; e < NUM_PERF_EVENTS; e++) {
+    out << ", \"" << perf_event_name((PerfEvent)e) << "\": ";
+    if (PerfProfiler::event_available((PerfEvent)e))
+      out << (uint64_t)totals.events[e];
+    else
+      out << "null";
+  }
+  out << ", \"ipc\": ";
+  if (PerfProfiler::event_available(PERF_CYCLES) &&
+      PerfProfiler::event_available(PERF_INSTRUCTIONS) && totals.events[PERF_CYCLES] > 0)
+    out << totals.events[PERF_INSTRUCTIONS] / totals.events[PERF_CYCLES];
+  else
+    out << "null";
+  out << "}";
+}
+
+void PerfProfiler::write_json(std::ostream &out) {
+  auto flags = out.flags();
+  out << std::setprecision(6);
+  out << "{\n  \"events\": {";
+  for (size_t e = 0; e < NUM_PERF_EVENTS; e++) {
+    out << (e > 0 ? ", " : "") << "\"" << perf_event_name((PerfEvent)e)
+        << "\": " << (event_available((PerfEvent)e) ? "true" : "false");
+  }
+  out << "},\n  \"phases\": [";
+
+  bool first = true;
+  for (size_t p = 0; p < NUM_PERF_PHASES; p++) {
+    PerfPhase phase = (PerfPhase)p;
+    bool per_round = phase == PERF_BORUVKA_ROUND || phase == PERF_MERGE_INSTRUCTIONS;
+    for (size_t r = 0; r < (per_round ? max_rounds : 1); r++) {
+      // rounds the query did not reach are left out
+      if (per_round && get_totals(phase, r).calls == 0) continue;
+      out << (first ? "\n" : ",\n");
+      write_phase_json(out, phase, r, per_round);
+      first = false;
+    }
+  }
+  out << "\n  ]\n}" << std::endl;
+  out.flags(flags);
+}
+
+void PerfProfiler::write_json(const std::string &filename) {
+  std::ofstream out(filename);
+  write_json(out);
+}
@@ -1,5 +1,6 @@
 #include "return_types.h"
 
+#include <atomic>
 #include <map>
 #include <algorithm>
 
@@ -19,6 +20,24 @@ ConnectedComponents::ConnectedComponents(node_id_t num_vertices,
   num_cc = temp_cc;
 }
 
+ConnectedComponents::ConnectedComponents(node_id_t num_vertices,
+                                         DisjointSetUnion_MT<node_id_t> &dsu, TaskPool &pool)
+    : parent_arr(new node_id_t[num_vertices]), num_vertices(num_vertices) {
+  std::atomic<node_id_t> temp_cc(0);
+  pool.run([&](size_t thr_id, size_t num_threads) {
+    node_id_t start = (uint64_t)num_vertices * thr_id / num_threads;
+    node_id_t end = (uint64_t)num_vertices * (thr_id + 1) / num_threads;
+    node_id_t local_cc = 0;
+    for (node_id_t i = start; i < end; i++) {
+      parent_arr[i] = dsu.find_root(i);
+      if (parent_arr[i] == i) ++local_cc;
+    }
+    temp_cc += local_cc;
+  });
+
+  num_cc = temp_cc;
+}
+
 ConnectedComponents::~ConnectedComponents() { delete[] parent_arr; }
 
 std::vector<std::set<node_id_t>> ConnectedComponents::get_component_sets() {
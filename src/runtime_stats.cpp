@@ -0,0 +1,142 @@
+#include "runtime_stats.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+void RuntimeStats::write_json(std::ostream &out) const {
+  auto flags = out.flags();
+  out << std::setprecision(9);
+  out << "{\n";
+  out << "  \"uptime_seconds\": " << uptime_seconds << ",\n";
+  out << "  \"ingested_updates\": " << ingested_updates << ",\n";
+  out << "  \"cancelled_updates\": " << cancelled_updates << ",\n";
+  out << "  \"applied_updates\": " << applied_updates << ",\n";
+  out << "  \"buffered_updates\": " << buffered_updates << ",\n";
+  out << "  \"workers\": [";
+  for (size_t i = 0; i < workers.size(); i++) {
+    out << (i > 0 ? ", " : "") << "{\"batches\": " << workers[i].batches
+        << ", \"updates\": " << workers[i].updates << "}";
+  }
+  out << "],\n";
+  // trailing empty buckets are left out
+  size_t num_buckets = histogram_buckets;
+  while (num_buckets > 0 && batch_size_histogram[num_buckets - 1] == 0) num_buckets--;
+  out << "  \"batch_size_histogram\": [";
+  for (size_t i = 0; i < num_buckets; i++)
+    out << (i > 0 ? ", " : "") << batch_size_histogram[i];
+  out << "],\n";
+  out << "  \"flushes\": " << flushes << ",\n";
+  out << "  \"last_flush_seconds\": " << last_flush_seconds << ",\n";
+  out << "  \"total_flush_seconds\": " << total_flush_seconds << ",\n";
+  out << "  \"query\": {\n";
+  out << "    \"queries\": " << query.queries << ",\n";
+  out << "    \"last_query_rounds\": " << query.last_query_rounds << ",\n";
+  out << "    \"last_query_seconds\": " << query.last_query_seconds << ",\n";
+  out << "    \"last_query_round_stats\": [";
+  for (size_t r = 0; r < query.last_query_round_stats.size(); r++) {
+    const QueryRoundStats &round = query.last_query_round_stats[r];
+    out << (r > 0 ? "," : "") << "\n      {\"seconds\": " << round.seconds
+        << ", \"good_samples\": " << round.good_samples
+        << ", \"zero_samples\": " << round.zero_samples
+        << ", \"fail_samples\": " << round.fail_samples << "}";
+  }
+  out << (query.last_query_round_stats.empty() ? "]\n" : "\n    ]\n");
+  out << "  }\n}" << std::endl;
+  out.flags(flags);
+}
+
+// Write the HELP and TYPE lines of a metric
+static void prometheus_header(std::ostream &out, const std::string &name, const char *type,
+                              const char *help) {
+  out << "# HELP graphzeppelin_" << name << " " << help << "\n";
+  out << "# TYPE graphzeppelin_" << name << " " << type << "\n";
+}
+
+void RuntimeStats::write_prometheus(std::ostream &out) const {
+  auto flags = out.flags();
+  out << std::setprecision(9);
+  auto metric = [&](const std::string &name, const char *type, const char *help, auto value) {
+    prometheus_header(out, name, type, help);
+    out << "graphzeppelin_" << name << " " << value << "\n";
+  };
+  metric("uptime_seconds", "gauge", "Seconds since the driver was constructed.", uptime_seconds);
+  metric("ingested_updates_total", "counter",
+         "Stream updates passed to the guttering system.", ingested_updates);
+  metric("cancelled_updates_total", "counter",
+         "Stream updates that cancelled before reaching the guttering system.", cancelled_updates);
+  metric("applied_updates_total", "counter", "Updates applied to the vertex sketches.",
+         applied_updates);
+  metric("buffered_updates", "gauge",
+         "Updates in the gutters or work queue waiting to be applied.", buffered_updates);
+
+  prometheus_header(out, "worker_batches_total", "counter", "Batches applied by each worker.");
+  for (size_t i = 0; i < workers.size(); i++)
+    out << "graphzeppelin_worker_batches_total{worker=\"" << i << "\"} " << workers[i].batches
+        << "\n";
+  prometheus_header(out, "worker_updates_total", "counter", "Updates applied by each worker.");
+  for (size_t i = 0; i < workers.size(); i++)
+    out << "graphzeppelin_worker_updates_total{worker=\"" << i << "\"} " << workers[i].updates
+        << "\n";
+
+  prometheus_header(out, "batch_size", "histogram", "Number of updates in each applied batch.");
+  uint64_t cumulative = 0;
+  uint64_t sum = 0;
+  for (size_t i = 0; i < histogram_buckets; i++) {
+    cumulative += batch_size_histogram[i];
+    out << "graphzeppelin_batch_size_bucket{le=\"" << (2ull << i) - 1 << "\"} " << cumulative
+        << "\n";
+  }
+  for (const WorkerStats &worker : workers) sum += worker.updates;
+  out << "graphzeppelin_batch_size_bucket{le=\"+Inf\"} " << cumulative << "\n";
+  out << "graphzeppelin_batch_size_sum " << sum << "\n";
+  out << "graphzeppelin_batch_size_count " << cumulative << "\n";
+
+  metric("flushes_total", "counter", "Flushes of the gutters for queries.", flushes);
+  metric("last_flush_seconds", "gauge", "Duration of the last flush.", last_flush_seconds);
+  metric("flush_seconds_total", "counter", "Total duration of flushes.", total_flush_seconds);
+  metric("queries_total", "counter", "Queries answered by running Boruvka.", query.queries);
+  metric("last_query_rounds", "gauge", "Boruvka rounds of the last query.",
+         query.last_query_rounds);
+  metric("last_query_seconds", "gauge", "Duration of the last query.", query.last_query_seconds);
+
+  prometheus_header(out, "last_query_round_seconds", "gauge",
+                    "Duration of each Boruvka round of the last query.");
+  for (size_t r = 0; r < query.last_query_round_stats.size(); r++)
+    out << "graphzeppelin_last_query_round_seconds{round=\"" << r << "\"} "
+        << query.last_query_round_stats[r].seconds << "\n";
+  prometheus_header(out, "last_query_round_samples", "gauge",
+                    "Sample results of each Boruvka round of the last query.");
+  for (size_t r = 0; r < query.last_query_round_stats.size(); r++) {
+    const QueryRoundStats &round = query.last_query_round_stats[r];
+    std::pair<const char *, uint64_t> results[] = {
+        {"good", round.good_samples}, {"zero", round.zero_samples}, {"fail", round.fail_samples}};
+    for (auto &result : results)
+      out << "graphzeppelin_last_query_round_samples{round=\"" << r << "\",result=\""
+          << result.first << "\"} " << result.second << "\n";
+  }
+  out.flags(flags);
+}
+
+// Write to a temporary file and rename it over the destination
+template <class Writer>
+static void export_atomically(const std::string &filename, Writer write) {
+  std::string tmp_name = filename + ".tmp";
+  {
+    std::ofstream out(tmp_name);
+    if (!out.is_open()) throw std::runtime_error("RuntimeStats: could not open " + tmp_name);
+    write(out);
+    if (!out.good()) throw std::runtime_error("RuntimeStats: could not write " + tmp_name);
+  }
+  if (std::rename(tmp_name.c_str(), filename.c_str()) != 0)
+    throw std::runtime_error("RuntimeStats: could not replace " + filename);
+}
+
+void RuntimeStats::export_json(const std::string &filename) const {
+  export_atomically(filename, [&](std::ostream &out) { write_json(out); });
+}
+
+void RuntimeStats::export_prometheus(const std::string &filename) const {
+  export_atomically(filename, [&](std::ostream &out) { write_prometheus(out); });
+}
@@ -0,0 +1,224 @@
+#include "stream_generator.h"
+
+#include <binary_file_stream.h>
+#include <xxhash.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <stdexcept>
+
+// The murmur3 finalizer. Each step is invertible, so distinct edges have distinct hashes.
+static constexpr uint64_t mix_mult1 = 0xff51afd7ed558ccd;
+static constexpr uint64_t mix_mult2 = 0xc4ceb9fe1a85ec53;
+
+static constexpr uint64_t mult_inverse(uint64_t a) {
+  // Newton's iteration doubles the number of correct low bits, starting from 3
+  uint64_t inv = a;
+  for (int i = 0; i < 5; i++) inv *= 2 - a * inv;
+  return inv;
+}
+
+static inline uint64_t fmix(uint64_t x) {
+  x ^= x >> 33;
+  x *= mix_mult1;
+  x ^= x >> 33;
+  x *= mix_mult2;
+  x ^= x >> 33;
+  return x;
+}
+
+static inline uint64_t inverse_fmix(uint64_t x) {
+  x ^= x >> 33;
+  x *= mult_inverse(mix_mult2);
+  x ^= x >> 33;
+  x *= mult_inverse(mix_mult1);
+  x ^= x >> 33;
+  return x;
+}
+
+// A uniform integer in [0, n)
+static inline uint64_t uniform_below(std::mt19937_64 &gen, uint64_t n) {
+  return ((unsigned __int128)gen() * n) >> 64;
+}
+
+static inline double uniform_real(uint64_t bits) { return (bits >> 11) * 0x1.0p-53; }
+
+StreamGenerator::StreamGenerator(const StreamGeneratorConfiguration &config) : config(config) {
+  generate_edges();
+}
+
+uint64_t StreamGenerator::hash_edge(Edge edge) const {
+  uint64_t key = ((uint64_t)std::min(edge.src, edge.dst) << 32) | std::max(edge.src, edge.dst);
+  return fmix(key ^ config._seed);
+}
+
+Edge StreamGenerator::unhash_edge(uint64_t hash) const {
+  uint64_t key = inverse_fmix(hash) ^ config._seed;
+  return {(node_id_t)(key >> 32), (node_id_t)key};
+}
+
+bool StreamGenerator::sample_edge(std::mt19937_64 &gen, Edge &edge) const {
+  node_id_t n = config._num_vertices;
+  for (size_t attempt = 0; attempt < max_sample_attempts; attempt++) {
+    node_id_t src, dst;
+    if (config._model == ERDOS_RENYI) {
+      src = uniform_below(gen, n);
+      dst = uniform_below(gen, n);
+    } else if (config._model == RMAT) {
+      // Descend into a quadrant of the adjacency matrix once per bit of the vertex ids. Each
+      // level uses 16 random bits, so one draw covers four levels.
+      int scale = 64 - __builtin_clzll((uint64_t)n - 1);
+      uint32_t a = config._rmat_a * 65536;
+      uint32_t ab = (config._rmat_a + config._rmat_b) * 65536;
+      uint32_t abc = (config._rmat_a + config._rmat_b + config._rmat_c) * 65536;
+      uint64_t s = 0, d = 0, bits = 0;
+      for (int level = 0; level < scale; level++) {
+        if (level % 4 == 0) bits = gen();
+        uint32_t r = bits & 0xffff;
+        bits >>= 16;
+        bool right = (r >= a) & ((r < ab) | (r >= abc));
+        bool down = r >= ab;
+        s = (s << 1) | down;
+        d = (d << 1) | right;
+      }
+      if (s >= n || d >= n) continue;
+      src = s;
+      dst = d;
+    } else {
+      // Chung-Lu: pick each endpoint with probability proportional to its weight (i+1)^-alpha,
+      // which gives degree exponent 1 + 1/alpha. Sample the continuous approximation by
+      // inverting its CDF.
+      double alpha = 1 / (config._power_law_exponent - 1);
+      double top = std::pow((double)n + 1, 1 - alpha) - 1;
+      auto sample_vertex = [&]() {
+        double x = std::pow(1 + uniform_real(gen()) * top, 1 / (1 - alpha));
+        return (node_id_t)std::min((double)n - 1, std::floor(x) - 1);
+      };
+      src = sample_vertex();
+      dst = sample_vertex();
+    }
+    if (src != dst) {
+      edge = {src, dst};
+      return true;
+    }
+  }
+  return false;
+}
+
+void StreamGenerator::edge_fate(uint64_t hash, bool &churned, bool &deleted) const {
+  uint64_t r = XXH3_64bits_withSeed(&hash, sizeof(hash), config._seed + 1);
+  churned = uniform_real(r << 32) < config._churn;
+  deleted = uniform_real(r) < config._delete_fraction;
+}
+
+void StreamGenerator::generate_edges() {
+  edge_id_t samples = config._num_edges;
+  // aim for buckets of about 64Ki edges
+  bucket_bits = 6;
+  while (bucket_bits < 14 && (samples >> (bucket_bits + 16)) > 0) bucket_bits++;
+  size_t num_buckets = size_t(1) << bucket_bits;
+  size_t block_samples = std::max((edge_id_t)1 << 16, (samples + 1023) / 1024);
+  size_t num_blocks = (samples + block_samples - 1) / block_samples;
+
+  // Every block of samples is drawn from its own generator, so it can be drawn twice: once to
+  // count the samples of each bucket and once to place them. Exceptions cannot leave a parallel
+  // loop, so a failed sample stops its block and is reported after the counting pass.
+  std::atomic<bool> sampling_failed{false};
+  auto for_each_sample = [&](size_t block, auto func) {
+    std::seed_seq block_seed{config._seed, (size_t)block};
+    std::mt19937_64 gen(block_seed);
+    edge_id_t end = std::min((block + 1) * block_samples, samples);
+    Edge edge;
+    for (edge_id_t i = block * block_samples; i < end; i++) {
+      if (!sample_edge(gen, edge)) {
+        sampling_failed = true;
+        return;
+      }
+      uint64_t hash = hash_edge(edge);
+      func(hash, hash >> (64 - bucket_bits));
+    }
+  };
+
+  std::vector<edge_id_t> block_offsets(num_blocks * num_buckets);  // [block][bucket]
+#pragma omp parallel for schedule(dynamic)
+  for (size_t block = 0; block < num_blocks; block++) {
+    edge_id_t *counts = &block_offsets[block * num_buckets];
+    for_each_sample(block, [&](uint64_t, size_t b) { counts[b]++; });
+  }
+  if (sampling_failed)
+    throw std::runtime_error("StreamGenerator: the model almost never samples an edge between " +
+                             std::string("distinct vertices"));
+  buckets.resize(num_buckets);
+  for (size_t b = 0; b < num_buckets; b++) {
+    edge_id_t total = 0;
+    for (size_t block = 0; block < num_blocks; block++) {
+      edge_id_t count = block_offsets[block * num_buckets + b];
+      block_offsets[block * num_buckets + b] = total;
+      total += count;
+    }
+    buckets[b].resize(total);
+  }
+#pragma omp parallel for schedule(dynamic)
+  for (size_t block = 0; block < num_blocks; block++) {
+    edge_id_t *offsets = &block_offsets[block * num_buckets];
+    for_each_sample(block, [&](uint64_t hash, size_t b) { buckets[b][offsets[b]++] = hash; });
+  }
+
+  // deduplicate each bucket and count its updates
+  bucket_updates.resize(num_buckets);
+  edge_id_t edges = 0, updates = 0, final_edges = 0;
+#pragma omp parallel for schedule(dynamic) reduction(+ : edges, updates, final_edges)
+  for (size_t b = 0; b < num_buckets; b++) {
+    std::sort(buckets[b].begin(), buckets[b].end());
+    buckets[b].erase(std::unique(buckets[b].begin(), buckets[b].end()), buckets[b].end());
+    buckets[b].shrink_to_fit();
+    bucket_updates[b] = 0;
+    for (uint64_t hash : buckets[b]) {
+      bool churned, deleted;
+      edge_fate(hash, churned, deleted);
+      bucket_updates[b] += 1 + 2 * churned + deleted;
+      final_edges += !deleted;
+    }
+    edges += buckets[b].size();
+    updates += bucket_updates[b];
+  }
+  num_edges = edges;
+  num_updates = updates;
+  num_final_edges = final_edges;
+}
+
+void StreamGenerator::emit_bucket(size_t bucket, std::vector<GraphStreamUpdate> &out) const {
+  size_t begin = out.size();
+  out.resize(begin + bucket_updates[bucket]);
+  GraphStreamUpdate *upd = out.data() + begin;
+
+  for (uint64_t hash : buckets[bucket]) *upd++ = {INSERT, unhash_edge(hash)};
+  for (UpdateType type : {DELETE, INSERT}) {
+    for (uint64_t hash : buckets[bucket]) {
+      bool churned, deleted;
+      edge_fate(hash, churned, deleted);
+      if (churned) *upd++ = {(uint8_t)type, unhash_edge(hash)};
+    }
+  }
+  for (uint64_t hash : buckets[bucket]) {
+    bool churned, deleted;
+    edge_fate(hash, churned, deleted);
+    if (deleted) *upd++ = {DELETE, unhash_edge(hash)};
+  }
+}
+
+void StreamGenerator::write_binary_stream(const std::string &file_name) const {
+  BinaryFileStream out(file_name, false);
+  out.write_header(config._num_vertices, num_updates);
+  for_each_batch([&](GraphStreamUpdate *updates, size_t num) { out.write_updates(updates, num); });
+}
+
+std::vector<GraphStreamUpdate> StreamGenerator::get_updates() const {
+  std::vector<GraphStreamUpdate> updates;
+  updates.reserve(num_updates);
+  for_each_batch([&](GraphStreamUpdate *batch, size_t num) {
+    updates.insert(updates.end(), batch, batch + num);
+  });
+  return updates;
+}
@@ -0,0 +1,92 @@
+#include <iostream>
+
+#include "stream_generator_configuration.h"
+
+StreamGeneratorConfiguration& StreamGeneratorConfiguration::model(GraphModel model) {
+  _model = model;
+  return *this;
+}
+
+StreamGeneratorConfiguration& StreamGeneratorConfiguration::num_vertices(node_id_t num_vertices) {
+  _num_vertices = num_vertices;
+  if (_num_vertices < 2) {
+    std::cout << "num_vertices=" << _num_vertices << " is out of bounds. [2, infty)"
+              << "Defaulting to 2." << std::endl;
+    _num_vertices = 2;
+  }
+  return *this;
+}
+
+StreamGeneratorConfiguration& StreamGeneratorConfiguration::num_edges(edge_id_t num_edges) {
+  _num_edges = num_edges;
+  return *this;
+}
+
+StreamGeneratorConfiguration& StreamGeneratorConfiguration::churn(double churn) {
+  _churn = churn;
+  if (_churn < 0 || _churn > 1) {
+    std::cout << "churn=" << _churn << " is out of bounds. [0, 1]"
+              << "Defaulting to 0." << std::endl;
+    _churn = 0;
+  }
+  return *this;
+}
+
+StreamGeneratorConfiguration& StreamGeneratorConfiguration::delete_fraction(double fraction) {
+  _delete_fraction = fraction;
+  if (_delete_fraction < 0 || _delete_fraction > 1) {
+    std::cout << "delete_fraction=" << _delete_fraction << " is out of bounds. [0, 1]"
+              << "Defaulting to 0." << std::endl;
+    _delete_fraction = 0;
+  }
+  return *this;
+}
+
+StreamGeneratorConfiguration& StreamGeneratorConfiguration::rmat_probabilities(double a, double b,
+                                                                               double c) {
+  // with b + c == 0 both endpoints descend into the same quadrants, giving only self loops
+  if (a < 0 || b < 0 || c < 0 || a + b + c > 1 || b + c == 0) {
+    std::cout << "rmat_probabilities=(" << a << ", " << b << ", " << c << ") are out of bounds. "
+              << "Each must be non-negative with sum at most 1, and b + c must be positive. "
+              << "Defaulting to (0.57, 0.19, 0.19)." << std::endl;
+    a = 0.57;
+    b = 0.19;
+    c = 0.19;
+  }
+  _rmat_a = a;
+  _rmat_b = b;
+  _rmat_c = c;
+  return *this;
+}
+
+StreamGeneratorConfiguration& StreamGeneratorConfiguration::power_law_exponent(double exponent) {
+  _power_law_exponent = exponent;
+  if (_power_law_exponent <= 2) {
+    std::cout << "power_law_exponent=" << _power_law_exponent << " is out of bounds. (2, infty)"
+              << "Defaulting to 2.5." << std::endl;
+    _power_law_exponent = 2.5;
+  }
+  return *this;
+}
+
+StreamGeneratorConfiguration& StreamGeneratorConfiguration::seed(size_t seed) {
+  _seed = seed;
+  return *this;
+}
+
+std::ostream& operator<< (std::ostream &out, const StreamGeneratorConfiguration &conf) {
+    out << "StreamGenerator Configuration:" << std::endl;
+    std::string model = "ErdosRenyi";
+    if (conf._model == RMAT)
+      model = "RMAT(" + std::to_string(conf._rmat_a) + ", " + std::to_string(conf._rmat_b) +
+              ", " + std::to_string(conf._rmat_c) + ")";
+    else if (conf._model == POWER_LAW)
+      model = "PowerLaw(" + std::to_string(conf._power_law_exponent) + ")";
+    out << " Graph model           = " << model << std::endl;
+    out << " Number of vertices    = " << conf._num_vertices << std::endl;
+    out << " Sampled edges         = " << conf._num_edges << std::endl;
+    out << " Churn                 = " << conf._churn << std::endl;
+    out << " Delete fraction       = " << conf._delete_fraction << std::endl;
+    out << " Seed                  = " << conf._seed;
+    return out;
+  }
@@ -0,0 +1,194 @@
+#include "text_edge_list_stream.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <limits>
+
+static inline bool is_digit(char c) { return (unsigned char)(c - '0') < 10; }
+static inline bool is_separator(char c) { return c == ' ' || c == '\t' || c == ',' || c == '\r'; }
+
+static inline const char *find_line_end(const char *p, const char *end) {
+  const char *line_end = (const char *)memchr(p, '\n', end - p);
+  return line_end == nullptr ? end : line_end;
+}
+
+// Does the line [p, line_end) hold an update, rather than being blank or a comment
+static inline bool is_update(const char *p, const char *line_end) {
+  while (p < line_end && is_separator(*p)) p++;
+  return p < line_end && *p != '#' && *p != '%';
+}
+
+// Parse the next value of a line. Returns false if there is none.
+static inline bool parse_value(const char *&p, const char *line_end, uint64_t &x) {
+  while (p < line_end && is_separator(*p)) p++;
+  if (p == line_end || !is_digit(*p)) return false;
+  x = 0;
+  while (p < line_end && is_digit(*p)) {
+    x = x * 10 + (*p++ - '0');
+    if (x > std::numeric_limits<node_id_t>::max()) return false;
+  }
+  return true;
+}
+
+TextEdgeListStream::TextEdgeListStream(const std::string &file_name, node_id_t num_vertices,
+                                       bool has_type, size_t chunk_bytes)
+    : file_name(file_name), has_type(has_type) {
+  stream_fd = open(file_name.c_str(), O_RDONLY);
+  if (stream_fd < 0) throw StreamException("TextEdgeListStream: could not open " + file_name);
+
+  struct stat st;
+  if (fstat(stream_fd, &st) != 0) {
+    close(stream_fd);
+    throw StreamException("TextEdgeListStream: could not read " + file_name);
+  }
+  file_bytes = st.st_size;
+  if (file_bytes > 0) {
+    mapping = (const char *)mmap(nullptr, file_bytes, PROT_READ, MAP_PRIVATE, stream_fd, 0);
+    if (mapping == MAP_FAILED) {
+      close(stream_fd);
+      throw StreamException("TextEdgeListStream: could not map " + file_name);
+    }
+    madvise((void *)mapping, file_bytes, MADV_SEQUENTIAL);
+  }
+
+  this->num_vertices = num_vertices;
+  try {
+    index_chunks(std::max(chunk_bytes, (size_t)1), num_vertices == 0);
+  } catch (...) {
+    if (mapping != nullptr) munmap((void *)mapping, file_bytes);
+    close(stream_fd);
+    throw;
+  }
+  break_index = num_edges;
+}
+
+TextEdgeListStream::~TextEdgeListStream() {
+  if (mapping != nullptr) munmap((void *)mapping, file_bytes);
+  close(stream_fd);
+}
+
+void TextEdgeListStream::index_chunks(size_t chunk_bytes, bool find_vertices) {
+  size_t num_chunks = (file_bytes + chunk_bytes - 1) / chunk_bytes;
+  chunk_begin.resize(num_chunks + 1);
+  chunk_first.resize(num_chunks + 1);
+
+  // each chunk but the first begins after the first newline at or past its nominal start
+#pragma omp parallel for
+  for (size_t c = 1; c < num_chunks; c++) {
+    const char *nominal = mapping + c * chunk_bytes - 1;
+    chunk_begin[c] = find_line_end(nominal, mapping + file_bytes) - mapping + 1;
+  }
+  if (num_chunks > 0) chunk_begin[0] = 0;
+  chunk_begin[num_chunks] = file_bytes;
+  for (size_t c = 1; c < num_chunks; c++)
+    chunk_begin[c] = std::min(chunk_begin[c], file_bytes);
+
+  bool malformed = false;
+  node_id_t max_vertex = 0;
+#pragma omp parallel for reduction(max : max_vertex) reduction(|| : malformed)
+  for (size_t c = 0; c < num_chunks; c++) {
+    const char *p = mapping + chunk_begin[c];
+    const char *end = mapping + chunk_begin[c + 1];
+    edge_id_t updates = 0;
+    while (p < end) {
+      const char *line_end = find_line_end(p, end);
+      if (is_update(p, line_end)) {
+        if (find_vertices) {
+          GraphStreamUpdate upd;
+          try {
+            parse_update(p, line_end, upd);
+            max_vertex = std::max({max_vertex, upd.edge.src, upd.edge.dst});
+          } catch (StreamException &) {
+            malformed = true;
+          }
+        }
+        updates++;
+      }
+      p = line_end + 1;
+    }
+    chunk_first[c + 1] = updates;
+  }
+  if (malformed) throw StreamException("TextEdgeListStream: malformed line in " + file_name);
+
+  chunk_first[0] = 0;
+  for (size_t c = 0; c < num_chunks; c++) chunk_first[c + 1] += chunk_first[c];
+  num_edges = chunk_first[num_chunks];
+  if (!find_vertices) return;
+  // one more than the largest id must fit in a node_id_t
+  if (max_vertex == std::numeric_limits<node_id_t>::max())
+    throw StreamException("TextEdgeListStream: vertex id " + std::to_string(max_vertex) + " in " +
+                          file_name + " is too large");
+  num_vertices = num_edges > 0 ? max_vertex + 1 : 0;
+}
+
+void TextEdgeListStream::parse_update(const char *p, const char *line_end,
+                                      GraphStreamUpdate &out) {
+  uint64_t type = INSERT, src, dst;
+  if ((has_type && (!parse_value(p, line_end, type) || type > DELETE)) ||
+      !parse_value(p, line_end, src) || !parse_value(p, line_end, dst) ||
+      (num_vertices > 0 && (src >= num_vertices || dst >= num_vertices))) {
+    throw StreamException("TextEdgeListStream: malformed line in " + file_name + ": " +
+                          std::string(p, line_end));
+  }
+  out = {(uint8_t)type, {(node_id_t)src, (node_id_t)dst}};
+}
+
+void TextEdgeListStream::parse_chunk(size_t chunk, edge_id_t skip, edge_id_t count,
+                                     GraphStreamUpdate *out) {
+  const char *p = mapping + chunk_begin[chunk];
+  const char *end = mapping + chunk_begin[chunk + 1];
+  for (edge_id_t i = 0; i < skip + count; p++) {
+    const char *line_end = find_line_end(p, end);
+    if (is_update(p, line_end)) {
+      if (i >= skip) parse_update(p, line_end, out[i - skip]);
+      i++;
+    }
+    p = line_end;
+  }
+}
+
+size_t TextEdgeListStream::get_update_buffer(GraphStreamUpdate *upd_buf, size_t num_updates) {
+  edge_id_t begin = stream_off.load();
+  edge_id_t end;
+  do {
+    edge_id_t break_idx = break_index.load();
+    if (begin >= break_idx) {
+      upd_buf[0] = {BREAKPOINT, {0, 0}};
+      return 1;
+    }
+    end = std::min(begin + num_updates, break_idx);
+    // end on a chunk boundary so the next claim does not parse part of this chunk again
+    if (end != break_idx) {
+      edge_id_t boundary = chunk_first[chunk_of(end)];
+      if (boundary > begin) end = boundary;
+    }
+  } while (!stream_off.compare_exchange_weak(begin, end));
+
+  get_updates(begin, end, upd_buf);
+  return end - begin;
+}
+
+void TextEdgeListStream::get_updates(edge_id_t begin, edge_id_t end, GraphStreamUpdate *out) {
+  end = std::min(end, num_edges);
+  if (begin >= end) return;
+  for (size_t c = chunk_of(begin); chunk_first[c] < end; c++) {
+    edge_id_t first = std::max(begin, chunk_first[c]);
+    edge_id_t last = std::min(end, chunk_first[c + 1]);
+    if (last > first) parse_chunk(c, first - chunk_first[c], last - first, out + (first - begin));
+  }
+}
+
+bool TextEdgeListStream::set_break_point(edge_id_t break_idx) {
+  break_idx = std::min(break_idx, num_edges);
+  if (break_idx < stream_off) return false;
+  break_index = break_idx;
+  return true;
+}
+
+void TextEdgeListStream::serialize_metadata(std::ostream &out) {
+  out << "TextEdgeListStream " << file_name << std::endl;
+}
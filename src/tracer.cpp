@@ -0,0 +1,152 @@
+#include "tracer.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+std::atomic<bool> Tracer::is_enabled{false};
+
+const char *trace_event_name(TraceEvent event) {
+  switch (event) {
+    case TRACE_STREAM_READ: return "stream_read";
+    case TRACE_BATCH_APPLY: return "batch_apply";
+    case TRACE_GUTTER_FLUSH: return "gutter_flush";
+    case TRACE_PREP_QUERY_FLUSH: return "prep_query_flush";
+    case TRACE_BORUVKA_ROUND: return "boruvka_round";
+    case TRACE_POOL_TASK: return "pool_task";
+    default: return "unknown";
+  }
+}
+
+// The name of the argument of each event in the trace
+static const char *trace_arg_name(TraceEvent event) {
+  switch (event) {
+    case TRACE_STREAM_READ: return "updates";
+    case TRACE_BATCH_APPLY: return "updates";
+    case TRACE_GUTTER_FLUSH: return "partition";
+    case TRACE_BORUVKA_ROUND: return "round";
+    default: return nullptr;
+  }
+}
+
+struct TraceSpan {
+  uint64_t begin_ns;
+  uint64_t end_ns;
+  uint64_t arg;
+  TraceEvent event;
+};
+
+// The ring buffer of a thread. Only the thread writes it.
+struct TraceBuffer {
+  std::vector<TraceSpan> spans;
+  size_t mask;
+  std::atomic<uint64_t> num_recorded{0};  // spans ever recorded, the latest are in the ring
+  std::string thread_name;
+  size_t tid;
+
+  TraceBuffer(size_t capacity, size_t tid) : tid(tid) {
+    size_t size = 1;
+    while (size < capacity) size *= 2;
+    spans.resize(size);
+    mask = size - 1;
+  }
+};
+
+static std::mutex registry_mtx;
+static std::vector<std::shared_ptr<TraceBuffer>> buffers;  // of every thread that has recorded
+static size_t thread_capacity = 1 << 16;
+static size_t next_tid = 0;
+
+static thread_local std::shared_ptr<TraceBuffer> thread_buffer;
+static thread_local std::string thread_name;
+
+void Tracer::set_thread_capacity(size_t num_spans) {
+  std::lock_guard<std::mutex> lk(registry_mtx);
+  thread_capacity = std::max(num_spans, (size_t)1);
+}
+
+void Tracer::set_thread_name(const std::string &name) {
+  thread_name = name;
+  if (thread_buffer != nullptr) {
+    std::lock_guard<std::mutex> lk(registry_mtx);
+    thread_buffer->thread_name = name;
+  }
+}
+
+void Tracer::record(TraceEvent event, uint64_t begin_ns, uint64_t end_ns, uint64_t arg) {
+  if (thread_buffer == nullptr) {
+    // the registry keeps the buffer after the thread exits, so its spans are still written
+    std::lock_guard<std::mutex> lk(registry_mtx);
+    thread_buffer = std::make_shared<TraceBuffer>(thread_capacity, next_tid++);
+    thread_buffer->thread_name = thread_name;
+    buffers.push_back(thread_buffer);
+  }
+  TraceBuffer &buf = *thread_buffer;
+  uint64_t idx = buf.num_recorded.load(std::memory_order_relaxed);
+  buf.spans[idx & buf.mask] = {begin_ns, end_ns, arg, event};
+  buf.num_recorded.store(idx + 1, std::memory_order_release);
+}
+
+void Tracer::clear() {
+  // the lock only guards the registry, a thread recording now could undo its reset
+  std::lock_guard<std::mutex> lk(registry_mtx);
+  for (auto &buf : buffers) buf->num_recorded = 0;
+  // buffers of exited threads are no longer needed
+  buffers.erase(std::remove_if(buffers.begin(), buffers.end(),
+                               [](const std::shared_ptr<TraceBuffer> &buf) {
+                                 return buf.use_count() == 1;
+                               }),
+                buffers.end());
+}
+
+void Tracer::write_chrome_trace(std::ostream &out) {
+  std::lock_guard<std::mutex> lk(registry_mtx);
+
+  // timestamps are relative to the earliest span
+  uint64_t epoch_ns = UINT64_MAX;
+  for (auto &buf : buffers) {
+    uint64_t recorded = buf->num_recorded.load(std::memory_order_acquire);
+    uint64_t first = recorded > buf->spans.size() ? recorded - buf->spans.size() : 0;
+    for (uint64_t i = first; i < recorded; i++)
+      epoch_ns = std::min(epoch_ns, buf->spans[i & buf->mask].begin_ns);
+  }
+
+  auto flags = out.flags();
+  out << std::fixed << std::setprecision(3);
+  out << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+  bool first_event = true;
+  auto separator = [&]() {
+    out << (first_event ? "\n" : ",\n");
+    first_event = false;
+  };
+  for (auto &buf : buffers) {
+    std::string name =
+        buf->thread_name.empty() ? "thread " + std::to_string(buf->tid) : buf->thread_name;
+    separator();
+    out << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buf->tid
+        << ", \"args\": {\"name\": \"" << name << "\"}}";
+
+    uint64_t recorded = buf->num_recorded.load(std::memory_order_acquire);
+    uint64_t first = recorded > buf->spans.size() ? recorded - buf->spans.size() : 0;
+    for (uint64_t i = first; i < recorded; i++) {
+      const TraceSpan &span = buf->spans[i & buf->mask];
+      separator();
+      out << "{\"name\": \"" << trace_event_name(span.event) << "\", \"ph\": \"X\", \"pid\": 1"
+          << ", \"tid\": " << buf->tid << ", \"ts\": " << (span.begin_ns - epoch_ns) / 1e3
+          << ", \"dur\": " << (span.end_ns - span.begin_ns) / 1e3;
+      const char *arg_name = trace_arg_name(span.event);
+      if (arg_name != nullptr) out << ", \"args\": {\"" << arg_name << "\": " << span.arg << "}";
+      out << "}";
+    }
+  }
+  out << "\n]}" << std::endl;
+  out.flags(flags);
+}
+
+void Tracer::write_chrome_trace(const std::string &filename) {
+  std::ofstream out(filename);
+  write_chrome_trace(out);
+}
@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+
+#include <binary_file_stream.h>
+
+#include <thread>
+#include <vector>
+
+#include "async_binary_stream.h"
+
+static std::vector<GraphStreamUpdate> write_test_stream(const std::string &file_name,
+                                                        node_id_t num_vertices) {
+  std::vector<GraphStreamUpdate> updates;
+  for (node_id_t i = 0; i < num_vertices; i++) {
+    for (node_id_t j = i + 1; j < num_vertices; j += 3) {
+      updates.push_back({(uint8_t)((i + j) % 2 == 0 ? INSERT : DELETE), {i, j}});
+    }
+  }
+  BinaryFileStream out(file_name, false);
+  out.write_header(num_vertices, updates.size());
+  out.write_updates(updates.data(), updates.size());
+  return updates;
+}
+
+// read the stream until the breakpoint, checking the updates arrive in order
+static size_t read_in_order(AsyncBinaryStream &stream,
+                            const std::vector<GraphStreamUpdate> &updates, size_t first) {
+  std::vector<GraphStreamUpdate> buf(100);
+  size_t idx = first;
+  while (true) {
+    size_t got = stream.get_update_buffer(buf.data(), buf.size());
+    if (buf[0].type == BREAKPOINT) break;
+    for (size_t i = 0; i < got; i++, idx++) {
+      EXPECT_EQ(updates[idx].type, buf[i].type);
+      EXPECT_EQ(updates[idx].edge, buf[i].edge);
+    }
+  }
+  return idx - first;
+}
+
+TEST(AsyncBinaryStreamTest, UpdatesMatchFileContents) {
+  std::vector<GraphStreamUpdate> updates = write_test_stream("./async_test.data", 200);
+  // small buffers so the file spans many blocks
+  for (bool use_io_uring : {true, false}) {
+    AsyncBinaryStream stream("./async_test.data", 3, 1000, use_io_uring);
+    if (!use_io_uring) {
+      ASSERT_FALSE(stream.using_io_uring());
+    }
+    ASSERT_EQ(200, stream.vertices());
+    ASSERT_EQ(updates.size(), stream.edges());
+    ASSERT_EQ(updates.size(), read_in_order(stream, updates, 0));
+  }
+}
+
+TEST(AsyncBinaryStreamTest, BreakpointsAndSeek) {
+  std::vector<GraphStreamUpdate> updates = write_test_stream("./async_test.data", 100);
+  AsyncBinaryStream stream("./async_test.data", 2, 500);
+
+  ASSERT_TRUE(stream.set_break_point(250));
+  ASSERT_EQ(250, read_in_order(stream, updates, 0));
+  ASSERT_FALSE(stream.set_break_point(100));
+  ASSERT_TRUE(stream.set_break_point(END_OF_STREAM));
+  ASSERT_EQ(updates.size() - 250, read_in_order(stream, updates, 250));
+
+  // seek part way into a block and read to the end again
+  stream.seek(123);
+  ASSERT_EQ(updates.size() - 123, read_in_order(stream, updates, 123));
+  stream.seek(0);
+  ASSERT_EQ(updates.size(), read_in_order(stream, updates, 0));
+}
+
+TEST(AsyncBinaryStreamTest, ConcurrentReaders) {
+  std::vector<GraphStreamUpdate> updates = write_test_stream("./async_test.data", 300);
+  AsyncBinaryStream stream("./async_test.data", 4, 2000);
+
+  // every update should be read by exactly one thread
+  std::vector<size_t> seen(updates.size());
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 4; t++) {
+    readers.emplace_back([&]() {
+      std::vector<GraphStreamUpdate> buf(37);
+      while (true) {
+        size_t got = stream.get_update_buffer(buf.data(), buf.size());
+        if (buf[0].type == BREAKPOINT) break;
+        for (size_t i = 0; i < got; i++) {
+          Edge e = buf[i].edge;
+          // each edge appears once in the stream, so find it by its endpoints
+          size_t row = 0;
+          for (node_id_t s = 0; s < e.src; s++) row += (300 - s - 1 + 2) / 3;
+          __atomic_fetch_add(&seen[row + (e.dst - e.src - 1) / 3], 1, __ATOMIC_RELAXED);
+        }
+      }
+    });
+  }
+  for (auto &reader : readers) reader.join();
+  for (size_t i = 0; i < updates.size(); i++) ASSERT_EQ(1, seen[i]);
+}
@@ -0,0 +1,54 @@
+#include <gtest/gtest.h>
+
+#include "autotuner.h"
+#include "ingested_graph.h"
+
+TEST(AutotunerTest, ThreadSplits) {
+  using Splits = std::vector<std::pair<size_t, size_t>>;
+  ASSERT_EQ(Splits({{1, 1}}), Autotuner::thread_splits(1));
+  ASSERT_EQ(Splits({{1, 1}}), Autotuner::thread_splits(2));
+  ASSERT_EQ(Splits({{7, 1}, {6, 2}, {4, 4}}), Autotuner::thread_splits(8));
+}
+
+TEST(AutotunerTest, TuneSynthetic) {
+  auto tune_config = AutotuneConfiguration()
+                         .total_threads(2)
+                         .calibration_updates(20000)
+                         .batch_factors({1, 2})
+                         .gutter_scales({1, 2})
+                         .seed(3);
+  auto base_driver_config = DriverConfiguration().gutter_sys(STANDALONE);
+  AutotuneResult result = Autotuner(tune_config).tune_synthetic(1024, base_driver_config);
+
+  // the candidates already measured by an earlier parameter are not run again
+  ASSERT_EQ(3, result.trials.size());
+  for (const AutotuneTrial &trial : result.trials) {
+    ASSERT_GT(trial.updates_per_second, 0);
+    ASSERT_GT(trial.gutter_bytes, 0);
+    ASSERT_LE(trial.updates_per_second, result.best.updates_per_second);
+  }
+  ASSERT_EQ(STANDALONE, result.driver_config.get_gutter_sys());
+  ASSERT_EQ(result.best.worker_threads, result.driver_config.get_worker_threads());
+  ASSERT_EQ(result.best.gutter_bytes, result.driver_config.gutter_conf().get_gutter_bytes());
+  ASSERT_EQ(result.best.batch_factor, result.alg_config.get_batch_factor());
+  ASSERT_EQ(result.best.stream_threads, result.stream_threads);
+}
+
+TEST(AutotunerTest, TuneRewindsStream) {
+  node_id_t num_vertices = 1024;
+  auto gen_config = StreamGeneratorConfiguration().num_vertices(num_vertices).num_edges(20000);
+  IngestedGraph graph(gen_config);
+
+  auto tune_config = AutotuneConfiguration()
+                         .total_threads(2)
+                         .calibration_updates(5000)
+                         .batch_factors({1})
+                         .gutter_scales({1});
+  AutotuneResult result = Autotuner(tune_config).tune(graph.stream);
+  ASSERT_EQ(1, result.trials.size());
+
+  // the whole stream is ingested with the tuned configuration
+  graph.build(7, result.alg_config, result.driver_config, result.stream_threads);
+  graph.ingest();
+  ASSERT_EQ(graph.stream.edges(), graph.driver->get_stats().ingested_updates);
+}
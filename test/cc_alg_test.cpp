@@ -6,9 +6,11 @@
 #include <algorithm>
 #include <fstream>
 
+#include "async_binary_stream.h"
 #include "cc_sketch_alg.h"
 #include "graph_sketch_driver.h"
 #include "graph_verifier.h"
+#include "in_memory_stream.h"
 
 static size_t get_seed() {
   auto now = std::chrono::high_resolution_clock::now();
@@ -348,3 +350,305 @@ TEST(CCAlgTest, MTStreamWithMultipleQueries) {
     cc_alg.connected_components();
   }
 }
+
+TEST(CCAlgTest, InPlaceMergeQueryDuringStream) {
+  auto driver_config = DriverConfiguration().gutter_sys(STANDALONE);
+  auto cc_config = CCAlgConfiguration().merge_mode(IN_PLACE_MERGE);
+  generate_stream(get_seed(), 1024, 0.03, 0.5, 0.05, 3, "sample.txt", "cumul_sample.txt");
+  std::ifstream in{"./sample.txt"};
+  AsciiFileStream stream{"./sample.txt"};
+  node_id_t num_nodes = stream.vertices();
+  edge_id_t num_edges = stream.edges();
+  edge_id_t tenth = num_edges / 10;
+
+  CCSketchAlg cc_alg{num_nodes, get_seed(), cc_config};
+  GraphSketchDriver<CCSketchAlg> driver(&cc_alg, &stream, driver_config);
+  GraphVerifier verify(num_nodes);
+
+  int type;
+  node_id_t a, b;
+
+  // read header from verify stream
+  in >> a >> b;
+
+  for (int j = 0; j < 9; j++) {
+    for (edge_id_t i = 0; i < tenth; i++) {
+      in >> type >> a >> b;
+      verify.edge_update({a, b});
+    }
+
+    driver.process_stream_until(tenth * (j + 1));
+    driver.prep_query(CONNECTIVITY);
+    driver.check_verifier(verify);
+
+    // the in-place merges must leave the sketches as we found them
+    cc_alg.write_binary("./in_place_before.txt");
+    cc_alg.connected_components();
+    cc_alg.write_binary("./in_place_after.txt");
+
+    std::ifstream before{"./in_place_before.txt", std::ios::binary};
+    std::ifstream after{"./in_place_after.txt", std::ios::binary};
+    ASSERT_TRUE(std::equal(std::istreambuf_iterator<char>(before), std::istreambuf_iterator<char>(),
+                           std::istreambuf_iterator<char>(after)));
+  }
+  num_edges -= 9 * tenth;
+  while (num_edges--) {
+    in >> type >> a >> b;
+    verify.edge_update({a, b});
+  }
+
+  driver.process_stream_until(END_OF_STREAM);
+  driver.prep_query(CONNECTIVITY);
+  driver.check_verifier(verify);
+
+  cc_alg.connected_components();
+}
+
+TEST(CCAlgTest, ExhaustiveSamplingCorrectness) {
+  auto driver_config = DriverConfiguration().gutter_sys(STANDALONE);
+  int num_trials = 5;
+  while (num_trials--) {
+    generate_stream(get_seed(), 1024, 0.03, 0.5, 0.005, 3, "sample.txt", "cumul_sample.txt");
+    AsciiFileStream stream{"./sample.txt"};
+    node_id_t num_nodes = stream.vertices();
+
+    // exhaustive sampling should work with either method of merging supernodes
+    auto cc_config = CCAlgConfiguration().exhaustive_sampling(true);
+    if (num_trials % 2 == 0) cc_config.merge_mode(IN_PLACE_MERGE);
+    CCSketchAlg cc_alg{num_nodes, get_seed(), cc_config};
+
+    GraphSketchDriver<CCSketchAlg> driver(&cc_alg, &stream, driver_config);
+    driver.process_stream_until(END_OF_STREAM);
+    driver.prep_query(CONNECTIVITY);
+    driver.check_verifier(GraphVerifier(1024, "./cumul_sample.txt"));
+
+    cc_alg.connected_components();
+    ASSERT_EQ(cc_alg.last_query_round_times.size(), cc_alg.last_query_rounds + 1);
+  }
+}
+
+TEST(CCAlgTest, SkewedBatchesMultipleWorkers) {
+  // a star graph whose hub receives far more updates than any other vertex, so its batches
+  // are split among the idle workers when flushing
+  node_id_t num_nodes = 4096;
+  std::vector<GraphStreamUpdate> updates;
+  GraphVerifier verify(num_nodes);
+  for (int churn = 0; churn < 4; churn++) {
+    for (node_id_t i = 2; i < num_nodes; i += 2) {
+      updates.push_back({INSERT, {0, i}});
+      updates.push_back({DELETE, {0, i}});
+    }
+  }
+  for (node_id_t i = 1; i < num_nodes; i += 2) {
+    updates.push_back({INSERT, {0, i}});
+    verify.edge_update({0, i});
+  }
+  {
+    BinaryFileStream out("./skewed_stream.data", false);
+    out.write_header(num_nodes, updates.size());
+    out.write_updates(updates.data(), updates.size());
+  }
+
+  BinaryFileStream stream("./skewed_stream.data");
+  auto driver_config = DriverConfiguration().gutter_sys(STANDALONE).worker_threads(4);
+  driver_config.gutter_conf().gutter_bytes(1 << 16);
+  CCSketchAlg cc_alg{num_nodes, get_seed()};
+  GraphSketchDriver<CCSketchAlg> driver(&cc_alg, &stream, driver_config);
+  driver.process_stream_until(END_OF_STREAM);
+  driver.prep_query(CONNECTIVITY);
+  driver.check_verifier(verify);
+
+  ASSERT_EQ(num_nodes / 2, cc_alg.connected_components().size());
+}
+
+TEST(CCAlgTest, PinnedThreadsAndNumaPlacement) {
+  for (SketchPlacement placement : {INTERLEAVE, PARTITION}) {
+    auto driver_config = DriverConfiguration()
+                             .gutter_sys(STANDALONE)
+                             .worker_threads(4)
+                             .pin_threads(true)
+                             .sketch_placement(placement)
+                             .local_worker_memory(true);
+    generate_stream(get_seed(), 1024, 0.002, 0.5, 0.07, 1, "sample.txt", "cumul_sample.txt");
+    AsciiFileStream stream{"./sample.txt"};
+    node_id_t num_nodes = stream.vertices();
+
+    CCSketchAlg cc_alg{num_nodes, get_seed()};
+    GraphSketchDriver<CCSketchAlg> driver(&cc_alg, &stream, driver_config);
+
+    driver.process_stream_until(END_OF_STREAM);
+    driver.prep_query(CONNECTIVITY);
+    driver.check_verifier(GraphVerifier(1024, "./cumul_sample.txt"));
+
+    cc_alg.connected_components();
+  }
+}
+
+TEST(CCAlgTest, PartitionedIngestion) {
+  auto driver_config = DriverConfiguration().gutter_sys(STANDALONE).worker_threads(4)
+                                            .partition_ingestion(true);
+  generate_stream(get_seed(), 1024, 0.03, 0.5, 0.05, 3, "sample.txt", "cumul_sample.txt");
+  AsciiFileStream stream{"./sample.txt"};
+  node_id_t num_nodes = stream.vertices();
+
+  CCSketchAlg cc_alg{num_nodes, get_seed()};
+  GraphSketchDriver<CCSketchAlg> driver(&cc_alg, &stream, driver_config);
+
+  driver.process_stream_until(END_OF_STREAM);
+  driver.prep_query(CONNECTIVITY);
+  driver.check_verifier(GraphVerifier(1024, "./cumul_sample.txt"));
+
+  cc_alg.connected_components();
+}
+
+TEST(CCAlgTest, CancelChurnBeforeGuttering) {
+  // every edge is inserted and deleted a few times before settling into a forest of stars
+  node_id_t num_nodes = 1024;
+  std::vector<GraphStreamUpdate> updates;
+  GraphVerifier verify(num_nodes);
+  for (node_id_t i = 1; i < num_nodes; i++) {
+    Edge edge = {i - i % 8, i};
+    for (int churn = 0; churn < 3; churn++) {
+      updates.push_back({INSERT, edge});
+      updates.push_back({DELETE, edge});
+    }
+    if (i % 8 != 0) {
+      updates.push_back({INSERT, edge});
+      verify.edge_update(edge);
+    }
+  }
+  {
+    BinaryFileStream out("./churn_stream.data", false);
+    out.write_header(num_nodes, updates.size());
+    out.write_updates(updates.data(), updates.size());
+  }
+
+  BinaryFileStream stream("./churn_stream.data");
+  auto driver_config = DriverConfiguration().gutter_sys(STANDALONE).cancellation_window(256);
+  CCSketchAlg cc_alg{num_nodes, get_seed()};
+  GraphSketchDriver<CCSketchAlg> driver(&cc_alg, &stream, driver_config);
+  driver.process_stream_until(END_OF_STREAM);
+  driver.prep_query(CONNECTIVITY);
+  driver.check_verifier(verify);
+
+  ASSERT_GT(driver.get_cancelled_updates(), updates.size() / 2);
+  ASSERT_EQ(num_nodes / 8, cc_alg.connected_components().size());
+}
+
+TEST(CCAlgTest, GroupedStreamBypassesGutters) {
+  generate_stream(get_seed(), 1024, 0.03, 0.5, 0.05, 3, "sample.txt", "cumul_sample.txt");
+  AsciiFileStream stream{"./sample.txt"};
+  node_id_t num_nodes = stream.vertices();
+
+  // group the stream's updates by vertex, each update appearing in the runs of both endpoints
+  std::vector<std::vector<node_id_t>> runs(num_nodes);
+  GraphStreamUpdate update;
+  while (stream.get_update_buffer(&update, 1) == 1 && update.type != BREAKPOINT) {
+    runs[update.edge.src].push_back(update.edge.dst);
+    runs[update.edge.dst].push_back(update.edge.src);
+  }
+  {
+    GroupedStreamWriter out("./grouped_stream.data", num_nodes);
+    for (node_id_t v = 0; v < num_nodes; v++) out.write_run(v, runs[v].data(), runs[v].size());
+  }
+
+  GroupedStreamReader grouped("./grouped_stream.data");
+  AsciiFileStream empty_stream{"./sample.txt"};
+  auto driver_config = DriverConfiguration().gutter_sys(STANDALONE).worker_threads(4);
+  CCSketchAlg cc_alg{num_nodes, get_seed()};
+  GraphSketchDriver<CCSketchAlg> driver(&cc_alg, &empty_stream, driver_config);
+  driver.process_grouped_stream(grouped);
+  driver.prep_query(CONNECTIVITY);
+  driver.check_verifier(GraphVerifier(1024, "./cumul_sample.txt"));
+
+  cc_alg.connected_components();
+}
+
+TEST(CCAlgTest, MMapStreamWithQueries) {
+  node_id_t num_nodes = 1024;
+  std::vector<GraphStreamUpdate> updates;
+  for (node_id_t i = 0; i + 2 < num_nodes; i += 2) {
+    updates.push_back({INSERT, {i, i + 2}});
+    if (i % 6 == 0) updates.push_back({DELETE, {i, i + 2}});
+  }
+  {
+    BinaryFileStream out("./mmap_stream.data", false);
+    out.write_header(num_nodes, updates.size());
+    out.write_updates(updates.data(), updates.size());
+  }
+
+  MMapBinaryStream stream("./mmap_stream.data");
+  auto driver_config = DriverConfiguration().gutter_sys(STANDALONE).worker_threads(2);
+  CCSketchAlg cc_alg{num_nodes, get_seed()};
+  GraphSketchDriver<CCSketchAlg> driver(&cc_alg, &stream, driver_config, 3);
+
+  GraphVerifier verify(num_nodes);
+  size_t num_queries = 4;
+  for (size_t q = 1; q <= num_queries; q++) {
+    size_t end = updates.size() * q / num_queries;
+    for (size_t i = updates.size() * (q - 1) / num_queries; i < end; i++)
+      verify.edge_update(updates[i].edge);
+    driver.process_stream_until(end);
+    driver.prep_query(CONNECTIVITY);
+    driver.check_verifier(verify);
+    cc_alg.connected_components();
+  }
+}
+
+TEST(CCAlgTest, AsyncStreamMultipleReaders) {
+  node_id_t num_nodes = 1024;
+  std::vector<GraphStreamUpdate> updates;
+  for (node_id_t i = 0; i + 3 < num_nodes; i += 3) {
+    updates.push_back({INSERT, {i, i + 3}});
+    if (i % 9 == 0) updates.push_back({DELETE, {i, i + 3}});
+  }
+  {
+    BinaryFileStream out("./async_stream.data", false);
+    out.write_header(num_nodes, updates.size());
+    out.write_updates(updates.data(), updates.size());
+  }
+
+  // small buffers so the readers wait on many reads
+  AsyncBinaryStream stream("./async_stream.data", 4, 1024);
+  auto driver_config = DriverConfiguration().gutter_sys(STANDALONE).worker_threads(2);
+  CCSketchAlg cc_alg{num_nodes, get_seed()};
+  GraphSketchDriver<CCSketchAlg> driver(&cc_alg, &stream, driver_config, 3);
+
+  GraphVerifier verify(num_nodes);
+  for (auto &upd : updates) verify.edge_update(upd.edge);
+  driver.process_stream_until(END_OF_STREAM);
+  driver.prep_query(CONNECTIVITY);
+  driver.check_verifier(verify);
+  cc_alg.connected_components();
+}
+
+TEST(CCAlgTest, RingBufferStreamMultipleReaders) {
+  node_id_t num_nodes = 1024;
+  std::vector<GraphStreamUpdate> updates;
+  for (node_id_t i = 0; i + 5 < num_nodes; i += 5) {
+    updates.push_back({INSERT, {i, i + 5}});
+    if (i % 15 == 0) updates.push_back({DELETE, {i, i + 5}});
+  }
+
+  // the ring is smaller than the stream, so readers and the producer wait on each other
+  size_t produced = 0;
+  RingBufferStream stream(
+      num_nodes,
+      [&](GraphStreamUpdate *buf, size_t max_updates) {
+        size_t num = std::min(max_updates, updates.size() - produced);
+        std::copy(updates.begin() + produced, updates.begin() + produced + num, buf);
+        produced += num;
+        return num;
+      },
+      64);
+  auto driver_config = DriverConfiguration().gutter_sys(STANDALONE).worker_threads(2);
+  CCSketchAlg cc_alg{num_nodes, get_seed()};
+  GraphSketchDriver<CCSketchAlg> driver(&cc_alg, &stream, driver_config, 3);
+
+  GraphVerifier verify(num_nodes);
+  for (auto &upd : updates) verify.edge_update(upd.edge);
+  driver.process_stream_until(END_OF_STREAM);
+  driver.prep_query(CONNECTIVITY);
+  driver.check_verifier(verify);
+  cc_alg.connected_components();
+}
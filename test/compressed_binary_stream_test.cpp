@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+#include "compressed_binary_stream.h"
+
+static std::vector<GraphStreamUpdate> write_test_stream(const std::string &file_name,
+                                                        node_id_t num_vertices,
+                                                        uint32_t block_updates) {
+  std::vector<GraphStreamUpdate> updates;
+  for (node_id_t i = 0; i < num_vertices; i++) {
+    for (node_id_t j = i + 1; j < num_vertices; j += 3) {
+      // mix both orientations and large ids
+      node_id_t src = i * 1000003;
+      node_id_t dst = j * 1000003;
+      if (j % 2 == 0) std::swap(src, dst);
+      updates.push_back({(uint8_t)((i + j) % 2 == 0 ? INSERT : DELETE), {src, dst}});
+    }
+  }
+  CompressedStreamWriter out(file_name, num_vertices, block_updates);
+  // write in uneven pieces so blocks span several calls
+  for (size_t i = 0; i < updates.size(); i += 777)
+    out.write_updates(updates.data() + i, std::min((size_t)777, updates.size() - i));
+  return updates;
+}
+
+// read the stream until the breakpoint, checking the updates arrive in order
+static size_t read_in_order(CompressedBinaryStream &stream,
+                            const std::vector<GraphStreamUpdate> &updates, size_t first,
+                            size_t buffer_size) {
+  std::vector<GraphStreamUpdate> buf(buffer_size);
+  size_t idx = first;
+  while (true) {
+    size_t got = stream.get_update_buffer(buf.data(), buf.size());
+    if (buf[0].type == BREAKPOINT) break;
+    for (size_t i = 0; i < got; i++, idx++) {
+      EXPECT_EQ(updates[idx].type, buf[i].type);
+      EXPECT_EQ(updates[idx].edge, buf[i].edge);
+    }
+  }
+  return idx - first;
+}
+
+TEST(CompressedBinaryStreamTest, RoundTrip) {
+  for (uint32_t block_updates : {1u, 100u, 4000u}) {
+    std::vector<GraphStreamUpdate> updates =
+        write_test_stream("./compressed_test.data", 200, block_updates);
+    CompressedBinaryStream stream("./compressed_test.data");
+    ASSERT_EQ(200, stream.vertices());
+    ASSERT_EQ(updates.size(), stream.edges());
+    ASSERT_EQ(block_updates, stream.block_size());
+
+    // buffers smaller than, equal to and larger than a block
+    for (size_t buffer_size : {37, 100, 4000}) {
+      stream.seek(0);
+      ASSERT_EQ(updates.size(), read_in_order(stream, updates, 0, buffer_size));
+    }
+  }
+}
+
+TEST(CompressedBinaryStreamTest, BreakpointsAndSeek) {
+  std::vector<GraphStreamUpdate> updates = write_test_stream("./compressed_test.data", 100, 64);
+  CompressedBinaryStream stream("./compressed_test.data");
+
+  ASSERT_TRUE(stream.set_break_point(250));
+  ASSERT_EQ(250, read_in_order(stream, updates, 0, 100));
+  ASSERT_FALSE(stream.set_break_point(100));
+  ASSERT_TRUE(stream.set_break_point(END_OF_STREAM));
+  ASSERT_EQ(updates.size() - 250, read_in_order(stream, updates, 250, 100));
+
+  stream.seek(123);
+  ASSERT_EQ(updates.size() - 123, read_in_order(stream, updates, 123, 100));
+}
+
+TEST(CompressedBinaryStreamTest, ConcurrentReaders) {
+  std::vector<GraphStreamUpdate> updates = write_test_stream("./compressed_test.data", 300, 50);
+  CompressedBinaryStream stream("./compressed_test.data");
+
+  // every update should be read by exactly one thread. Updates are distinct, so sort and compare.
+  std::vector<std::vector<GraphStreamUpdate>> read(4);
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 4; t++) {
+    readers.emplace_back([&, t]() {
+      std::vector<GraphStreamUpdate> buf(120);
+      while (true) {
+        size_t got = stream.get_update_buffer(buf.data(), buf.size());
+        if (buf[0].type == BREAKPOINT) break;
+        read[t].insert(read[t].end(), buf.begin(), buf.begin() + got);
+      }
+    });
+  }
+  for (auto &reader : readers) reader.join();
+
+  auto cmp = [](const GraphStreamUpdate &a, const GraphStreamUpdate &b) {
+    return std::make_pair(a.edge.src, a.edge.dst) < std::make_pair(b.edge.src, b.edge.dst);
+  };
+  std::vector<GraphStreamUpdate> all;
+  for (auto &r : read) all.insert(all.end(), r.begin(), r.end());
+  ASSERT_EQ(updates.size(), all.size());
+  std::sort(all.begin(), all.end(), cmp);
+  std::sort(updates.begin(), updates.end(), cmp);
+  for (size_t i = 0; i < updates.size(); i++) {
+    ASSERT_EQ(updates[i].type, all[i].type);
+    ASSERT_EQ(updates[i].edge, all[i].edge);
+  }
+}
+
+TEST(CompressedBinaryStreamTest, MalformedFile) {
+  write_test_stream("./compressed_test.data", 50, 16);
+  // truncate the block index
+  {
+    std::ifstream in("./compressed_test.data", std::ios::binary);
+    std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::ofstream out("./compressed_test.data", std::ios::binary | std::ios::trunc);
+    out.write(contents.data(), contents.size() - 8);
+  }
+  ASSERT_THROW(CompressedBinaryStream("./compressed_test.data"), StreamException);
+}
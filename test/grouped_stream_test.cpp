@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <vector>
+
+#include "grouped_stream.h"
+
+TEST(GroupedStreamTest, LongRunsAreReturnedInPortions) {
+  std::vector<node_id_t> dsts(1000);
+  for (node_id_t i = 0; i < dsts.size(); i++) dsts[i] = i;
+  {
+    GroupedStreamWriter out("./grouped_test.data", 1000);
+    out.write_run(7, dsts.data(), dsts.size());
+    out.write_run(8, dsts.data(), 0);  // empty runs are not written
+    out.write_run(9, dsts.data(), 3);
+  }
+
+  GroupedStreamReader in("./grouped_test.data");
+  ASSERT_EQ(1000, in.vertices());
+  ASSERT_EQ(1003, in.updates());
+
+  node_id_t src;
+  std::vector<node_id_t> portion;
+  std::vector<node_id_t> run_seven;
+  for (int i = 0; i < 10; i++) {
+    ASSERT_TRUE(in.get_run(src, portion, 100));
+    ASSERT_EQ(7, src);
+    ASSERT_EQ(100, portion.size());
+    run_seven.insert(run_seven.end(), portion.begin(), portion.end());
+  }
+  ASSERT_EQ(dsts, run_seven);
+
+  ASSERT_TRUE(in.get_run(src, portion, 100));
+  ASSERT_EQ(9, src);
+  ASSERT_EQ(std::vector<node_id_t>({0, 1, 2}), portion);
+  ASSERT_FALSE(in.get_run(src, portion, 100));
+}
+
+TEST(GroupedStreamTest, TruncatedFileThrows) {
+  std::vector<node_id_t> dsts = {1, 2, 3};
+  {
+    GroupedStreamWriter out("./grouped_truncated_test.data", 10);
+    out.write_run(0, dsts.data(), dsts.size());
+    out.write_run(4, dsts.data(), dsts.size());
+  }
+  // the header, then each run is its source, its length and its destinations
+  size_t header_bytes = sizeof(node_id_t) + sizeof(edge_id_t);
+  size_t run_bytes = sizeof(node_id_t) + sizeof(uint32_t) + dsts.size() * sizeof(node_id_t);
+
+  // cut partway through the source of the second run, its length, and its destinations
+  for (size_t cut : {size_t(2), sizeof(node_id_t) + 1, run_bytes - 1}) {
+    std::filesystem::copy_file("./grouped_truncated_test.data", "./grouped_truncated_cut.data",
+                               std::filesystem::copy_options::overwrite_existing);
+    std::filesystem::resize_file("./grouped_truncated_cut.data", header_bytes + run_bytes + cut);
+
+    GroupedStreamReader in("./grouped_truncated_cut.data");
+    node_id_t src;
+    std::vector<node_id_t> portion;
+    ASSERT_TRUE(in.get_run(src, portion, 100));
+    ASSERT_EQ(dsts, portion);
+    ASSERT_THROW(in.get_run(src, portion, 100), StreamException);
+  }
+}
@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+#include "in_memory_stream.h"
+
+static std::vector<GraphStreamUpdate> make_updates(size_t num_updates) {
+  std::vector<GraphStreamUpdate> updates(num_updates);
+  for (size_t i = 0; i < num_updates; i++)
+    updates[i] = {(uint8_t)(i % 3 == 0 ? DELETE : INSERT), {(node_id_t)i, (node_id_t)(i + 1)}};
+  return updates;
+}
+
+// Read the stream with several threads until the breakpoint. Returns how often each update,
+// identified by its source vertex, was read.
+static std::vector<size_t> read_concurrently(GraphStream &stream, size_t num_updates,
+                                             size_t num_threads, size_t buffer_size) {
+  std::vector<std::vector<size_t>> counts(num_threads, std::vector<size_t>(num_updates));
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t]() {
+      std::vector<GraphStreamUpdate> buf(buffer_size);
+      while (true) {
+        size_t got = stream.get_update_buffer(buf.data(), buf.size());
+        if (buf[0].type == BREAKPOINT) break;
+        for (size_t i = 0; i < got; i++) {
+          ASSERT_EQ(buf[i].edge.src + 1, buf[i].edge.dst);
+          ASSERT_EQ(buf[i].edge.src % 3 == 0 ? DELETE : INSERT, buf[i].type);
+          counts[t][buf[i].edge.src]++;
+        }
+      }
+    });
+  }
+  for (auto &thr : threads) thr.join();
+  std::vector<size_t> total(num_updates);
+  for (auto &thr_counts : counts)
+    for (size_t i = 0; i < num_updates; i++) total[i] += thr_counts[i];
+  return total;
+}
+
+TEST(InMemoryStreamTest, ReadsInOrder) {
+  std::vector<GraphStreamUpdate> updates = make_updates(10000);
+  InMemoryStream stream(20000, updates.data(), updates.size());
+  ASSERT_EQ(20000, stream.vertices());
+  ASSERT_EQ(10000, stream.edges());
+
+  ASSERT_TRUE(stream.set_break_point(2500));
+  std::vector<GraphStreamUpdate> buf(777);
+  edge_id_t read = 0;
+  while (true) {
+    size_t got = stream.get_update_buffer(buf.data(), buf.size());
+    if (buf[0].type == BREAKPOINT) break;
+    for (size_t i = 0; i < got; i++, read++) ASSERT_EQ(updates[read].edge, buf[i].edge);
+  }
+  ASSERT_EQ(2500, read);
+
+  // the rest of the stream, read in place
+  ASSERT_TRUE(stream.set_break_point(END_OF_STREAM));
+  const GraphStreamUpdate *view;
+  size_t got;
+  while ((got = stream.get_update_view(view, 1000)) > 0) {
+    ASSERT_EQ(updates.data() + read, view);
+    read += got;
+  }
+  ASSERT_EQ(10000, read);
+  ASSERT_FALSE(stream.set_break_point(100));
+}
+
+TEST(InMemoryStreamTest, OwnedMultipleReaders) {
+  InMemoryStream stream(200001, make_updates(200000));
+  std::vector<size_t> counts = read_concurrently(stream, 200000, 4, 1000);
+  for (size_t count : counts) ASSERT_EQ(1, count);
+}
+
+TEST(InMemoryStreamTest, RingProducerCallback) {
+  size_t num_updates = 300000;
+  std::vector<GraphStreamUpdate> updates = make_updates(num_updates);
+  size_t produced = 0;
+  // a ring much smaller than the stream, so it wraps and the producer waits for readers
+  RingBufferStream stream(
+      num_updates + 1,
+      [&](GraphStreamUpdate *buf, size_t max_updates) {
+        size_t num = std::min({max_updates, num_updates - produced, (size_t)333});
+        std::copy(updates.begin() + produced, updates.begin() + produced + num, buf);
+        produced += num;
+        return num;
+      },
+      1000);
+  std::vector<size_t> counts = read_concurrently(stream, num_updates, 4, 100);
+  for (size_t count : counts) ASSERT_EQ(1, count);
+  ASSERT_EQ(num_updates, stream.edges());
+}
+
+TEST(InMemoryStreamTest, RingPushAndBreakpoints) {
+  size_t num_updates = 100000;
+  std::vector<GraphStreamUpdate> updates = make_updates(num_updates);
+  RingBufferStream stream(num_updates + 1, 4096);
+  ASSERT_EQ(0, stream.edges());
+  std::thread producer([&]() {
+    for (size_t i = 0; i < num_updates; i += 1000) stream.push(updates.data() + i, 1000);
+    stream.close();
+  });
+
+  // readers stop at the breakpoint, then carry on from it
+  ASSERT_TRUE(stream.set_break_point(40000));
+  std::vector<size_t> first = read_concurrently(stream, num_updates, 3, 64);
+  ASSERT_NO_THROW(stream.seek(40000));
+  ASSERT_THROW(stream.seek(0), StreamException);
+  ASSERT_FALSE(stream.set_break_point(20000));
+  ASSERT_TRUE(stream.set_break_point(END_OF_STREAM));
+  std::vector<size_t> second = read_concurrently(stream, num_updates, 3, 64);
+  producer.join();
+  ASSERT_EQ(num_updates, stream.edges());
+
+  for (size_t i = 0; i < num_updates; i++) {
+    ASSERT_EQ(i < 40000, first[i] == 1);
+    ASSERT_EQ(1, first[i] + second[i]);
+  }
+}
+
+TEST(InMemoryStreamTest, RingDestroyedWhileProducing) {
+  // the producer never finishes and nobody reads, so it is blocked on a full ring
+  RingBufferStream stream(
+      10,
+      [](GraphStreamUpdate *buf, size_t max_updates) {
+        for (size_t i = 0; i < max_updates; i++) buf[i] = {INSERT, {0, 1}};
+        return max_updates;
+      },
+      16);
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+}
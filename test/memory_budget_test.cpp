@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+
+#include "autotuner.h"
+#include "ingested_graph.h"
+#include "memory_budget.h"
+
+TEST(MemoryBudgetTest, Estimate) {
+  node_id_t num_vertices = 1 << 16;
+  MemoryBudget budget(num_vertices, 0, 2);
+  size_t batch_bytes = MemoryBudget::batch_bytes(num_vertices, 1);
+  MemoryEstimate standalone = budget.estimate(STANDALONE, 4, batch_bytes);
+  MemoryEstimate cachetree = budget.estimate(CACHETREE, 4, batch_bytes);
+  MemoryEstimate guttertree = budget.estimate(GUTTERTREE, 4, batch_bytes);
+
+  // only the gutters depend on the guttering system
+  ASSERT_EQ(standalone.sketch_bytes, guttertree.sketch_bytes);
+  ASSERT_EQ(standalone.vertex_bytes, guttertree.vertex_bytes);
+  ASSERT_GE(standalone.gutter_bytes, num_vertices * batch_bytes);
+  ASSERT_LT(standalone.gutter_bytes, cachetree.gutter_bytes);
+  ASSERT_LT(guttertree.gutter_bytes, standalone.gutter_bytes);
+  ASSERT_GE(standalone.sketch_bytes, num_vertices * batch_bytes);
+  ASSERT_EQ(standalone.sketch_bytes + standalone.delta_sketch_bytes + standalone.gutter_bytes +
+                standalone.vertex_bytes + standalone.query_bytes,
+            standalone.total());
+
+  // each worker has a delta sketch
+  ASSERT_LT(budget.estimate(STANDALONE, 1, batch_bytes).delta_sketch_bytes,
+            standalone.delta_sketch_bytes);
+
+  // the leaf gutters hold the batch the algorithm requests
+  CCSketchAlg cc_alg{1024, 1, CCAlgConfiguration().batch_factor(0.5)};
+  ASSERT_EQ(cc_alg.get_desired_updates_per_batch() * sizeof(node_id_t),
+            MemoryBudget::batch_bytes(1024, 0.5));
+}
+
+TEST(MemoryBudgetTest, PlanPicksFastestThatFits) {
+  node_id_t num_vertices = 1 << 16;
+  MemoryBudget unlimited(num_vertices, size_t(1) << 40);
+  auto driver_config = DriverConfiguration().worker_threads(4).disk_dir("./");
+  auto alg_config = CCAlgConfiguration();
+  unlimited.plan(driver_config, alg_config);
+  ASSERT_EQ(CACHETREE, driver_config.get_gutter_sys());
+  ASSERT_EQ(4, driver_config.get_worker_threads());
+  ASSERT_EQ(2, alg_config.get_batch_factor());
+  ASSERT_EQ(MemoryBudget::batch_bytes(num_vertices, 2),
+            driver_config.gutter_conf().get_gutter_bytes());
+  ASSERT_EQ("./", driver_config.get_disk_dir());
+
+  // too little memory for in-memory gutters moves them to disk
+  MemoryBudget sizer(num_vertices, 0);
+  size_t small_batch = MemoryBudget::batch_bytes(num_vertices, 0.25);
+  size_t on_disk_budget = sizer.estimate(GUTTERTREE, 4, MemoryBudget::batch_bytes(num_vertices, 1))
+                              .total();
+  ASSERT_LT(on_disk_budget, sizer.estimate(STANDALONE, 1, small_batch).total());
+  MemoryBudget tight(num_vertices, on_disk_budget);
+  MemoryEstimate est = tight.plan(driver_config, alg_config);
+  ASSERT_EQ(GUTTERTREE, driver_config.get_gutter_sys());
+  ASSERT_EQ(4, driver_config.get_worker_threads());
+  ASSERT_EQ(1, alg_config.get_batch_factor());
+  ASSERT_LE(est.total(), on_disk_budget);
+
+  // less than the sketches need
+  MemoryBudget too_small(num_vertices, est.sketch_bytes);
+  ASSERT_THROW(too_small.plan(driver_config, alg_config), std::runtime_error);
+}
+
+TEST(MemoryBudgetTest, PlannedConfigurationIngests) {
+  node_id_t num_vertices = 1024;
+  auto gen_config = StreamGeneratorConfiguration().num_vertices(num_vertices).num_edges(20000);
+  IngestedGraph graph(gen_config);
+
+  MemoryBudget sizer(num_vertices, 0);
+  size_t budget_bytes =
+      sizer.estimate(STANDALONE, 2, MemoryBudget::batch_bytes(num_vertices, 1)).total();
+  auto driver_config = DriverConfiguration().worker_threads(2);
+  auto alg_config = CCAlgConfiguration();
+  MemoryBudget(num_vertices, budget_bytes).plan(driver_config, alg_config);
+  ASSERT_EQ(STANDALONE, driver_config.get_gutter_sys());
+  ASSERT_EQ(1, alg_config.get_batch_factor());
+
+  graph.build(5, alg_config, driver_config);
+  graph.ingest();
+  ASSERT_EQ(graph.stream.edges(), graph.driver->get_stats().ingested_updates);
+
+  // the autotuner only measures candidates within the budget
+  auto tune_config = AutotuneConfiguration()
+                         .total_threads(3)
+                         .calibration_updates(5000)
+                         .batch_factors({1, 2})
+                         .gutter_scales({1})
+                         .memory_budget(budget_bytes);
+  AutotuneResult result = Autotuner(tune_config).tune_synthetic(num_vertices);
+  ASSERT_EQ(STANDALONE, result.driver_config.get_gutter_sys());
+  ASSERT_EQ(1, result.trials.size());
+  ASSERT_EQ(2, result.best.worker_threads);
+  ASSERT_EQ(1, result.best.batch_factor);
+}
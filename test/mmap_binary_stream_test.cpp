@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+
+#include <binary_file_stream.h>
+
+#include <vector>
+
+#include "mmap_binary_stream.h"
+
+static std::vector<GraphStreamUpdate> write_test_stream(const std::string &file_name,
+                                                        node_id_t num_vertices) {
+  std::vector<GraphStreamUpdate> updates;
+  for (node_id_t i = 0; i < num_vertices; i++) {
+    for (node_id_t j = i + 1; j < num_vertices; j += 3) {
+      updates.push_back({(uint8_t)((i + j) % 2 == 0 ? INSERT : DELETE), {i, j}});
+    }
+  }
+  BinaryFileStream out(file_name, false);
+  out.write_header(num_vertices, updates.size());
+  out.write_updates(updates.data(), updates.size());
+  return updates;
+}
+
+TEST(MMapBinaryStreamTest, ViewsMatchFileContents) {
+  std::vector<GraphStreamUpdate> updates = write_test_stream("./mmap_test.data", 200);
+  MMapBinaryStream stream("./mmap_test.data");
+  ASSERT_EQ(200, stream.vertices());
+  ASSERT_EQ(updates.size(), stream.edges());
+
+  size_t idx = 0;
+  const GraphStreamUpdate *view;
+  while (size_t claimed = stream.get_update_view(view, 777)) {
+    for (size_t i = 0; i < claimed; i++, idx++) {
+      ASSERT_EQ(updates[idx].type, view[i].type);
+      ASSERT_EQ(updates[idx].edge, view[i].edge);
+    }
+  }
+  ASSERT_EQ(updates.size(), idx);
+}
+
+TEST(MMapBinaryStreamTest, BreakpointsAndCopies) {
+  std::vector<GraphStreamUpdate> updates = write_test_stream("./mmap_test.data", 100);
+  MMapBinaryStream stream("./mmap_test.data");
+  std::vector<GraphStreamUpdate> buf(64);
+
+  ASSERT_TRUE(stream.set_break_point(100));
+  size_t read = 0;
+  while (true) {
+    size_t got = stream.get_update_buffer(buf.data(), buf.size());
+    if (buf[0].type == BREAKPOINT) break;
+    for (size_t i = 0; i < got; i++) ASSERT_EQ(updates[read + i].edge, buf[i].edge);
+    read += got;
+  }
+  ASSERT_EQ(100, read);
+
+  ASSERT_FALSE(stream.set_break_point(50));
+  ASSERT_TRUE(stream.set_break_point(END_OF_STREAM));
+  const GraphStreamUpdate *view;
+  ASSERT_EQ(64, stream.get_update_view(view, 64));
+  ASSERT_EQ(updates[100].edge, view[0].edge);
+}
@@ -0,0 +1,49 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+#include "numa_topology.h"
+
+TEST(NumaTopologyTest, PartitionsCoverVerticesInOrder) {
+  for (uint64_t num_vertices : {1, 7, 1000, 1 << 20}) {
+    for (size_t num_parts : {1, 2, 3, 4, 7}) {
+      ASSERT_EQ(0, NumaTopology::partition_begin(0, num_vertices, num_parts));
+      ASSERT_EQ(num_vertices, NumaTopology::partition_begin(num_parts, num_vertices, num_parts));
+      for (size_t p = 0; p < num_parts; p++) {
+        uint64_t first = NumaTopology::partition_begin(p, num_vertices, num_parts);
+        uint64_t last = NumaTopology::partition_begin(p + 1, num_vertices, num_parts);
+        ASSERT_LE(last - first, num_vertices / num_parts + 1);
+        for (uint64_t v = first; v < last; v++)
+          ASSERT_EQ(p, NumaTopology::vertex_partition(v, num_vertices, num_parts))
+              << "vertex " << v << " of " << num_vertices << " with " << num_parts << " parts";
+      }
+    }
+  }
+}
+
+TEST(NumaTopologyTest, ThreadsSpreadAcrossNodes) {
+  NumaTopology topology;
+  ASSERT_GE(topology.num_nodes(), 1);
+  for (size_t t = 0; t < 4 * topology.num_nodes(); t++) {
+    size_t node = topology.node_for_thread(t);
+    ASSERT_EQ(t % topology.num_nodes(), node);
+    const std::vector<int> &cpus = topology.get_node_cpus(node);
+    ASSERT_NE(cpus.end(), std::find(cpus.begin(), cpus.end(), topology.cpu_for_thread(t)));
+  }
+}
+
+TEST(NumaTopologyTest, PlaceAllocatedPages) {
+  NumaTopology topology;
+  size_t bytes = 16 * NumaTopology::page_size() + 5;
+  char *mem = (char *)NumaTopology::allocate_pages(bytes);
+  ASSERT_EQ(0, (uintptr_t)mem % NumaTopology::page_size());
+  for (size_t i = 0; i < bytes; i++) ASSERT_EQ(0, mem[i]);
+  // placement may be refused (for example by a container's seccomp policy) but must never
+  // affect the contents of the memory
+  mem[0] = 1;
+  topology.interleave_memory(mem, bytes);
+  NumaTopology::bind_memory(mem + 3, bytes / 2, topology.get_node_id(0));
+  mem[bytes - 1] = 1;
+  ASSERT_EQ(1, mem[0]);
+  NumaTopology::free_pages(mem, bytes);
+}
@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+#include "ingested_graph.h"
+#include "perf_counters.h"
+
+// Ingest and query a small random graph
+static void ingest_and_query(bool in_place) {
+  auto gen_config = StreamGeneratorConfiguration()
+                        .num_vertices(1024)
+                        .num_edges(20000)
+                        .delete_fraction(0.5)
+                        .seed(5);
+  IngestedGraph graph(gen_config);
+  auto cc_config = CCAlgConfiguration().merge_mode(in_place ? IN_PLACE_MERGE : REMERGE_CHILDREN);
+  auto driver_config = DriverConfiguration().gutter_sys(STANDALONE).worker_threads(2);
+  graph.build(11, cc_config, driver_config, 2);
+  graph.ingest();
+  graph.cc_alg->connected_components();
+}
+
+TEST(PerfCountersTest, DisabledRecordsNothing) {
+  PerfProfiler::enable(false);
+  PerfProfiler::reset();
+  ingest_and_query(false);
+  for (size_t p = 0; p < NUM_PERF_PHASES; p++)
+    ASSERT_EQ(0, PerfProfiler::get_totals((PerfPhase)p).calls) << perf_phase_name((PerfPhase)p);
+}
+
+TEST(PerfCountersTest, AttributesPhases) {
+  for (bool in_place : {false, true}) {
+    PerfProfiler::reset();
+    PerfProfiler::enable();
+    ingest_and_query(in_place);
+    PerfProfiler::enable(false);
+
+    for (PerfPhase phase : {PERF_STREAM_READ, PERF_GUTTER_INSERT, PERF_APPLY_UPDATE_BATCH,
+                            PERF_DELTA_MERGE, PERF_BORUVKA_ROUND}) {
+      PerfPhaseTotals totals = PerfProfiler::get_totals(phase);
+      ASSERT_GT(totals.calls, 0) << perf_phase_name(phase);
+      ASSERT_GT(totals.thread_seconds, 0) << perf_phase_name(phase);
+      if (PerfProfiler::event_available(PERF_INSTRUCTIONS)) {
+        ASSERT_GT(totals.events[PERF_INSTRUCTIONS], 0) << perf_phase_name(phase);
+      }
+    }
+    // every batch merges its delta sketch, and the merge is part of applying the batch
+    PerfPhaseTotals apply = PerfProfiler::get_totals(PERF_APPLY_UPDATE_BATCH);
+    PerfPhaseTotals merge = PerfProfiler::get_totals(PERF_DELTA_MERGE);
+    ASSERT_EQ(apply.calls, merge.calls);
+    ASSERT_LE(merge.thread_seconds, apply.thread_seconds);
+  }
+
+  std::stringstream json;
+  PerfProfiler::write_json(json);
+  std::string out = json.str();
+  ASSERT_EQ('{', out.front());
+  ASSERT_NE(std::string::npos, out.find("\"phase\": \"stream_read\""));
+  ASSERT_NE(std::string::npos, out.find("\"phase\": \"boruvka_round\", \"round\": 0"));
+  ASSERT_NE(std::string::npos, out.find("\"cycles\": "));
+}
@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include "ingested_graph.h"
+#include "runtime_stats.h"
+
+static std::string read_file(const std::string &filename) {
+  std::ifstream in(filename);
+  std::stringstream contents;
+  contents << in.rdbuf();
+  return contents.str();
+}
+
+TEST(RuntimeStatsTest, HistogramBuckets) {
+  ASSERT_EQ(0, RuntimeStats::histogram_bucket(0));
+  ASSERT_EQ(0, RuntimeStats::histogram_bucket(1));
+  ASSERT_EQ(1, RuntimeStats::histogram_bucket(2));
+  ASSERT_EQ(1, RuntimeStats::histogram_bucket(3));
+  ASSERT_EQ(10, RuntimeStats::histogram_bucket(1024));
+  ASSERT_EQ(RuntimeStats::histogram_buckets - 1, RuntimeStats::histogram_bucket(1ull << 40));
+}
+
+TEST(RuntimeStatsTest, StripedCountersConcurrent) {
+  StripedCounters<2> counters;
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < 8; t++) {
+    threads.emplace_back([&, t]() {
+      for (size_t i = 0; i < 10000; i++) counters.increment(t % 2);
+    });
+  }
+  for (auto &thr : threads) thr.join();
+  ASSERT_EQ(40000, counters.get(0));
+  ASSERT_EQ(40000, counters.get(1));
+  counters.reset();
+  ASSERT_EQ(0, counters.get(0));
+}
+
+TEST(RuntimeStatsTest, DriverAndQueryStats) {
+  node_id_t num_vertices = 2048;
+  auto gen_config = StreamGeneratorConfiguration()
+                        .num_vertices(num_vertices)
+                        .num_edges(30000)
+                        .churn(0.2)
+                        .delete_fraction(0.3)
+                        .seed(9);
+  IngestedGraph graph(gen_config);
+  auto driver_config = DriverConfiguration().gutter_sys(STANDALONE).worker_threads(3);
+  graph.build(4, CCAlgConfiguration(), driver_config, 2);
+  CCSketchAlg &cc_alg = *graph.cc_alg;
+
+  RuntimeStats before = graph.driver->get_stats();
+  ASSERT_EQ(0, before.ingested_updates);
+  ASSERT_EQ(3, before.workers.size());
+  ASSERT_EQ(0, before.query.queries);
+
+  graph.ingest();
+  cc_alg.connected_components();
+
+  RuntimeStats stats = graph.driver->get_stats();
+  ASSERT_EQ(graph.stream.edges(), stats.ingested_updates);
+  ASSERT_EQ(2 * stats.ingested_updates, stats.applied_updates);
+  ASSERT_EQ(0, stats.buffered_updates);
+  uint64_t batches = 0;
+  uint64_t updates = 0;
+  for (const WorkerStats &worker : stats.workers) {
+    batches += worker.batches;
+    updates += worker.updates;
+  }
+  ASSERT_EQ(stats.applied_updates, updates);
+  uint64_t histogram_batches = 0;
+  for (uint64_t count : stats.batch_size_histogram) histogram_batches += count;
+  ASSERT_EQ(batches, histogram_batches);
+  ASSERT_EQ(1, stats.flushes);
+  ASSERT_GE(stats.total_flush_seconds, stats.last_flush_seconds);
+  ASSERT_GE(stats.uptime_seconds, stats.total_flush_seconds);
+
+  // every vertex is sampled in the first round
+  ASSERT_EQ(1, stats.query.queries);
+  ASSERT_EQ(cc_alg.last_query_rounds + 1, stats.query.last_query_rounds);
+  ASSERT_EQ(cc_alg.last_query_round_times.size(), stats.query.last_query_round_stats.size());
+  const QueryRoundStats &first = stats.query.last_query_round_stats[0];
+  ASSERT_EQ(num_vertices, first.good_samples + first.zero_samples + first.fail_samples);
+  ASSERT_GT(first.good_samples, 0);
+
+  stats.export_json("./runtime_stats_test.json");
+  std::string json = read_file("./runtime_stats_test.json");
+  ASSERT_NE(std::string::npos,
+            json.find("\"ingested_updates\": " + std::to_string(stats.ingested_updates)));
+  ASSERT_NE(std::string::npos, json.find("\"good_samples\": " + std::to_string(first.good_samples)));
+
+  stats.export_prometheus("./runtime_stats_test.prom");
+  std::string prom = read_file("./runtime_stats_test.prom");
+  ASSERT_NE(std::string::npos, prom.find("# TYPE graphzeppelin_applied_updates_total counter"));
+  ASSERT_NE(std::string::npos,
+            prom.find("graphzeppelin_applied_updates_total " +
+                      std::to_string(stats.applied_updates) + "\n"));
+  ASSERT_NE(std::string::npos,
+            prom.find("graphzeppelin_batch_size_count " + std::to_string(batches) + "\n"));
+  ASSERT_NE(std::string::npos, prom.find("graphzeppelin_worker_batches_total{worker=\"2\"}"));
+  ASSERT_FALSE(std::ifstream("./runtime_stats_test.prom.tmp").is_open());
+}
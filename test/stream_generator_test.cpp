@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+
+#include <binary_file_stream.h>
+
+#include <stdexcept>
+#include <unordered_set>
+#include <vector>
+
+#include "stream_generator.h"
+
+static uint64_t edge_key(Edge edge) {
+  return ((uint64_t)std::min(edge.src, edge.dst) << 32) | std::max(edge.src, edge.dst);
+}
+
+// Replay the stream, checking that it never inserts a present edge or deletes an absent one.
+// Returns the edges present at the end.
+static std::unordered_set<uint64_t> replay(const std::vector<GraphStreamUpdate> &updates,
+                                           node_id_t num_vertices) {
+  std::unordered_set<uint64_t> present;
+  for (auto &upd : updates) {
+    EXPECT_NE(upd.edge.src, upd.edge.dst);
+    EXPECT_LT(upd.edge.src, num_vertices);
+    EXPECT_LT(upd.edge.dst, num_vertices);
+    if (upd.type == INSERT) {
+      EXPECT_TRUE(present.insert(edge_key(upd.edge)).second);
+    } else {
+      EXPECT_EQ(DELETE, upd.type);
+      EXPECT_EQ(1, present.erase(edge_key(upd.edge)));
+    }
+  }
+  return present;
+}
+
+TEST(StreamGeneratorTest, ValidStreams) {
+  for (GraphModel model : {ERDOS_RENYI, RMAT, POWER_LAW}) {
+    for (node_id_t num_vertices : {2, 100, 1000}) {
+      auto config = StreamGeneratorConfiguration()
+                        .model(model)
+                        .num_vertices(num_vertices)
+                        .num_edges(20000)
+                        .churn(0.3)
+                        .delete_fraction(0.2)
+                        .seed(3);
+      StreamGenerator generator(config);
+      std::vector<GraphStreamUpdate> updates = generator.get_updates();
+      ASSERT_EQ(generator.updates(), updates.size());
+
+      std::unordered_set<uint64_t> present = replay(updates, num_vertices);
+      ASSERT_EQ(generator.final_edges(), present.size());
+      ASSERT_LE(generator.edges(), (edge_id_t)num_vertices * (num_vertices - 1) / 2);
+      if (num_vertices == 2) {
+        ASSERT_EQ(1, generator.edges());
+      } else {
+        // roughly the requested fractions of churned and deleted edges
+        edge_id_t extra = generator.updates() - generator.edges();
+        ASSERT_NEAR(0.3 * 2 + 0.2, (double)extra / generator.edges(), 0.1);
+      }
+    }
+  }
+}
+
+TEST(StreamGeneratorTest, Deterministic) {
+  auto config = StreamGeneratorConfiguration()
+                    .model(RMAT)
+                    .num_vertices(1 << 12)
+                    .num_edges(100000)
+                    .churn(0.1)
+                    .seed(7);
+  std::vector<GraphStreamUpdate> first = StreamGenerator(config).get_updates();
+  std::vector<GraphStreamUpdate> second = StreamGenerator(config).get_updates();
+  ASSERT_EQ(first.size(), second.size());
+  for (size_t i = 0; i < first.size(); i++) {
+    ASSERT_EQ(first[i].type, second[i].type);
+    ASSERT_EQ(first[i].edge, second[i].edge);
+  }
+
+  // a different seed gives a different stream
+  std::vector<GraphStreamUpdate> other = StreamGenerator(config.seed(8)).get_updates();
+  size_t same = 0;
+  for (size_t i = 0; i < std::min(first.size(), other.size()); i++)
+    same += first[i].edge == other[i].edge;
+  ASSERT_LT(same, first.size() / 100);
+}
+
+TEST(StreamGeneratorTest, SkewedDegrees) {
+  node_id_t num_vertices = 10000;
+  for (GraphModel model : {ERDOS_RENYI, RMAT, POWER_LAW}) {
+    auto config = StreamGeneratorConfiguration()
+                      .model(model)
+                      .num_vertices(num_vertices)
+                      .num_edges(200000);
+    StreamGenerator generator(config);
+    std::vector<size_t> degree(num_vertices);
+    for (auto &upd : generator.get_updates()) {
+      degree[upd.edge.src]++;
+      degree[upd.edge.dst]++;
+    }
+    size_t max_degree = *std::max_element(degree.begin(), degree.end());
+    double avg_degree = 2.0 * generator.edges() / num_vertices;
+    if (model == ERDOS_RENYI)
+      ASSERT_LT(max_degree, 2 * avg_degree);
+    else
+      ASSERT_GT(max_degree, 10 * avg_degree);
+  }
+}
+
+TEST(StreamGeneratorTest, DegenerateModels) {
+  // only self loops, so the probabilities fall back to the defaults
+  auto diagonal = StreamGeneratorConfiguration().model(RMAT).rmat_probabilities(1, 0, 0);
+  StreamGenerator generator(diagonal);
+  ASSERT_GT(generator.edges(), 0);
+  replay(generator.get_updates(), generator.vertices());
+
+  // every sample is the top-right corner of the matrix, beyond the last of 3 vertices
+  auto out_of_range = StreamGeneratorConfiguration()
+                          .model(RMAT)
+                          .rmat_probabilities(0, 1, 0)
+                          .num_vertices(3)
+                          .num_edges(10);
+  ASSERT_THROW(StreamGenerator{out_of_range}, std::runtime_error);
+}
+
+TEST(StreamGeneratorTest, WriteBinaryStream) {
+  auto config = StreamGeneratorConfiguration()
+                    .model(POWER_LAW)
+                    .num_vertices(5000)
+                    .num_edges(300000)
+                    .churn(0.5)
+                    .delete_fraction(0.5);
+  StreamGenerator generator(config);
+  generator.write_binary_stream("./generator_test.data");
+  std::vector<GraphStreamUpdate> expected = generator.get_updates();
+
+  BinaryFileStream stream("./generator_test.data");
+  ASSERT_EQ(5000, stream.vertices());
+  ASSERT_EQ(expected.size(), stream.edges());
+  std::vector<GraphStreamUpdate> buf(4000);
+  size_t read = 0;
+  while (true) {
+    size_t got = stream.get_update_buffer(buf.data(), buf.size());
+    if (buf[0].type == BREAKPOINT) break;
+    for (size_t i = 0; i < got; i++, read++) {
+      ASSERT_EQ(expected[read].type, buf[i].type);
+      ASSERT_EQ(expected[read].edge, buf[i].edge);
+    }
+  }
+  ASSERT_EQ(expected.size(), read);
+}
@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <vector>
+
+#include "task_pool.h"
+
+TEST(TaskPoolTest, ParallelForVisitsEachIndexOnce) {
+  OmpTaskPool pool;
+  constexpr uint32_t num_idx = 100000;
+  std::vector<std::atomic<uint32_t>> visits(num_idx);
+  for (auto &v : visits) v = 0;
+
+  // make the front of the range far more expensive so the threads have to steal work
+  parallel_for(pool, 0, num_idx, [&](uint32_t i) {
+    volatile size_t spin = 0;
+    if (i < num_idx / 8)
+      while (spin < 1000) spin = spin + 1;
+    ++visits[i];
+  }, 16);
+
+  for (uint32_t i = 0; i < num_idx; i++) ASSERT_EQ(visits[i], 1) << "index " << i;
+}
+
+TEST(TaskPoolTest, ParallelForEmptyAndOffsetRanges) {
+  OmpTaskPool pool;
+  std::atomic<size_t> count(0);
+  parallel_for(pool, 10, 10, [&](uint32_t) { ++count; });
+  ASSERT_EQ(count, 0);
+
+  std::atomic<uint64_t> sum(0);
+  parallel_for(pool, 1000, 1010, [&](uint32_t i) { sum += i; });
+  ASSERT_EQ(sum, 10045);
+}
+
+TEST(TaskPoolTest, BarrierSeparatesPhases) {
+  OmpTaskPool pool;
+  size_t max_threads = pool.get_num_threads();
+  std::vector<size_t> phase_one(max_threads, 0);
+  std::atomic<bool> saw_incomplete(false);
+
+  pool.run([&](size_t thr_id, size_t num_threads) {
+    phase_one[thr_id] = thr_id + 1;
+    pool.barrier();
+    for (size_t t = 0; t < num_threads; t++)
+      if (phase_one[t] != t + 1) saw_incomplete = true;
+  });
+  ASSERT_FALSE(saw_incomplete);
+}
+
+TEST(TaskPoolTest, OmpThreadLimit) {
+  OmpTaskPool pool(2);
+  ASSERT_EQ(2, pool.get_num_threads());
+  std::atomic<size_t> runs(0);
+  std::atomic<size_t> max_reported(0);
+  pool.run([&](size_t thr_id, size_t num_threads) {
+    ASSERT_LT(thr_id, num_threads);
+    ++runs;
+    max_reported = num_threads;
+  });
+  ASSERT_LE(runs, 2);
+  ASSERT_EQ(runs, max_reported);
+}
@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#include "text_edge_list_stream.h"
+
+// read the stream until the breakpoint
+static std::vector<GraphStreamUpdate> read_all(TextEdgeListStream &stream, size_t buffer_size) {
+  std::vector<GraphStreamUpdate> buf(buffer_size);
+  std::vector<GraphStreamUpdate> updates;
+  while (true) {
+    size_t got = stream.get_update_buffer(buf.data(), buf.size());
+    if (buf[0].type == BREAKPOINT) break;
+    updates.insert(updates.end(), buf.begin(), buf.begin() + got);
+  }
+  return updates;
+}
+
+static std::vector<Edge> write_edge_list(const std::string &file_name, node_id_t num_vertices) {
+  std::vector<Edge> edges;
+  std::ofstream out(file_name);
+  out << "# a comment\n% another comment\n\n";
+  for (node_id_t i = 0; i < num_vertices; i++) {
+    for (node_id_t j = i + 1; j < num_vertices; j += 3) {
+      edges.push_back({i, j});
+      // vary the separators and add a weight column to some lines
+      if (j % 3 == 0) out << i << "\t" << j << "\n";
+      else if (j % 3 == 1) out << i << ", " << j << ",0.5\r\n";
+      else out << "  " << i << " " << j << " 7\n";
+    }
+  }
+  out << (num_vertices - 2) << " " << (num_vertices - 1);  // no trailing newline
+  edges.push_back({num_vertices - 2, num_vertices - 1});
+  return edges;
+}
+
+TEST(TextEdgeListStreamTest, ParsesEdgeList) {
+  std::vector<Edge> edges = write_edge_list("./text_test.txt", 150);
+  // small chunks so the file is split many times
+  for (size_t chunk_bytes : {1, 100, 32 * 1024}) {
+    TextEdgeListStream stream("./text_test.txt", 0, false, chunk_bytes);
+    ASSERT_EQ(150, stream.vertices());
+    ASSERT_EQ(edges.size(), stream.edges());
+    for (size_t buffer_size : {7, 4000}) {
+      stream.seek(0);
+      std::vector<GraphStreamUpdate> updates = read_all(stream, buffer_size);
+      ASSERT_EQ(edges.size(), updates.size());
+      for (size_t i = 0; i < edges.size(); i++) {
+        ASSERT_EQ(INSERT, updates[i].type);
+        ASSERT_EQ(edges[i], updates[i].edge);
+      }
+    }
+  }
+}
+
+TEST(TextEdgeListStreamTest, TypesAndBreakpoints) {
+  {
+    std::ofstream out("./text_test.txt");
+    for (node_id_t i = 0; i < 1000; i++) out << i % 2 << " " << i << " " << i + 1 << "\n";
+  }
+  TextEdgeListStream stream("./text_test.txt", 2000, true, 256);
+  ASSERT_EQ(2000, stream.vertices());
+  ASSERT_EQ(1000, stream.edges());
+
+  ASSERT_TRUE(stream.set_break_point(333));
+  std::vector<GraphStreamUpdate> updates = read_all(stream, 100);
+  ASSERT_EQ(333, updates.size());
+  ASSERT_FALSE(stream.set_break_point(10));
+  ASSERT_TRUE(stream.set_break_point(END_OF_STREAM));
+  std::vector<GraphStreamUpdate> rest = read_all(stream, 100);
+  updates.insert(updates.end(), rest.begin(), rest.end());
+  ASSERT_EQ(1000, updates.size());
+  for (node_id_t i = 0; i < 1000; i++) {
+    ASSERT_EQ(i % 2 == 0 ? INSERT : DELETE, updates[i].type);
+    ASSERT_EQ(Edge({i, i + 1}), updates[i].edge);
+  }
+}
+
+TEST(TextEdgeListStreamTest, ConcurrentReaders) {
+  std::vector<Edge> edges = write_edge_list("./text_test.txt", 300);
+  TextEdgeListStream stream("./text_test.txt", 300, false, 512);
+
+  std::vector<std::vector<GraphStreamUpdate>> read(4);
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 4; t++)
+    readers.emplace_back([&, t]() { read[t] = read_all(stream, 64); });
+  for (auto &reader : readers) reader.join();
+
+  // every edge should be read by exactly one thread
+  auto cmp = [](const Edge &a, const Edge &b) {
+    return std::make_pair(a.src, a.dst) < std::make_pair(b.src, b.dst);
+  };
+  std::vector<Edge> all;
+  for (auto &r : read)
+    for (auto &upd : r) all.push_back(upd.edge);
+  std::sort(all.begin(), all.end(), cmp);
+  std::sort(edges.begin(), edges.end(), cmp);
+  ASSERT_EQ(edges, all);
+}
+
+TEST(TextEdgeListStreamTest, MalformedLines) {
+  {
+    std::ofstream out("./text_test.txt");
+    out << "0 1\n2 three\n";
+  }
+  ASSERT_THROW(TextEdgeListStream("./text_test.txt"), StreamException);
+
+  // one more than the largest id does not fit in a node_id_t
+  {
+    std::ofstream out("./text_test.txt");
+    out << "0 1\n2 " << std::numeric_limits<node_id_t>::max() << "\n";
+  }
+  ASSERT_THROW(TextEdgeListStream("./text_test.txt"), StreamException);
+
+  // with the number of vertices known, lines are checked as they are read
+  {
+    std::ofstream out("./text_test.txt");
+    out << "0 1\n2 30\n";
+  }
+  TextEdgeListStream stream("./text_test.txt", 10);
+  std::vector<GraphStreamUpdate> buf(10);
+  ASSERT_THROW(stream.get_update_buffer(buf.data(), buf.size()), StreamException);
+}
@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "tracer.h"
+
+static size_t count_occurrences(const std::string &str, const std::string &pattern) {
+  size_t count = 0;
+  for (size_t pos = str.find(pattern); pos != std::string::npos; pos = str.find(pattern, pos + 1))
+    count++;
+  return count;
+}
+
+TEST(TracerTest, RecordsSpansOfEveryThread) {
+  Tracer::clear();
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < 4; t++) {
+    threads.emplace_back([t]() {
+      Tracer::set_thread_name("tracer test " + std::to_string(t));
+      for (uint64_t i = 0; i < 10; i++) {
+        uint64_t begin = Tracer::now_ns();
+        Tracer::record(TRACE_BATCH_APPLY, begin, begin + 1000, 100 + i);
+      }
+    });
+  }
+  for (auto &thr : threads) thr.join();
+
+  // the spans of exited threads are kept
+  std::stringstream trace;
+  Tracer::write_chrome_trace(trace);
+  std::string json = trace.str();
+  ASSERT_EQ(0, json.find("{\"displayTimeUnit\": \"ns\", \"traceEvents\": ["));
+  ASSERT_EQ(40, count_occurrences(json, "\"name\": \"batch_apply\", \"ph\": \"X\""));
+  ASSERT_EQ(4, count_occurrences(json, "\"args\": {\"updates\": 109}"));
+  ASSERT_EQ(40, count_occurrences(json, "\"dur\": 1.000"));
+  for (size_t t = 0; t < 4; t++)
+    ASSERT_NE(std::string::npos, json.find("\"name\": \"tracer test " + std::to_string(t)));
+
+  Tracer::clear();
+  std::stringstream empty;
+  Tracer::write_chrome_trace(empty);
+  ASSERT_EQ(0, count_occurrences(empty.str(), "batch_apply"));
+}
+
+TEST(TracerTest, RingKeepsLatestSpans) {
+  Tracer::clear();
+  Tracer::set_thread_capacity(8);
+  std::thread thr([]() {
+    for (uint64_t i = 0; i < 20; i++) Tracer::record(TRACE_BORUVKA_ROUND, i, i + 1, i);
+  });
+  thr.join();
+  Tracer::set_thread_capacity(1 << 16);
+
+  std::stringstream trace;
+  Tracer::write_chrome_trace(trace);
+  std::string json = trace.str();
+  ASSERT_EQ(8, count_occurrences(json, "\"name\": \"boruvka_round\""));
+  ASSERT_EQ(std::string::npos, json.find("\"round\": 11}"));
+  ASSERT_NE(std::string::npos, json.find("\"round\": 12}"));
+  ASSERT_NE(std::string::npos, json.find("\"round\": 19}"));
+  Tracer::clear();
+}
@@ -0,0 +1,50 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "update_cancellation_cache.h"
+
+TEST(UpdateCancellationCacheTest, OppositeUpdatesCancel) {
+  UpdateCancellationCache cache(64);
+  std::vector<GraphUpdate> emitted;
+  auto emit = [&](const GraphUpdate &upd) { emitted.push_back(upd); };
+
+  cache.insert({{1, 2}, INSERT}, emit);
+  cache.insert({{2, 1}, DELETE}, emit);  // same edge with its endpoints reversed
+  cache.insert({{3, 4}, INSERT}, emit);
+  cache.insert({{3, 4}, INSERT}, emit);  // not opposite, so the first is passed on
+  cache.flush(emit);
+
+  ASSERT_EQ(2, cache.take_num_cancelled());
+  ASSERT_EQ(0, cache.take_num_cancelled());
+  ASSERT_EQ(2, emitted.size());
+  for (auto &upd : emitted) ASSERT_EQ(3, upd.edge.src);
+}
+
+TEST(UpdateCancellationCacheTest, EveryUpdateIsCancelledOrPassedOn) {
+  UpdateCancellationCache cache(16);
+  std::vector<int> parity(100 * 100, 0);
+  size_t num_updates = 0;
+  size_t num_emitted = 0;
+  auto emit = [&](const GraphUpdate &upd) {
+    parity[upd.edge.src * 100 + upd.edge.dst] ^= 1;
+    num_emitted++;
+  };
+
+  // insert and later delete many more edges than fit in the window
+  std::vector<int> expected(100 * 100, 0);
+  for (node_id_t round = 0; round < 3; round++) {
+    for (node_id_t src = 0; src < 100; src += 3) {
+      for (node_id_t dst = src + 1; dst < 100; dst += 7) {
+        UpdateType type = round == 1 ? DELETE : INSERT;
+        cache.insert({{src, dst}, type}, emit);
+        expected[src * 100 + dst] ^= 1;
+        num_updates++;
+      }
+    }
+  }
+  cache.flush(emit);
+
+  ASSERT_EQ(expected, parity);
+  ASSERT_EQ(num_updates, num_emitted + cache.take_num_cancelled());
+}
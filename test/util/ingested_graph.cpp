@@ -0,0 +1,19 @@
+#include "ingested_graph.h"
+
+IngestedGraph::IngestedGraph(StreamGeneratorConfiguration gen_config)
+    : stream(gen_config.get_num_vertices(), StreamGenerator(gen_config).get_updates()) {}
+
+void IngestedGraph::build(size_t seed, CCAlgConfiguration alg_config,
+                          DriverConfiguration driver_config, size_t stream_threads) {
+  // the driver refers to the algorithm, so it goes first
+  driver.reset();
+  cc_alg.reset(new CCSketchAlg(stream.vertices(), seed, alg_config));
+  driver.reset(new GraphSketchDriver<CCSketchAlg>(cc_alg.get(), &stream, driver_config,
+                                                  stream_threads));
+}
+
+void IngestedGraph::ingest() {
+  if (driver == nullptr) build(0);
+  driver->process_stream_until(END_OF_STREAM);
+  driver->prep_query(CONNECTIVITY);
+}
@@ -1,10 +1,13 @@
 #include <benchmark/benchmark.h>
+#include <omp.h>
+#include <sys/resource.h>
 #include <unistd.h>
 #include <xxhash.h>
 
 #include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <random>
 #include <thread>
 #include <vector>
@@ -12,9 +15,13 @@
 
 #include "binary_file_stream.h"
 #include "bucket.h"
+#include "cc_sketch_alg.h"
 #include "dsu.h"
+#include "graph_sketch_driver.h"
+#include "in_memory_stream.h"
 #include "sketch.h"
 #include "edge_store.h"
+#include "stream_generator.h"
 
 constexpr uint64_t KB = 1024;
 constexpr uint64_t MB = KB * KB;
@@ -37,12 +44,22 @@ static void flush_filesystem_cache() {
   }
 }
 
-// Test the speed of reading all the data in the kron16 graph stream
+// The stream read by the file ingestion benchmarks, given by the BENCH_STREAM_FILE environment
+// variable
+static const char* bench_stream_file(benchmark::State& state) {
+  const char* file = std::getenv("BENCH_STREAM_FILE");
+  if (file == nullptr) state.SkipWithError("BENCH_STREAM_FILE is not set");
+  return file;
+}
+
+// Test the speed of reading all the data in the graph stream
 static void BM_FileIngest(benchmark::State& state) {
+  const char* stream_file = bench_stream_file(state);
+  if (stream_file == nullptr) return;
   // determine the number of edges in the graph
   uint64_t num_edges;
   {
-    BinaryFileStream stream("/mnt/ssd2/binary_streams/kron_15_stream_binary");
+    BinaryFileStream stream(stream_file);
     num_edges = stream.edges();
   }
 
@@ -51,12 +68,12 @@ static void BM_FileIngest(benchmark::State& state) {
 
   // perform benchmark
   for (auto _ : state) {
-    BinaryFileStream stream("/mnt/ssd2/binary_streams/kron_15_stream_binary");
+    BinaryFileStream stream(stream_file);
 
     bool reading = true;
     while (reading) {
       GraphStreamUpdate upds[state.range(0)];
-      size_t num_updates = stream->get_update_buffer(upds, state.range(0));
+      size_t num_updates = stream.get_update_buffer(upds, state.range(0));
       for (size_t i = 0; i < num_updates; i++) {
         GraphStreamUpdate &upd = upds[i];
         if (upd.type == BREAKPOINT) {
@@ -71,12 +88,14 @@ static void BM_FileIngest(benchmark::State& state) {
 }
 BENCHMARK(BM_FileIngest)->RangeMultiplier(2)->Range(KB << 2, MB / 4)->UseRealTime();
 
-// Test the speed of reading all the data in the kron16 graph stream
+// Test the speed of reading all the data in the graph stream
 static void BM_MTFileIngest(benchmark::State& state) {
+  const char* stream_file = bench_stream_file(state);
+  if (stream_file == nullptr) return;
   // determine the number of edges in the graph
   uint64_t num_edges;
   {
-    BinaryFileStream stream("/mnt/ssd2/binary_streams/kron_15_stream_binary");
+    BinaryFileStream stream(stream_file);
     num_edges = stream.edges();
   }
 
@@ -88,13 +107,13 @@ static void BM_MTFileIngest(benchmark::State& state) {
     std::vector<std::thread> threads;
     threads.reserve(state.range(0));
 
-    BinaryFileStream stream("/mnt/ssd2/binary_streams/kron_15_stream_binary");
+    BinaryFileStream stream(stream_file);
 
     auto task = [&]() {
       bool reading = true;
       while (reading) {
         GraphStreamUpdate upds[1024];
-        size_t num_updates = stream->get_update_buffer(upds, 1024);
+        size_t num_updates = stream.get_update_buffer(upds, 1024);
         for (size_t i = 0; i < num_updates; i++) {
           GraphStreamUpdate &upd = upds[i];
           if (upd.type == BREAKPOINT) {
@@ -567,4 +586,223 @@ static void BM_EdgeStore(benchmark::State& state) {
 }
 BENCHMARK(BM_EdgeStore);
 
+// Measure the latency of prep_query() when the guttering system holds no updates.
+// This is the fixed cost of pausing the graph workers before every query.
+static void BM_PrepQuery_Latency(benchmark::State& state) {
+  node_id_t num_vertices = 1 << 10;
+  std::string stream_file = "./bench_prep_query_stream.data";
+  {
+    // inserting and then deleting an edge prevents the eager dsu from answering queries
+    BinaryFileStream out(stream_file, false);
+    GraphStreamUpdate upds[2] = {{INSERT, {0, 1}}, {DELETE, {0, 1}}};
+    out.write_header(num_vertices, 2);
+    out.write_updates(upds, 2);
+  }
+
+  BinaryFileStream stream(stream_file);
+  CCSketchAlg cc_alg(num_vertices, seed);
+  auto driver_config = DriverConfiguration().gutter_sys(STANDALONE).worker_threads(state.range(0));
+  GraphSketchDriver<CCSketchAlg> driver(&cc_alg, &stream, driver_config);
+
+  for (auto _ : state) {
+    driver.process_stream_until(END_OF_STREAM);  // resumes the workers
+    auto start = std::chrono::steady_clock::now();
+    driver.prep_query(CONNECTIVITY);
+    std::chrono::duration<double> latency = std::chrono::steady_clock::now() - start;
+    state.SetIterationTime(latency.count());
+  }
+  std::remove(stream_file.c_str());
+}
+BENCHMARK(BM_PrepQuery_Latency)->RangeMultiplier(2)->Range(1, 16)->UseManualTime()
+    ->Unit(benchmark::kMicrosecond);
+
+// Peak resident set size of the process. reset_peak_rss() restarts the measurement where the
+// kernel supports it, otherwise the peak covers the life of the process.
+static void reset_peak_rss() {
+  std::ofstream clear_refs("/proc/self/clear_refs");
+  if (clear_refs.is_open()) clear_refs << "5" << std::endl;
+}
+
+static size_t peak_rss_bytes() {
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.rfind("VmHWM:", 0) == 0) return std::stoull(line.substr(6)) * KB;
+  }
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss * KB;
+}
+
+// An Erdos-Renyi stream in which a tenth of the edges are deleted and inserted again. Only the
+// most recent stream is kept, so it is generated once for consecutive benchmarks of a graph
+// without inflating the peak memory of the others.
+static const std::vector<GraphStreamUpdate>& get_generated_stream(node_id_t num_vertices,
+                                                                  size_t avg_degree) {
+  static std::pair<node_id_t, size_t> cached_graph;
+  static std::vector<GraphStreamUpdate> cached_updates;
+  if (cached_graph != std::make_pair(num_vertices, avg_degree) || cached_updates.empty()) {
+    cached_updates = {};
+    auto config = StreamGeneratorConfiguration()
+                      .model(ERDOS_RENYI)
+                      .num_vertices(num_vertices)
+                      .num_edges((edge_id_t)num_vertices * avg_degree / 2)
+                      .churn(0.1)
+                      .seed(seed);
+    cached_updates = StreamGenerator(config).get_updates();
+    cached_graph = {num_vertices, avg_degree};
+  }
+  return cached_updates;
+}
+
+// Measure end-to-end ingestion: stream threads read a generated in-memory stream, updates pass
+// through the guttering system, and the graph workers apply them to the sketches. The timer
+// stops once every update is applied. Building the algorithm and driver is not timed.
+// Arguments: log2 of the number of vertices, average degree, worker threads, stream threads
+// and guttering system.
+static void BM_CC_Ingest(benchmark::State& state) {
+  node_id_t num_vertices = node_id_t(1) << state.range(0);
+  size_t num_workers = state.range(2);
+  size_t num_readers = state.range(3);
+  GutterSystem gutter_sys = static_cast<GutterSystem>(state.range(4));
+  const std::vector<GraphStreamUpdate>& updates =
+      get_generated_stream(num_vertices, state.range(1));
+
+  reset_peak_rss();
+  double ingest_seconds = 0;
+  for (auto _ : state) {
+    InMemoryStream stream(num_vertices, updates.data(), updates.size());
+    CCSketchAlg cc_alg(num_vertices, seed);
+    auto driver_config =
+        DriverConfiguration().gutter_sys(gutter_sys).worker_threads(num_workers);
+    GraphSketchDriver<CCSketchAlg> driver(&cc_alg, &stream, driver_config, num_readers);
+
+    auto start = std::chrono::steady_clock::now();
+    driver.process_stream_until(END_OF_STREAM);
+    driver.prep_query(CONNECTIVITY);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    state.SetIterationTime(elapsed.count());
+    ingest_seconds += elapsed.count();
+  }
+  state.counters["Updates"] = updates.size();
+  state.counters["Edges/s"] = state.iterations() * updates.size() / ingest_seconds;
+  state.counters["Peak_RSS_MiB"] = (double)peak_rss_bytes() / MB;
+}
+
+// Rather than every combination, vary one parameter at a time around a common configuration
+static void ingest_arguments(benchmark::internal::Benchmark* bench) {
+  constexpr int64_t log_n = 14, degree = 32, workers = 4, readers = 2;
+  bench->ArgNames({"log_n", "degree", "workers", "readers", "gutters"});
+  for (int64_t n : {12, 14, 16}) bench->Args({n, degree, workers, readers, STANDALONE});
+  for (int64_t d : {4, 128, 512}) bench->Args({log_n, d, workers, readers, STANDALONE});
+  for (int64_t w : {1, 2, 8, 16}) bench->Args({log_n, degree, w, readers, STANDALONE});
+  for (int64_t r : {1, 4, 8}) bench->Args({log_n, degree, workers, r, STANDALONE});
+  for (int64_t g : {CACHETREE, GUTTERTREE}) bench->Args({log_n, degree, workers, readers, g});
+}
+BENCHMARK(BM_CC_Ingest)->Apply(ingest_arguments)->UseManualTime()->Unit(benchmark::kMillisecond);
+
+// Sketches of a graph with num_components components of equal size, each an Erdos-Renyi graph of
+// average degree 16 and so connected with high probability. Only the most recent graph is kept,
+// so consecutive benchmarks of a graph share its sketches.
+static CCSketchAlg& get_query_sketches(node_id_t num_vertices, node_id_t num_components) {
+  static std::pair<node_id_t, node_id_t> cached_graph;
+  static std::unique_ptr<CCSketchAlg> cached_alg;
+  if (cached_alg == nullptr || cached_graph != std::make_pair(num_vertices, num_components)) {
+    cached_alg.reset();
+    auto config = StreamGeneratorConfiguration()
+                      .model(ERDOS_RENYI)
+                      .num_vertices(num_vertices)
+                      .num_edges((edge_id_t)num_vertices * 8 * num_components)
+                      .seed(seed);
+    std::vector<GraphStreamUpdate> updates = StreamGenerator(config).get_updates();
+    // keep the edges within each component, about 1 in num_components of them
+    updates.erase(std::remove_if(updates.begin(), updates.end(),
+                                 [&](const GraphStreamUpdate& upd) {
+                                   return upd.edge.src % num_components !=
+                                          upd.edge.dst % num_components;
+                                 }),
+                  updates.end());
+    // Deleting and reinserting the first edge, which is in the spanning forest of the eager dsu,
+    // invalidates the dsu so prep_query() flushes every update into the sketches
+    updates.push_back({DELETE, updates[0].edge});
+    updates.push_back({INSERT, updates[0].edge});
+
+    cached_alg = std::make_unique<CCSketchAlg>(num_vertices, seed);
+    InMemoryStream stream(num_vertices, std::move(updates));
+    auto driver_config = DriverConfiguration().gutter_sys(STANDALONE).worker_threads(
+        std::max(1u, std::thread::hardware_concurrency()));
+    GraphSketchDriver<CCSketchAlg> driver(cached_alg.get(), &stream, driver_config);
+    driver.process_stream_until(END_OF_STREAM);
+    driver.prep_query(CONNECTIVITY);
+    cached_graph = {num_vertices, num_components};
+  }
+  return *cached_alg;
+}
+
+// Measure the latency of a connectivity query that must run Boruvka, broken into its parts: each
+// Boruvka round, the create_merge_instructions() portion of the rounds, and the construction of
+// the ConnectedComponents and SpanningForest results. The sketches are built once per graph and
+// every iteration queries the same sketches.
+// Arguments: log2 of the number of vertices, number of components and query threads.
+static void BM_CC_Query(benchmark::State& state) {
+  node_id_t num_vertices = node_id_t(1) << state.range(0);
+  node_id_t num_components = state.range(1);
+  CCSketchAlg& cc_alg = get_query_sketches(num_vertices, num_components);
+  int default_threads = omp_get_max_threads();
+  omp_set_num_threads(state.range(2));
+
+  // Likewise, deleting and reinserting a spanning forest edge leaves the sketches unchanged but
+  // forces the next query to run Boruvka
+  Edge forest_edge = cc_alg.calc_spanning_forest().get_edges().at(0);
+
+  std::vector<double> round_sums;
+  std::vector<size_t> round_counts;
+  double merge_instr_sum = 0, cc_build_sum = 0, sf_build_sum = 0;
+  size_t rounds_sum = 0, num_components_found = 0;
+  for (auto _ : state) {
+    cc_alg.update({forest_edge, DELETE});
+    cc_alg.update({forest_edge, INSERT});
+
+    auto start = std::chrono::steady_clock::now();
+    ConnectedComponents cc = cc_alg.connected_components();
+    std::chrono::duration<double> latency = std::chrono::steady_clock::now() - start;
+    state.SetIterationTime(latency.count());
+    num_components_found = cc.size();
+
+    rounds_sum += cc_alg.last_query_round_times.size();
+    for (size_t r = 0; r < cc_alg.last_query_round_times.size(); r++) {
+      if (r == round_sums.size()) {
+        round_sums.push_back(0);
+        round_counts.push_back(0);
+      }
+      round_sums[r] += cc_alg.last_query_round_times[r];
+      round_counts[r]++;
+    }
+    for (double merge_time : cc_alg.last_query_merge_instr_times) merge_instr_sum += merge_time;
+    cc_build_sum += cc_alg.last_cc_build_time;
+
+    // answered from the dsu, so only the SpanningForest construction remains
+    benchmark::DoNotOptimize(cc_alg.calc_spanning_forest());
+    sf_build_sum += cc_alg.last_sf_build_time;
+  }
+  omp_set_num_threads(default_threads);
+
+  double iters = state.iterations();
+  state.counters["Components"] = num_components_found;
+  state.counters["Rounds"] = rounds_sum / iters;
+  for (size_t r = 0; r < round_sums.size(); r++)
+    state.counters["Round" + std::to_string(r) + "_ms"] = 1e3 * round_sums[r] / round_counts[r];
+  state.counters["MergeInstr_ms"] = 1e3 * merge_instr_sum / iters;
+  state.counters["CC_build_ms"] = 1e3 * cc_build_sum / iters;
+  state.counters["SF_build_ms"] = 1e3 * sf_build_sum / iters;
+}
+
+static void query_arguments(benchmark::internal::Benchmark* bench) {
+  bench->ArgNames({"log_n", "components", "threads"});
+  for (int64_t log_n : {12, 14, 16})
+    for (int64_t components : {1, 256})
+      for (int64_t threads : {1, 4, 16}) bench->Args({log_n, components, threads});
+}
+BENCHMARK(BM_CC_Query)->Apply(query_arguments)->UseManualTime()->Unit(benchmark::kMillisecond);
+
 BENCHMARK_MAIN();
@@ -0,0 +1,48 @@
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "compressed_binary_stream.h"
+#include "mmap_binary_stream.h"
+
+static constexpr size_t update_array_size = 1 << 20;
+
+int main(int argc, char** argv) {
+
+  if (argc < 2 || argc > 4) {
+    std::cout << "ERROR: Incorrect number of arguments!" << std::endl;
+    std::cout << "Arguments: binary_stream [output_file] [block_updates]" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  std::string stream_name = argv[1];
+  std::string output_name = argc >= 3 ? argv[2] : stream_name + "_compressed";
+  uint32_t block_updates = CompressedStreamWriter::default_block_updates;
+  if (argc == 4) block_updates = std::atol(argv[3]);
+  if (block_updates < 1) {
+    std::cout << "ERROR: Invalid block_updates! Must be > 0." << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  MMapBinaryStream stream(stream_name);
+  std::cout << "Processing stream: " << stream_name << std::endl;
+  std::cout << "Writing compressed stream: " << output_name << std::endl;
+  auto start = std::chrono::steady_clock::now();
+  {
+    CompressedStreamWriter out(output_name, stream.vertices(), block_updates);
+    const GraphStreamUpdate* updates;
+    while (size_t num = stream.get_update_view(updates, update_array_size))
+      out.write_updates(updates, num);
+  }
+  std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+
+  size_t in_bytes =
+      sizeof(node_id_t) + sizeof(edge_id_t) + stream.edges() * sizeof(GraphStreamUpdate);
+  std::ifstream out_file(output_name, std::ios::binary | std::ios::ate);
+  size_t out_bytes = out_file.tellg();
+  std::cout << "Wrote " << stream.edges() << " updates in " << time.count() << " seconds"
+            << std::endl;
+  std::cout << "Compressed " << in_bytes << " bytes to " << out_bytes << " bytes ("
+            << (double)in_bytes / out_bytes << "x)" << std::endl;
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <charconv>
+#include <exception>
+#include <string>
+#include <vector>
+
+#include "text_edge_list_stream.h"
+
+// Text is parsed in batches of this many updates. Each batch is parsed in parallel.
+static constexpr size_t convert_batch_updates = 1 << 22;
+// Each thread parses this many updates of a batch at a time
+static constexpr size_t convert_piece_updates = 1 << 14;
+
+/**
+ * Call func(updates, num_updates) on every batch of updates of a text stream, in order.
+ * The updates of each batch are parsed in parallel, and func may modify them.
+ * @throws StreamException if a line is malformed.
+ */
+template <class Func>
+static void for_each_batch(TextEdgeListStream &stream, Func func) {
+  std::vector<GraphStreamUpdate> batch(std::min((edge_id_t)convert_batch_updates, stream.edges()));
+  for (edge_id_t begin = 0; begin < stream.edges(); begin += convert_batch_updates) {
+    edge_id_t end = std::min(begin + convert_batch_updates, stream.edges());
+    std::exception_ptr err;
+#pragma omp parallel for schedule(dynamic)
+    for (edge_id_t piece = begin; piece < end; piece += convert_piece_updates) {
+      try {
+        stream.get_updates(piece, std::min(piece + convert_piece_updates, end),
+                           batch.data() + (piece - begin));
+      } catch (...) {
+#pragma omp critical
+        err = std::current_exception();
+      }
+    }
+    if (err) std::rethrow_exception(err);
+    func(batch.data(), end - begin);
+  }
+}
+
+/**
+ * Assigns dense ids to the vertices that appear in a graph, in increasing order of their original
+ * ids. Vertices are marked in a bitmap, so marking is thread-safe and a lookup is a rank query.
+ */
+class DenseRelabeler {
+ private:
+  std::vector<uint64_t> present;
+  std::vector<node_id_t> rank;  // number of vertices marked in the words before each word
+  node_id_t num_marked = 0;
+
+ public:
+  // @param num_ids  one more than the largest id that may be marked
+  DenseRelabeler(node_id_t num_ids) : present(num_ids / 64 + 1, 0) {}
+
+  void mark(node_id_t v) {
+    __atomic_fetch_or(&present[v / 64], uint64_t(1) << (v % 64), __ATOMIC_RELAXED);
+  }
+
+  // Call once every vertex has been marked. Returns the number of marked vertices.
+  node_id_t finalize() {
+    rank.resize(present.size());
+    num_marked = 0;
+    for (size_t w = 0; w < present.size(); w++) {
+      rank[w] = num_marked;
+      num_marked += __builtin_popcountll(present[w]);
+    }
+    return num_marked;
+  }
+
+  // Are the marked vertices exactly [0, num_marked), so that relabeling changes nothing
+  bool is_identity() {
+    if (num_marked == 0) return true;
+    node_id_t last = num_marked - 1;
+    return (present[last / 64] >> (last % 64) & 1) && (*this)(last) == last;
+  }
+
+  node_id_t operator()(node_id_t v) const {
+    uint64_t below = present[v / 64] & ((uint64_t(1) << (v % 64)) - 1);
+    return rank[v / 64] + __builtin_popcountll(below);
+  }
+};
+
+// Append the decimal representation of x
+static inline void append_uint(std::string &out, uint64_t x) {
+  char buf[20];
+  char *end = std::to_chars(buf, buf + sizeof(buf), x).ptr;
+  out.append(buf, end);
+}
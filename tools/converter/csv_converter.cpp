@@ -1,15 +1,35 @@
 #include <iostream>
 #include <fstream>
-#include <sstream>
 #include <string>
-#include <map>
 #include <vector>
+#include <algorithm>
+#include <omp.h>
 
 #include "types.h"
 #include "util.h"
-#include <binary_file_stream.h>
+#include "converter_util.h"
+#include "mmap_binary_stream.h"
 
-static constexpr size_t update_array_size = 10000;
+static constexpr size_t update_array_size = 1 << 16;
+// Edges are partitioned into buckets by hash, and each bucket is resolved independently
+static constexpr size_t bucket_bits = 10;
+static constexpr size_t num_buckets = size_t(1) << bucket_bits;
+// Minimum size of a thread's bucket before it cancels its repeated edges
+static constexpr size_t min_cancel_size = 1 << 12;
+
+// Sort the edges and remove those that appear an even number of times, since an edge that is
+// inserted and deleted is absent from the static graph
+static void cancel_pairs(std::vector<edge_id_t> &edges) {
+  std::sort(edges.begin(), edges.end());
+  size_t kept = 0;
+  for (size_t i = 0; i < edges.size();) {
+    size_t j = i;
+    while (j < edges.size() && edges[j] == edges[i]) j++;
+    if ((j - i) % 2 == 1) edges[kept++] = edges[i];
+    i = j;
+  }
+  edges.resize(kept);
+}
 
 int main(int argc, char** argv) {
 
@@ -20,66 +40,82 @@ int main(int argc, char** argv) {
   }
 
   std::string stream_name = argv[1];
-  BinaryFileStream stream(stream_name);
-  std::string line;
+  MMapBinaryStream stream(stream_name);
 
   std::cout << "Processing stream: " << stream_name << std::endl;
 
-  GraphStreamUpdate update_array[update_array_size];
-
   //std::string csv_name = stream_name + "_symm.csv";
   std::string csv_static_name = stream_name + "_static_symm.csv";
   //std::ofstream csv_file(csv_name);
   std::ofstream csv_static_file(csv_static_name);
-  
-  std::unordered_map<vec_t, int> edges;
+
+  // Each thread reads chunks of the stream and partitions the edges by hash. Repeated edges are
+  // cancelled as a thread's buckets grow, so memory stays proportional to the surviving edges.
+  int num_threads = omp_get_max_threads();
+  std::vector<std::vector<std::vector<edge_id_t>>> thr_buckets(num_threads);
   size_t total_read_updates = 0;
-  bool read_complete = false;
 
   std::cout << "Reading edges...\n";
-  while (!read_complete) {
-    size_t updates = stream.get_update_buffer(update_array, update_array_size);
-
-    total_read_updates += updates;
-    if (total_read_updates % 100000000 == 0) {
-      std::cout << "  Progress: " << total_read_updates << "\n";
-    }
-
-    for (size_t i = 0; i < updates; i++) {
-      GraphUpdate upd;
-      upd.edge = update_array[i].edge;
-      upd.type = static_cast<UpdateType>(update_array[i].type);
-      if (upd.type == BREAKPOINT) {
-        total_read_updates -= (updates - i);
-        read_complete = true;
-        break;
-      }
-      else {
-        vec_t edge_id = static_cast<vec_t>(concat_pairing_fn(upd.edge.src, upd.edge.dst));
-        if (!edges.insert({edge_id, 1}).second) {
-          // Current edge already exist, so delete
-          if (edges.erase(edge_id) == 0) {
-            std::cerr << "ERROR: We found a duplicate but couldn't remove???" << std::endl;
-            exit(EXIT_FAILURE);
-          }
+#pragma omp parallel reduction(+ : total_read_updates)
+  {
+    auto &buckets = thr_buckets[omp_get_thread_num()];
+    buckets.resize(num_buckets);
+    std::vector<size_t> cancel_size(num_buckets, min_cancel_size);
+    const GraphStreamUpdate *updates;
+    while (size_t num = stream.get_update_view(updates, update_array_size)) {
+      total_read_updates += num;
+      for (size_t i = 0; i < num; i++) {
+        edge_id_t edge_id = concat_pairing_fn(updates[i].edge.src, updates[i].edge.dst);
+        size_t b = (edge_id * 0x9E3779B97F4A7C15) >> (64 - bucket_bits);
+        buckets[b].push_back(edge_id);
+        if (buckets[b].size() >= cancel_size[b]) {
+          cancel_pairs(buckets[b]);
+          cancel_size[b] = std::max(min_cancel_size, 2 * buckets[b].size());
         }
-        //csv_file << upd.edge.src << " " << upd.edge.dst << "\n";
-        //csv_file << upd.edge.dst << " " << upd.edge.src << "\n";
       }
     }
   }
 
   std::cout << "Finished Reading Input Graph File...\n";
   std::cout << "# of Total Updates: " << total_read_updates << "\n";
-  std::cout << "# of Edges (without duplicate edges): " << edges.size() << "\n";
+
+  // resolve and format groups of buckets in parallel, then write them in order
   std::cout << "Writing static graph\n";
+  size_t num_edges = 0;
+  std::vector<std::string> bucket_lines(num_buckets);
+  size_t group_size = std::min(num_buckets, 4 * (size_t)num_threads);
+  for (size_t first = 0; first < num_buckets; first += group_size) {
+    size_t last = std::min(first + group_size, num_buckets);
+#pragma omp parallel for schedule(dynamic) reduction(+ : num_edges)
+    for (size_t b = first; b < last; b++) {
+      std::vector<edge_id_t> edges;
+      for (auto &buckets : thr_buckets) {
+        edges.insert(edges.end(), buckets[b].begin(), buckets[b].end());
+        std::vector<edge_id_t>().swap(buckets[b]);
+      }
+      cancel_pairs(edges);
+      num_edges += edges.size();
 
-  for (auto& edge : edges) {
-    Edge e = inv_concat_pairing_fn(edge.first);
-    csv_static_file << e.src << " " << e.dst << "\n";
-    csv_static_file << e.dst << " " << e.src << "\n";
+      std::string &lines = bucket_lines[b];
+      for (edge_id_t edge_id : edges) {
+        Edge e = inv_concat_pairing_fn(edge_id);
+        append_uint(lines, e.src);
+        lines += ' ';
+        append_uint(lines, e.dst);
+        lines += '\n';
+        append_uint(lines, e.dst);
+        lines += ' ';
+        append_uint(lines, e.src);
+        lines += '\n';
+      }
+    }
+    for (size_t b = first; b < last; b++) {
+      csv_static_file << bucket_lines[b];
+      std::string().swap(bucket_lines[b]);
+    }
   }
+  std::cout << "# of Edges (without duplicate edges): " << num_edges << "\n";
 
   //csv_file.close();
   csv_static_file.close();
-}
\ No newline at end of file
+}
@@ -0,0 +1,68 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "grouped_stream.h"
+#include "types.h"
+#include <binary_file_stream.h>
+
+static constexpr size_t update_array_size = 10000;
+
+// Call func(edge) for every update of a binary stream
+template <class Func>
+static void for_each_update(const std::string &stream_name, Func func) {
+  BinaryFileStream stream(stream_name);
+  GraphStreamUpdate update_array[update_array_size];
+  while (true) {
+    size_t updates = stream.get_update_buffer(update_array, update_array_size);
+    for (size_t i = 0; i < updates; i++) {
+      if (static_cast<UpdateType>(update_array[i].type) == BREAKPOINT) return;
+      func(update_array[i].edge);
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+
+  if (argc != 2 && argc != 3) {
+    std::cout << "ERROR: Incorrect number of arguments!" << std::endl;
+    std::cout << "Arguments: binary_stream [output_file]" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  std::string stream_name = argv[1];
+  std::string output_name = argc == 3 ? argv[2] : stream_name + "_grouped";
+  node_id_t num_vertices = BinaryFileStream(stream_name).vertices();
+
+  std::cout << "Processing stream: " << stream_name << std::endl;
+  auto start = std::chrono::steady_clock::now();
+
+  // Each update (u, v) becomes an update in the run of u and in the run of v. Count the length of
+  // each run, then place the updates with a counting sort.
+  std::cout << "Counting updates per vertex...\n";
+  std::vector<size_t> run_begin(num_vertices + 1, 0);
+  for_each_update(stream_name, [&](const Edge &edge) {
+    run_begin[edge.src + 1]++;
+    run_begin[edge.dst + 1]++;
+  });
+  for (node_id_t v = 0; v < num_vertices; v++) run_begin[v + 1] += run_begin[v];
+
+  std::cout << "Grouping updates...\n";
+  std::vector<node_id_t> dsts(run_begin[num_vertices]);
+  std::vector<size_t> run_end(run_begin.begin(), run_begin.end() - 1);
+  for_each_update(stream_name, [&](const Edge &edge) {
+    dsts[run_end[edge.src]++] = edge.dst;
+    dsts[run_end[edge.dst]++] = edge.src;
+  });
+
+  std::cout << "Writing grouped stream: " << output_name << std::endl;
+  {
+    GroupedStreamWriter out(output_name, num_vertices);
+    for (node_id_t v = 0; v < num_vertices; v++)
+      out.write_run(v, dsts.data() + run_begin[v], run_begin[v + 1] - run_begin[v]);
+  }
+
+  std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+  std::cout << "Wrote " << dsts.size() << " updates in " << time.count() << " seconds" << std::endl;
+}
@@ -1,10 +1,14 @@
+#include <algorithm>
 #include <iostream>
 #include <fstream>
-#include <sstream>
 #include <string>
-#include <map>
 #include <vector>
 
+#include "converter_util.h"
+
+// Number of vertices whose lines are formatted in parallel before being written
+static constexpr size_t write_batch_nodes = 1 << 16;
+
 int main(int argc, char** argv) {
 
   if (argc != 2) {
@@ -14,65 +18,59 @@ int main(int argc, char** argv) {
   }
 
   std::string file_name = argv[1];
-  std::ifstream graph_file(file_name);
-  std::string line;
-  
-  size_t num_nodes = 0;
-  size_t num_edges = 0;
-  size_t current_node_id = 1;
-  size_t num_self_edges = 0;
 
-  std::map<size_t, size_t> simplified_node_ids;
-  std::map<size_t, std::vector<size_t>> nodes_list;
-  
   std::cout << "Input Graph File: " << file_name << "\n";
   std::cout << "Reading Input Graph File...\n";
 
-  if(graph_file.is_open()) {
-    while(std::getline(graph_file, line)) {
-      std::istringstream iss(line);
-      std::string token;
-
-      size_t node1, node2;
-
-      std::getline(iss, token, ' '); // Make sure to check delimiter
-      node1 = std::stoi(token);
-
-      std::getline(iss, token, ' '); // Make sure to check delimiter
-      node2 = std::stoi(token);
-
-      if (simplified_node_ids.find(node1) == simplified_node_ids.end()) {
-        simplified_node_ids[node1] = current_node_id;
-        nodes_list[current_node_id] = std::vector<size_t>();
-
-        num_nodes++;
-        current_node_id++;
-      }
-
-      if (simplified_node_ids.find(node2) == simplified_node_ids.end()) {
-        simplified_node_ids[node2] = current_node_id;
-        nodes_list[current_node_id] = std::vector<size_t>();
+  // finds the largest vertex id and counts the edges in parallel
+  TextEdgeListStream graph_file(file_name);
+  size_t num_edges = graph_file.edges();
+
+  // METIS numbers vertices densely from 1. Relabel in increasing order of the original ids.
+  DenseRelabeler relabel(graph_file.vertices());
+  for_each_batch(graph_file, [&](GraphStreamUpdate* updates, size_t num) {
+#pragma omp parallel for
+    for (size_t i = 0; i < num; i++) {
+      relabel.mark(updates[i].edge.src);
+      relabel.mark(updates[i].edge.dst);
+    }
+  });
+  size_t num_nodes = relabel.finalize();
 
-        num_nodes++;
-        current_node_id++;
-      }
-      
-      size_t simplified_node1 = simplified_node_ids[node1];
-      size_t simplified_node2 = simplified_node_ids[node2];
-      
-      if (simplified_node1 == simplified_node2) {
+  // build the adjacency lists with a parallel counting sort
+  size_t num_self_edges = 0;
+  std::vector<size_t> adj_begin(num_nodes + 1, 0);
+  for_each_batch(graph_file, [&](GraphStreamUpdate* updates, size_t num) {
+#pragma omp parallel for reduction(+ : num_self_edges)
+    for (size_t i = 0; i < num; i++) {
+      node_id_t src = relabel(updates[i].edge.src);
+      node_id_t dst = relabel(updates[i].edge.dst);
+      if (src == dst) {
         num_self_edges++;
+        continue;
       }
-      
-      nodes_list[simplified_node1].push_back(simplified_node2);
-      nodes_list[simplified_node2].push_back(simplified_node1);
-
-      num_edges++;
+      __atomic_fetch_add(&adj_begin[src + 1], 1, __ATOMIC_RELAXED);
+      __atomic_fetch_add(&adj_begin[dst + 1], 1, __ATOMIC_RELAXED);
     }
-  }
-  else {
-    std::cout << "Error: Couldn't find file name: " << file_name << "!\n";
-  }
+  });
+  for (size_t v = 0; v < num_nodes; v++) adj_begin[v + 1] += adj_begin[v];
+
+  std::vector<node_id_t> neighbors(adj_begin[num_nodes]);
+  std::vector<size_t> adj_end(adj_begin.begin(), adj_begin.end() - 1);
+  for_each_batch(graph_file, [&](GraphStreamUpdate* updates, size_t num) {
+#pragma omp parallel for
+    for (size_t i = 0; i < num; i++) {
+      node_id_t src = relabel(updates[i].edge.src);
+      node_id_t dst = relabel(updates[i].edge.dst);
+      if (src == dst) continue;
+      neighbors[__atomic_fetch_add(&adj_end[src], 1, __ATOMIC_RELAXED)] = dst;
+      neighbors[__atomic_fetch_add(&adj_end[dst], 1, __ATOMIC_RELAXED)] = src;
+    }
+  });
+  // the scatter order depends on thread timing, so sort each list to make the output repeatable
+#pragma omp parallel for schedule(dynamic, 1024)
+  for (size_t v = 0; v < num_nodes; v++)
+    std::sort(neighbors.begin() + adj_begin[v], neighbors.begin() + adj_begin[v + 1]);
 
   std::cout << "  Num Nodes: " << num_nodes << "\n";
   std::cout << "  Num Input Edges: " << num_edges << "\n";
@@ -83,8 +81,6 @@ int main(int argc, char** argv) {
   std::cout << "  Num Final Edges: " << num_edges << "\n";
   std::cout << "Finished Reading Input Graph File...\n";
 
-  graph_file.close();
-
   std::string metis_name = file_name + ".metis";
   std::ofstream metis_file(metis_name);
 
@@ -92,18 +88,24 @@ int main(int argc, char** argv) {
 
   metis_file << num_nodes << " " << num_edges << " 0" << "\n";
 
-  for (auto it : nodes_list) {
-    for (size_t neighbor = 0; neighbor < it.second.size(); neighbor++) {
-      if (it.second[neighbor] == it.first) {
-        continue;
+  // format the lines of a batch of vertices in parallel, then write them in order
+  std::vector<std::string> lines(write_batch_nodes);
+  for (size_t first = 0; first < num_nodes; first += write_batch_nodes) {
+    size_t last = std::min(first + write_batch_nodes, num_nodes);
+#pragma omp parallel for schedule(dynamic, 256)
+    for (size_t v = first; v < last; v++) {
+      std::string &line = lines[v - first];
+      line.clear();
+      for (size_t i = adj_begin[v]; i < adj_begin[v + 1]; i++) {
+        append_uint(line, neighbors[i] + 1);
+        line += ' ';
       }
-      metis_file << (it.second[neighbor]) << " ";
-      
+      line += '\n';
     }
-    metis_file << "\n";  
+    for (size_t v = first; v < last; v++) metis_file << lines[v - first];
   }
-  
+
   metis_file.close();
 
   std::cout << "Finished Writing METIS file...\n";
-}
\ No newline at end of file
+}
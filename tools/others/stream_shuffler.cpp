@@ -1,120 +1,401 @@
+#include <fcntl.h>
+#include <omp.h>
+#include <unistd.h>
+
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cmath>
 #include <iostream>
+#include <memory>
 #include <random>
+#include <tuple>
+#include <type_traits>
 #include <vector>
 
 #include "types.h"
 #include <binary_file_stream.h>
 
-static constexpr size_t update_array_size = 10000;
+/*
+ * Shuffles a binary stream that may be much larger than memory.
+ *
+ * Every update is sent to a uniformly random final bucket, where the bucket of update i is a hash
+ * of (seed, i). The buckets are laid out one after another in a temporary file, sized by first
+ * counting the hashes. Each thread scatters its part of the stream into a fixed size append
+ * buffer per bucket, and writes a full buffer as one large block at an offset it reserves in the
+ * bucket with an atomic cursor. If there are too many buckets for each thread to have a large
+ * buffer for each of them, the scatter takes several levels: each level splits every region of
+ * the previous level into at most fanout sub-regions, and the final bucket of each update travels
+ * with it between levels. Then each bucket is read into memory, shuffled and written to its place
+ * in the output. Concatenating independently shuffled uniform buckets gives a uniform
+ * permutation. Since buckets are sorted before being shuffled, the output depends only on the
+ * seed and the number of buckets, which is chosen from the memory budget and the number of
+ * threads, and not on the order in which threads fill the buckets.
+ */
+
+static constexpr size_t edge_size = sizeof(GraphStreamUpdate);
+static constexpr size_t header_size = sizeof(node_id_t) + sizeof(edge_id_t);
+static constexpr size_t min_block_bytes = 64 * 1024;
+static constexpr size_t max_block_bytes = 4 * 1024 * 1024;
+static constexpr double bucket_slack = 1.25;  // for buckets that are larger than average
+
+#pragma pack(push, 1)
+// An update and its final bucket, while it passes through the intermediate levels
+struct TaggedUpdate {
+  uint32_t bucket;
+  GraphStreamUpdate update;
+};
+#pragma pack(pop)
+
+static void read_fully(int fd, void *buf, size_t bytes, size_t offset) {
+  while (bytes > 0) {
+    ssize_t res = pread(fd, buf, bytes, offset);
+    if (res <= 0) {
+      std::cerr << "ERROR: Could not read stream" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    buf = (char *)buf + res;
+    bytes -= res;
+    offset += res;
+  }
+}
+
+static void write_fully(int fd, const void *buf, size_t bytes, size_t offset) {
+  while (bytes > 0) {
+    ssize_t res = pwrite(fd, buf, bytes, offset);
+    if (res <= 0) {
+      std::cerr << "ERROR: Could not write stream" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    buf = (const char *)buf + res;
+    bytes -= res;
+    offset += res;
+  }
+}
+
+static inline size_t bucket_of(edge_id_t idx, size_t seed, size_t num_buckets) {
+  uint64_t hash = XXH3_64bits_withSeed(&idx, sizeof(idx), seed);
+  return ((unsigned __int128)hash * num_buckets) >> 64;
+}
+
+static inline const GraphStreamUpdate &update_of(const GraphStreamUpdate &upd) { return upd; }
+static inline const GraphStreamUpdate &update_of(const TaggedUpdate &rec) { return rec.update; }
+
+template <class Record>
+static inline Record make_record(uint32_t bucket, const GraphStreamUpdate &upd);
+template <>
+inline GraphStreamUpdate make_record(uint32_t, const GraphStreamUpdate &upd) { return upd; }
+template <>
+inline TaggedUpdate make_record(uint32_t bucket, const GraphStreamUpdate &upd) {
+  return {bucket, upd};
+}
+
+/*
+ * A thread's append buffers for the sub-regions of the region it is scattering. Sub-region s
+ * begins at final bucket base + s * span, and its records are written at the cursor of that
+ * bucket, which is advanced atomically so that threads never write the same place.
+ */
+template <class Record>
+class AppendBuffers {
+ private:
+  int fd;
+  size_t block_records;
+  std::vector<Record> blocks;
+  std::vector<size_t> fill;
+  std::atomic<edge_id_t> *cursors;
+  size_t base = 0;
+  size_t span = 1;
+
+ public:
+  AppendBuffers(int fd, size_t fanout, size_t block_records, std::atomic<edge_id_t> *cursors)
+      : fd(fd),
+        block_records(block_records),
+        blocks(fanout * block_records),
+        fill(fanout, 0),
+        cursors(cursors) {}
+
+  void set_region(size_t new_base, size_t new_span) {
+    flush_all();
+    base = new_base;
+    span = new_span;
+  }
+
+  void append(size_t sub, const Record &rec) {
+    blocks[sub * block_records + fill[sub]++] = rec;
+    if (fill[sub] == block_records) flush(sub);
+  }
+
+  void flush(size_t sub) {
+    if (fill[sub] == 0) return;
+    edge_id_t offset = cursors[base + sub * span].fetch_add(fill[sub]);
+    write_fully(fd, &blocks[sub * block_records], fill[sub] * sizeof(Record),
+                offset * sizeof(Record));
+    fill[sub] = 0;
+  }
+
+  void flush_all() {
+    for (size_t sub = 0; sub < fill.size(); sub++) flush(sub);
+  }
+};
+
+// A contiguous part of a region, scattered by one thread
+struct Slice {
+  edge_id_t begin;
+  edge_id_t end;
+  size_t region;
+};
+
+/*
+ * Scatter one level. Reads the records of each slice from in_fd and appends each to the
+ * sub-region of its final bucket in out_fd. The final buckets of the stream itself are hashed
+ * from the index of each update.
+ */
+template <class InRecord, class OutRecord>
+static void scatter_level(int in_fd, size_t in_offset, int out_fd,
+                          const std::vector<Slice> &slices, size_t fanout, size_t span,
+                          size_t block_bytes, size_t seed, size_t num_buckets,
+                          std::atomic<edge_id_t> *cursors) {
+#pragma omp parallel
+  {
+    size_t chunk_records = std::max(block_bytes / sizeof(InRecord), (size_t)1);
+    size_t out_records = std::max(block_bytes / sizeof(OutRecord), (size_t)1);
+    std::vector<InRecord> chunk(chunk_records);
+    AppendBuffers<OutRecord> buffers(out_fd, fanout, out_records, cursors);
+#pragma omp for schedule(dynamic)
+    for (size_t s = 0; s < slices.size(); s++) {
+      const Slice &slice = slices[s];
+      size_t region_base = slice.region * fanout * span;
+      buffers.set_region(region_base, span);
+      for (edge_id_t first = slice.begin; first < slice.end; first += chunk_records) {
+        size_t num = std::min((edge_id_t)chunk_records, slice.end - first);
+        read_fully(in_fd, chunk.data(), num * sizeof(InRecord),
+                   in_offset + first * sizeof(InRecord));
+        for (size_t i = 0; i < num; i++) {
+          uint32_t bucket;
+          if constexpr (std::is_same<InRecord, TaggedUpdate>::value)
+            bucket = chunk[i].bucket;
+          else
+            bucket = bucket_of(first + i, seed, num_buckets);
+          size_t sub = (bucket - region_base) / span;
+          buffers.append(sub, make_record<OutRecord>(bucket, update_of(chunk[i])));
+        }
+      }
+    }
+    buffers.flush_all();
+  }
+}
+
+// How the stream is split into buckets and scattered, for a given memory budget per thread
+struct ShufflePlan {
+  size_t num_levels;
+  size_t fanout;
+  size_t num_buckets;  // fanout ^ num_levels
+  size_t block_bytes;
+  size_t bucket_bytes;  // memory for a bucket while shuffling, with slack
+};
+
+static ShufflePlan plan_shuffle(edge_id_t num_updates, size_t num_threads, size_t thread_bytes) {
+  ShufflePlan plan;
+  // each thread holds a bucket while shuffling
+  size_t bucket_updates = std::max((size_t)(thread_bytes / (bucket_slack * edge_size)), (size_t)1);
+  size_t min_buckets = std::max((size_t)((num_updates + bucket_updates - 1) / bucket_updates),
+                                num_threads);
+
+  // and a read chunk and a block for each sub-region while scattering
+  size_t max_fanout = std::max(thread_bytes / min_block_bytes, (size_t)3) - 1;
+  plan.num_levels = 1;
+  double reach = max_fanout;
+  while (reach < min_buckets) {
+    plan.num_levels++;
+    reach *= max_fanout;
+  }
+  plan.fanout = std::max((size_t)std::ceil(std::pow(min_buckets, 1.0 / plan.num_levels)) - 1,
+                         (size_t)2);
+  auto power = [&](size_t base) {
+    size_t result = 1;
+    for (size_t l = 0; l < plan.num_levels; l++) result *= base;
+    return result;
+  };
+  while (power(plan.fanout) < min_buckets) plan.fanout++;
+  plan.num_buckets = power(plan.fanout);
+  plan.block_bytes = std::min(thread_bytes / (plan.fanout + 1), max_block_bytes);
+  plan.bucket_bytes = bucket_slack * edge_size * ((num_updates + plan.num_buckets - 1) /
+                                                  plan.num_buckets);
+  return plan;
+}
+
+// Bytes of the bucket counts, bucket offsets and cursors, which are shared by the threads
+static size_t metadata_bytes(const ShufflePlan &plan, size_t num_threads) {
+  return num_threads * plan.num_buckets * sizeof(edge_id_t) +       // per thread counts
+         (plan.num_buckets + 1) * sizeof(edge_id_t) +                 // bucket offsets
+         plan.num_buckets * sizeof(std::atomic<edge_id_t>) +          // cursors
+         std::max(plan.num_buckets, num_threads) * 2 * sizeof(Slice);  // slices of a level
+}
 
 int main(int argc, char** argv) {
 
-  if (argc != 2) {
+  if (argc < 2 || argc > 5) {
     std::cout << "ERROR: Incorrect number of arguments!" << std::endl;
-    std::cout << "Arguments: graph_file" << std::endl;
+    std::cout << "Arguments: graph_file [output_file] [memory_MiB] [seed]" << std::endl;
+    std::cout << "memory_MiB defaults to 1024 and seed to 0" << std::endl;
     exit(EXIT_FAILURE);
   }
 
   std::string stream_name = argv[1];
-  std::string output_name = stream_name + "_shuffled";
+  std::string output_name = argc >= 3 ? argv[2] : stream_name + "_shuffled";
+  size_t memory_bytes = (argc >= 4 ? std::atol(argv[3]) : 1024) * 1024 * 1024;
+  size_t seed = argc >= 5 ? std::atol(argv[4]) : 0;
+  std::string temp_names[2] = {output_name + ".buckets0", output_name + ".buckets1"};
 
-  /*
-   * Reading Input Edge Stream
-   */
-  
   BinaryFileStream stream(stream_name);
+  edge_id_t num_updates = stream.edges();
+  size_t num_threads = omp_get_max_threads();
 
-  std::cout << "Processing stream: " << stream_name << std::endl;
-
-  GraphStreamUpdate update_array[update_array_size];
+  // the shared metadata grows with the number of buckets, which grows as the memory left to
+  // each thread shrinks, so settle on a plan that fits the budget with its metadata
+  size_t shared_bytes = 0;
+  ShufflePlan plan{};  // all zero if not even the metadata fits, which the check below rejects
+  for (size_t iter = 0; iter < 8; iter++) {
+    if (shared_bytes >= memory_bytes) break;
+    plan = plan_shuffle(num_updates, num_threads, (memory_bytes - shared_bytes) / num_threads);
+    size_t needed = metadata_bytes(plan, num_threads);
+    if (needed <= shared_bytes) break;
+    shared_bytes = needed;
+  }
+  size_t thread_peak = std::max((plan.fanout + 1) * plan.block_bytes, plan.bucket_bytes);
+  if (shared_bytes + num_threads * thread_peak > memory_bytes ||
+      plan.block_bytes < min_block_bytes) {
+    std::cerr << "ERROR: " << memory_bytes / (1024 * 1024) << " MiB is too little memory for "
+              << num_threads << " threads. Use more memory or fewer threads." << std::endl;
+    exit(EXIT_FAILURE);
+  }
 
-  std::vector<Edge> edges;
-  size_t total_read_updates = 0;
-  bool read_complete = false;
+  std::cout << "Processing stream: " << stream_name << std::endl;
+  std::cout << "Updates: " << num_updates << ", buckets: " << plan.num_buckets
+            << ", levels: " << plan.num_levels << ", fanout: " << plan.fanout
+            << ", block bytes: " << plan.block_bytes << ", metadata bytes: " << shared_bytes
+            << std::endl;
 
-  std::cout << "Reading edges...\n";
-  auto stream_read_start = std::chrono::steady_clock::now();
-  while (!read_complete) {
-    size_t updates = stream.get_update_buffer(update_array, update_array_size);
+  int in_fd = open(stream_name.c_str(), O_RDONLY);
+  int temp_fds[2] = {open(temp_names[0].c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644), -1};
+  if (plan.num_levels > 1)
+    temp_fds[1] = open(temp_names[1].c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  int out_fd = open(output_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (in_fd < 0 || temp_fds[0] < 0 || (plan.num_levels > 1 && temp_fds[1] < 0) || out_fd < 0) {
+    std::cerr << "ERROR: Could not open files" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  // removed once we close them
+  unlink(temp_names[0].c_str());
+  if (plan.num_levels > 1) unlink(temp_names[1].c_str());
 
-    total_read_updates += updates;
-    if (total_read_updates % 100000000 == 0) {
-      std::cout << "  Progress: " << total_read_updates << "\n";
+  /*
+   * Counting the updates of each bucket. This needs only the hashes, not the stream.
+   */
+  auto start = std::chrono::steady_clock::now();
+  std::vector<edge_id_t> bucket_begin(plan.num_buckets + 1, 0);
+  {
+    std::vector<edge_id_t> counts(num_threads * plan.num_buckets, 0);  // [thread][bucket]
+#pragma omp parallel
+    {
+      edge_id_t *thread_counts = &counts[omp_get_thread_num() * plan.num_buckets];
+#pragma omp for schedule(static)
+      for (edge_id_t i = 0; i < num_updates; i++)
+        thread_counts[bucket_of(i, seed, plan.num_buckets)]++;
     }
-
-    for (size_t i = 0; i < updates; i++) {
-      GraphUpdate upd;
-      upd.edge = update_array[i].edge;
-      upd.type = static_cast<UpdateType>(update_array[i].type);
-      if (upd.type == BREAKPOINT) {
-        read_complete = true;
-        break;
-      }
-      else {
-        edges.push_back(upd.edge);
-      }
+    edge_id_t total = 0;
+    for (size_t b = 0; b < plan.num_buckets; b++) {
+      bucket_begin[b] = total;
+      for (size_t t = 0; t < num_threads; t++) total += counts[t * plan.num_buckets + b];
     }
+    bucket_begin[plan.num_buckets] = total;
   }
-  auto stream_read_end = std::chrono::steady_clock::now();
-  std::chrono::duration<double> stream_read_time = stream_read_end - stream_read_start;
-
-  std::cout << "Total number of edges read: " << edges.size() << "\n";
-  std::cout << "Reading time (sec): " << stream_read_time.count() << "\n";
+  std::unique_ptr<std::atomic<edge_id_t>[]> cursors(
+      new std::atomic<edge_id_t>[plan.num_buckets]);
 
   /*
-   * Shuffling Edges 
+   * Scattering the updates into buckets, one level at a time
    */
+  std::cout << "Scattering updates into buckets...\n";
+  size_t region_span = plan.num_buckets;  // final buckets per region of this level
+  for (size_t level = 0; level < plan.num_levels; level++) {
+    size_t span = region_span / plan.fanout;
+    size_t num_regions = plan.num_buckets / region_span;
+    for (size_t b = 0; b < plan.num_buckets; b++) cursors[b] = bucket_begin[b];
 
-  std::cout << "Shuffling edges...\n";
-
-  // seed = 0
-  std::default_random_engine e(0);
+    // few regions are each split among several threads, many are each scattered by one thread
+    size_t parts = std::max(num_threads / num_regions, (size_t)1);
+    std::vector<Slice> slices;
+    for (size_t r = 0; r < num_regions; r++) {
+      edge_id_t begin = bucket_begin[r * region_span];
+      edge_id_t end = bucket_begin[(r + 1) * region_span];
+      for (size_t p = 0; p < parts; p++) {
+        edge_id_t slice_begin = begin + (end - begin) * p / parts;
+        edge_id_t slice_end = begin + (end - begin) * (p + 1) / parts;
+        if (slice_begin < slice_end) slices.push_back({slice_begin, slice_end, r});
+      }
+    }
 
-  auto stream_shuffle_start = std::chrono::steady_clock::now();
-  std::shuffle(edges.begin(), edges.end(), e);
-  auto stream_shuffle_end = std::chrono::steady_clock::now();
-  std::chrono::duration<double> stream_shuffle_time = stream_shuffle_end - stream_shuffle_start;
-  std::cout << "Shuffling time (sec): " << stream_shuffle_time.count() << "\n";
+    bool last_level = level + 1 == plan.num_levels;
+    int out_fd_level = temp_fds[level % 2];
+    if (level == 0 && last_level)
+      scatter_level<GraphStreamUpdate, GraphStreamUpdate>(
+          in_fd, header_size, out_fd_level, slices, plan.fanout, span, plan.block_bytes, seed,
+          plan.num_buckets, cursors.get());
+    else if (level == 0)
+      scatter_level<GraphStreamUpdate, TaggedUpdate>(
+          in_fd, header_size, out_fd_level, slices, plan.fanout, span, plan.block_bytes, seed,
+          plan.num_buckets, cursors.get());
+    else if (last_level)
+      scatter_level<TaggedUpdate, GraphStreamUpdate>(
+          temp_fds[(level + 1) % 2], 0, out_fd_level, slices, plan.fanout, span,
+          plan.block_bytes, seed, plan.num_buckets, cursors.get());
+    else
+      scatter_level<TaggedUpdate, TaggedUpdate>(
+          temp_fds[(level + 1) % 2], 0, out_fd_level, slices, plan.fanout, span,
+          plan.block_bytes, seed, plan.num_buckets, cursors.get());
+    region_span = span;
+  }
+  int buckets_fd = temp_fds[(plan.num_levels - 1) % 2];
+  std::chrono::duration<double> scatter_time = std::chrono::steady_clock::now() - start;
+  std::cout << "Scattering time (sec): " << scatter_time.count() << "\n";
 
   /*
-   * Writing Edge Stream with Shuffled Edges
+   * Shuffling each bucket in memory
    */
-
-  BinaryFileStream fout(output_name , false);
-  fout.write_header(stream.vertices(), stream.edges());
-
-  bool write_complete = false;
-
-  // Re-Initialize update_array
-  for (size_t i = 0; i < update_array_size; i++) {
-		update_array[i].edge = {0, 0};
-    update_array[i].type = INSERT;
-	}
-  
-  size_t update_array_index = 0;
-  size_t written_edges = 0;
-  std::cout << "Wrting edges back to stream...\n";
-  auto stream_write_start = std::chrono::steady_clock::now();
-  for (size_t i = 0; i < edges.size(); i++) {
-    update_array[update_array_index].edge = edges[i];
-
-    update_array_index++;
-    written_edges++;
-    if (update_array_index == update_array_size) {
-      fout.write_updates(update_array, update_array_size);
-      update_array_index = 0;
+  std::cout << "Shuffling buckets...\n";
+  auto shuffle_start = std::chrono::steady_clock::now();
+  node_id_t num_vertices = stream.vertices();
+  write_fully(out_fd, &num_vertices, sizeof(num_vertices), 0);
+  write_fully(out_fd, &num_updates, sizeof(num_updates), sizeof(num_vertices));
+#pragma omp parallel
+  {
+    std::vector<GraphStreamUpdate> bucket;
+#pragma omp for schedule(dynamic)
+    for (size_t b = 0; b < plan.num_buckets; b++) {
+      size_t num = bucket_begin[b + 1] - bucket_begin[b];
+      bucket.resize(num);
+      read_fully(buckets_fd, bucket.data(), num * edge_size, bucket_begin[b] * edge_size);
+      // the order threads filled the bucket in varies, so start from a canonical order
+      std::sort(bucket.begin(), bucket.end(),
+                [](const GraphStreamUpdate &a, const GraphStreamUpdate &b) {
+                  return std::make_tuple(a.edge.src, a.edge.dst, a.type) <
+                         std::make_tuple(b.edge.src, b.edge.dst, b.type);
+                });
+      std::seed_seq bucket_seed{seed, b};
+      std::mt19937_64 gen(bucket_seed);
+      std::shuffle(bucket.begin(), bucket.end(), gen);
+      write_fully(out_fd, bucket.data(), num * edge_size,
+                  header_size + bucket_begin[b] * edge_size);
     }
   }
+  for (int fd : temp_fds) {
+    if (fd >= 0) close(fd);
+  }
+  close(out_fd);
+  close(in_fd);
 
-  // Write any remaining edges to stream
-  if (update_array_index > 0) {
-		fout.write_updates(update_array, update_array_index);
-	}
-
-  auto stream_write_end = std::chrono::steady_clock::now();
-  std::chrono::duration<double> stream_write_time = stream_write_end - stream_write_start;
-  std::cout << "Writing time (sec): " << stream_write_time.count() << "\n";
-  std::cout << "Total number of edges written to stream: " << written_edges << "\n";
-}
\ No newline at end of file
+  std::chrono::duration<double> shuffle_time = std::chrono::steady_clock::now() - shuffle_start;
+  std::cout << "Shuffling time (sec): " << shuffle_time.count() << "\n";
+  std::cout << "Total number of edges written to stream: " << num_updates << "\n";
+}
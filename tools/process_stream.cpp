@@ -1,6 +1,11 @@
 #include <graph_sketch_driver.h>
 #include <cc_sketch_alg.h>
-#include <binary_file_stream.h>
+#include <autotuner.h>
+#include <mmap_binary_stream.h>
+#include <async_binary_stream.h>
+#include <text_edge_list_stream.h>
+#include <perf_counters.h>
+#include <tracer.h>
 #include <thread>
 #include <sys/resource.h> // for rusage
 
@@ -61,22 +66,43 @@ void track_insertions(uint64_t total, GraphSketchDriver<CCSketchAlg> *driver,
 }
 
 int main(int argc, char **argv) {
-  if (argc != 4) {
+  if (argc < 4 || argc > 6) {
     std::cout << "ERROR: Incorrect number of arguments!" << std::endl;
-    std::cout << "Arguments: stream_file, graph_workers, reader_threads" << std::endl;
+    std::cout << "Arguments: stream_file, graph_workers, reader_threads, [reader], [perf_json]"
+              << std::endl;
+    std::cout << "graph_workers may be auto, to tune the worker and reader threads, batch factor "
+              << "and gutter size on the beginning of the stream. reader_threads is then the "
+              << "total number of threads, 0 for all of them." << std::endl;
+    std::cout << "reader is mmap (default), async or text (a text edge list)" << std::endl;
+    std::cout << "perf_json is a file to write hardware counters of each phase to" << std::endl;
     exit(EXIT_FAILURE);
   }
 
   shutdown = false;
   std::string stream_file = argv[1];
-  int num_threads = std::atoi(argv[2]);
+  bool autotune = std::string(argv[2]) == "auto";
+  int num_threads = autotune ? 1 : std::atoi(argv[2]);
   if (num_threads < 1) {
     std::cout << "ERROR: Invalid number of graph workers! Must be > 0." << std::endl;
     exit(EXIT_FAILURE);
   }
   size_t reader_threads = std::atol(argv[3]);
-
-  BinaryFileStream stream(stream_file);
+  std::string reader = argc >= 5 ? argv[4] : "mmap";
+  std::string perf_json = argc == 6 ? argv[5] : "";
+
+  std::unique_ptr<GraphStream> stream_ptr;
+  if (reader == "mmap")
+    stream_ptr.reset(new MMapBinaryStream(stream_file));
+  else if (reader == "async")
+    stream_ptr.reset(new AsyncBinaryStream(stream_file));
+  else if (reader == "text")
+    stream_ptr.reset(new TextEdgeListStream(stream_file));
+  else {
+    std::cout << "ERROR: Unknown reader " << reader << "! Must be mmap, async or text."
+              << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  GraphStream &stream = *stream_ptr;
   node_id_t num_nodes = stream.vertices();
   size_t num_updates  = stream.edges();
   std::cout << "Processing stream: " << stream_file << std::endl;
@@ -87,6 +113,15 @@ int main(int argc, char **argv) {
   auto driver_config = DriverConfiguration().gutter_sys(CACHETREE).worker_threads(num_threads);
   driver_config.gutter_conf().buffer_exp(20).wq_batch_per_elm(8);
   auto cc_config = CCAlgConfiguration().batch_factor(1);
+  if (autotune) {
+    Autotuner tuner(AutotuneConfiguration().total_threads(reader_threads).seed(get_seed()));
+    AutotuneResult tuned = tuner.tune(stream, driver_config, cc_config);
+    std::cout << tuned << std::endl << std::endl;
+    driver_config.worker_threads(tuned.best.worker_threads);
+    driver_config.gutter_conf().gutter_bytes(tuned.best.gutter_bytes);
+    cc_config.batch_factor(tuned.best.batch_factor);
+    reader_threads = tuned.stream_threads;
+  }
 
   /*auto driver_config = DriverConfiguration().gutter_sys(CACHETREE).worker_threads(num_threads);
   driver_config.gutter_conf().buffer_exp(20).queue_factor(8).wq_batch_per_elm(32);
@@ -95,6 +130,11 @@ int main(int argc, char **argv) {
   CCSketchAlg cc_alg{num_nodes, get_seed(), cc_config};
   GraphSketchDriver<CCSketchAlg> driver{&cc_alg, &stream, driver_config, reader_threads};
 
+  PerfProfiler::enable(!perf_json.empty());
+#ifdef ENABLE_TRACING
+  Tracer::enable();
+  Tracer::set_thread_name("main");
+#endif
   auto ins_start = std::chrono::steady_clock::now();
   std::thread querier(track_insertions, num_updates, &driver, ins_start);
 
@@ -117,9 +157,24 @@ int main(int argc, char **argv) {
   std::cout << "Total CC query latency:       " << cc_time.count() << std::endl;
   std::cout << "  Flush Gutters(sec):           " << flush_time.count() << std::endl;
   std::cout << "  Boruvka's Algorithm(sec):     " << cc_alg_time.count() << std::endl;
+  std::cout << "  Boruvka Rounds:               " << cc_alg.last_query_round_times.size()
+            << std::endl;
+  for (size_t i = 0; i < cc_alg.last_query_round_times.size(); i++) {
+    std::cout << "    Round " << i << "(sec):               " << cc_alg.last_query_round_times[i]
+              << std::endl;
+  }
   std::cout << "Connected Components:         " << CC_num << std::endl;
   std::cout << "Maximum Memory Usage(MiB):    " << get_max_mem_used() << std::endl;
-
+  if (!perf_json.empty()) {
+    PerfProfiler::enable(false);
+    PerfProfiler::write_json(perf_json);
+    std::cout << "Hardware counters written to " << perf_json << std::endl;
+  }
+#ifdef ENABLE_TRACING
+  Tracer::enable(false);
+  Tracer::write_chrome_trace("process_stream_trace.json");
+  std::cout << "Timeline written to process_stream_trace.json" << std::endl;
+#endif
 
   cc_start = std::chrono::steady_clock::now();
   driver.prep_query(CONNECTIVITY);
@@ -0,0 +1,57 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "stream_generator.h"
+
+/*
+ * Generates a synthetic binary stream from a random graph model, in parallel.
+ */
+
+int main(int argc, char** argv) {
+  if (argc < 5 || argc > 8) {
+    std::cout << "ERROR: Incorrect number of arguments!" << std::endl;
+    std::cout << "Arguments: output_file model num_vertices num_edges [churn] [delete_fraction] "
+              << "[seed]" << std::endl;
+    std::cout << "model is one of er, rmat or powerlaw. num_edges is the number of edges "
+              << "sampled; duplicates are dropped." << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  std::string output_name = argv[1];
+  std::string model_name = argv[2];
+  GraphModel model;
+  if (model_name == "er")
+    model = ERDOS_RENYI;
+  else if (model_name == "rmat")
+    model = RMAT;
+  else if (model_name == "powerlaw")
+    model = POWER_LAW;
+  else {
+    std::cerr << "ERROR: Unknown model " << model_name << ", expected er, rmat or powerlaw"
+              << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  auto config = StreamGeneratorConfiguration()
+                    .model(model)
+                    .num_vertices(std::stoul(argv[3]))
+                    .num_edges(std::stoull(argv[4]))
+                    .churn(argc >= 6 ? std::stod(argv[5]) : 0)
+                    .delete_fraction(argc >= 7 ? std::stod(argv[6]) : 0)
+                    .seed(argc >= 8 ? std::stoull(argv[7]) : 0);
+  std::cout << config << std::endl;
+
+  auto start = std::chrono::steady_clock::now();
+  StreamGenerator generator(config);
+  std::chrono::duration<double> sample_time = std::chrono::steady_clock::now() - start;
+  std::cout << "Sampling time (sec): " << sample_time.count() << std::endl;
+
+  generator.write_binary_stream(output_name);
+  std::chrono::duration<double> total_time = std::chrono::steady_clock::now() - start;
+  std::cout << "Total time (sec):    " << total_time.count() << std::endl;
+  std::cout << "Distinct edges: " << generator.edges() << ", edges at end: "
+            << generator.final_edges() << std::endl;
+  std::cout << "Total number of updates written to stream: " << generator.updates() << std::endl;
+  std::cout << "Updates per second: " << generator.updates() / total_time.count() << std::endl;
+}